@@ -10,13 +10,43 @@
 
 #include "DetectorConstruction.hh"
 #include "PhysicsList.hh"
+#include "ImportanceWorld.hh"
 #include "ActionInitialization.hh"
+#include "OpticalMapManager.hh"
+#include "OutputWriter.hh"
+#include "ScanManager.hh"
+#include "CheckpointManager.hh"
+#include "ShardManager.hh"
+#include "AdaptiveManager.hh"
+#include "StepProfiler.hh"
+
+#include <cstdlib>
 
 int main(int argc, char** argv)
 {
-  // 1. UI 세션 감지 (터미널 인자가 없으면 GUI 모드로 판단)
+  // 0. 명령행 옵션 해석
+  //   -p, --physics <preset>    : 물리 프리셋 (full, minimal, nooptical)
+  //   --physics-cache <dir|off> : 물리 테이블 캐시 디렉터리 (off면 캐시를 사용하지 않음)
+  //   --preinit <macro>         : /run/initialize 전(PreInit)에 실행할 매크로 (/myApp/physics/ 등)
+  //   -t, --threads <N>         : 배치 모드의 Worker 스레드 수 (기본: 모든 코어)
+  // 나머지 인자는 배치 모드에서 실행할 매크로 파일입니다.
+  G4String physicsPreset = "full";
+  G4String physicsCache = "";
+  G4String preinitMacro = "";
+  G4String macroFile = "";
+  G4int nThreads = 0;
+  for (G4int i = 1; i < argc; ++i) {
+    G4String arg = argv[i];
+    if ((arg == "-p" || arg == "--physics") && i + 1 < argc) physicsPreset = argv[++i];
+    else if (arg == "--physics-cache" && i + 1 < argc) physicsCache = argv[++i];
+    else if (arg == "--preinit" && i + 1 < argc) preinitMacro = argv[++i];
+    else if ((arg == "-t" || arg == "--threads") && i + 1 < argc) nThreads = std::atoi(argv[++i]);
+    else macroFile = arg;
+  }
+
+  // 1. UI 세션 감지 (실행할 매크로가 없으면 GUI 모드로 판단)
   G4UIExecutive* ui = nullptr;
-  if (argc == 1) {
+  if (macroFile.empty()) {
     ui = new G4UIExecutive(argc, argv);
   }
 
@@ -27,30 +57,58 @@ int main(int argc, char** argv)
       (ui) ? G4RunManagerType::SerialOnly : G4RunManagerType::Default
   );
   if (!ui) {
-    runManager->SetNumberOfThreads(G4Threading::G4GetNumberOfCores());
+    runManager->SetNumberOfThreads(nThreads > 0 ? nThreads : G4Threading::G4GetNumberOfCores());
   }
 
   // 3. 스코어링 매니저 활성화
   // 이 객체를 활성화해야 매크로에서 /score/ UI 명령어들을 사용할 수 있습니다.
   G4ScoringManager::GetScoringManager();
 
+  // 광학 모드(full/build/fast) 관리자 생성
+  // Master 스레드에서 미리 생성해야 /myApp/optics/ 명령어를 매크로에서 사용할 수 있습니다.
+  OpticalMapManager::Instance();
+  // 비동기 출력 관리자도 같은 이유로 미리 생성합니다. (/myApp/writer/)
+  OutputWriter::Instance();
+  // 프로세스 내 스캔 드라이버 (/myApp/scan/)
+  ScanManager::Instance();
+  // 체크포인트/재개 드라이버 (/myApp/checkpoint/)
+  CheckpointManager::Instance();
+  // 프로세스 간 shard 실행 (/myApp/shard/)
+  ShardManager::Instance();
+  // 목표 정밀도까지의 적응형 런 길이 (/myApp/adaptive/)
+  AdaptiveManager::Instance();
+  // 볼륨 × 입자 × 프로세스별 스텝 프로파일 (/myApp/profile/)
+  StepProfiler::Instance();
+
   // 4. 시각화 관리자 생성 및 초기화
   G4VisManager* visManager = new G4VisExecutive;
   visManager->Initialize();
 
   // 5. 필수 사용자 클래스들을 RunManager에 등록
-  runManager->SetUserInitialization(new DetectorConstruction());
-  runManager->SetUserInitialization(new PhysicsList());
-  runManager->SetUserInitialization(new ActionInitialization());
+  // 물리 모듈은 RunManager에 등록되기 전에만 조립할 수 있으므로, 프리셋 옵션과 PreInit 매크로를
+  // 먼저 적용한 뒤 ConstructPreset()으로 모듈을 등록합니다.
+  G4UImanager* UImanager = G4UImanager::GetUIpointer();
+  auto* detector = new DetectorConstruction();
+  runManager->SetUserInitialization(detector);
+  auto* physicsList = new PhysicsList(physicsPreset);
+  if (physicsCache == "off") physicsList->SetCacheEnabled(false);
+  else if (!physicsCache.empty()) physicsList->SetCacheDirectory(physicsCache);
+  if (!preinitMacro.empty()) {
+    UImanager->ApplyCommand("/control/execute " + preinitMacro);
+  }
+  physicsList->ConstructPreset();
+  // 감마 중요도 편향의 셀은 병렬 세계에 있으므로, 초기화 전에 검출기 구성에 등록합니다. (/myApp/physics/importance)
+  if (physicsList->IsImportanceBiasingEnabled()) {
+    detector->RegisterParallelWorld(new ImportanceWorld(detector, physicsList->GetImportanceSettings()));
+  }
+  runManager->SetUserInitialization(physicsList);
+  runManager->SetUserInitialization(new ActionInitialization(physicsList->IsImportanceBiasingEnabled()));
   
   // 6. Geant4 커널 초기화
   // 이 함수가 호출된 이후에야 /run/beamOn, /gps/... 등의 명령어를 사용할 수 있습니다.
   runManager->Initialize();
 
-  // 7. UI 관리자 포인터 가져오기
-  G4UImanager* UImanager = G4UImanager::GetUIpointer();
-
-  // 8. 실행 모드에 따라 적절한 매크로 실행
+  // 7. 실행 모드에 따라 적절한 매크로 실행
   if (ui) {
     // ## 인터랙티브(GUI) 모드 ##
     UImanager->ApplyCommand("/control/execute init_vis_angular.mac");
@@ -60,10 +118,12 @@ int main(int argc, char** argv)
   else {
     // ## 배치 모드 ##
     G4String command = "/control/execute ";
-    G4String fileName = argv[1]; // 터미널에서 두 번째 인자로 받은 파일 이름
-    UImanager->ApplyCommand(command + fileName);
+    UImanager->ApplyCommand(command + macroFile);
   }
 
+  // 8. 이번 실행에서 새로 계산한 물리 테이블을 캐시에 저장 (다음 실행의 시작 시간 단축)
+  physicsList->StorePhysicsTableCache();
+
   // 9. 프로그램 종료 전 메모리 해제
   delete visManager;
   delete runManager;
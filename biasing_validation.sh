@@ -0,0 +1,87 @@
+#!/bin/bash
+
+# =============================================================
+# 편향 검증 (방향 강제, 중요도 편향)
+# =============================================================
+# biasing_validation.mac으로 편향 없는 런과 방향 강제 런을 실행한 뒤 다음을 비교합니다.
+#   1) 'W(theta)' 줄의 가중 동시계수율: pull = (r_forced - r_unbiased) / sqrt(σ_f² + σ_u²)
+#   2) EventSummary의 가중 visibleEnergy_MeV 스펙트럼 (유닛별): ROOT Chi2Test("WW")의 p-value
+# 이어서 중요도 편향(PreInit 전용이므로 별도 프로세스)으로 biasing_importance.mac을 실행하고
+#   3) Hits의 weight로 가중한 energyDeposit_MeV 스펙트럼 (유닛별, 이벤트당): 편향 없는 스텝 기록 런과 Chi2Test("WW")
+# 를 비교합니다. 중요도 편향에서는 이벤트 단위 양(W(θ), EventSummary 에너지)이 꺼지므로 스텝 단위로만 비교합니다.
+# pull의 절댓값이 3을 넘거나 p-value가 0.001보다 작으면 FAIL을 출력합니다.
+
+BUILD_DIR="./build"
+EXECUTABLE="./CPNR_OMEG_colab_low_energy_optical"
+LOG_FILE="biasing_validation.log"
+# biasing_validation.mac의 /run/beamOn 값과 같아야 합니다. (스펙트럼을 이벤트당으로 정규화)
+UNBIASED_EVENTS=2000000
+FORCED_EVENTS=100000
+# biasing_validation.mac의 3) 런과 biasing_importance.mac의 /run/beamOn 값
+STEPS_EVENTS=200000
+IMPORTANCE_EVENTS=200000
+
+(cd "${BUILD_DIR}" && ${EXECUTABLE} biasing_validation.mac > "${LOG_FILE}" 2>&1) || {
+  echo "Simulation failed, see ${BUILD_DIR}/${LOG_FILE}"
+  exit 1
+}
+
+# 중요도 편향 설정 (PreInit 매크로)
+cat > "${BUILD_DIR}/biasing_importance_preinit.mac" <<MAC
+/myApp/physics/importance true
+/myApp/physics/importanceShells 3
+/myApp/physics/importanceRatio 2
+/myApp/physics/importanceRadius 15 cm
+MAC
+(cd "${BUILD_DIR}" && ${EXECUTABLE} --preinit biasing_importance_preinit.mac biasing_importance.mac > biasing_importance.log 2>&1) || {
+  echo "Importance-biased simulation failed, see ${BUILD_DIR}/biasing_importance.log"
+  exit 1
+}
+rm "${BUILD_DIR}/biasing_importance_preinit.mac"
+
+echo "===== Weighted coincidence rates (unbiased vs forced) ====="
+# 매크로의 두 런이 차례로 출력하므로, 쌍별 첫 번째 줄이 편향 없는 런입니다.
+grep '^W(theta)' "${BUILD_DIR}/${LOG_FILE}" | awk '
+{
+  for (i = 2; i <= NF; ++i) { split($i, kv, "="); v[kv[1]] = kv[2] }
+  # 세 번째 런(스텝 기록 기준 런)의 줄은 비교하지 않습니다.
+  if (++seen[v["pair"]] > 2) next
+  if (!(v["pair"] in rate)) { rate[v["pair"]] = v["rate"]; err[v["pair"]] = v["rateErr"]; next }
+  sigma = sqrt(err[v["pair"]]^2 + v["rateErr"]^2)
+  pull = sigma > 0 ? (v["rate"] - rate[v["pair"]]) / sigma : 0
+  status = (pull > 3 || pull < -3) ? "FAIL" : "ok"
+  printf "pair %-5s unbiased %.4e +- %.1e  forced %.4e +- %.1e  pull %+.2f  %s\n",
+         v["pair"], rate[v["pair"]], err[v["pair"]], v["rate"], v["rateErr"], pull, status
+}'
+
+echo "===== Weighted visible energy spectra ====="
+(cd "${BUILD_DIR}" && root -l -b -q -e '
+  TFile u("biasing_unbiased.root"), f("biasing_forced.root");
+  auto tu = static_cast<TTree*>(u.Get("EventSummary"));
+  auto tf = static_cast<TTree*>(f.Get("EventSummary"));
+  for (int unit = 0; unit < 2; ++unit) {
+    TH1D hu(Form("hu%d", unit), "", 75, 0., 1.5), hf(Form("hf%d", unit), "", 75, 0., 1.5);
+    hu.Sumw2(); hf.Sumw2();
+    tu->Project(hu.GetName(), "visibleEnergy_MeV", Form("weight*(detectorID==%d)", unit));
+    tf->Project(hf.GetName(), "visibleEnergy_MeV", Form("weight*(detectorID==%d)", unit));
+    hu.Scale(1. / '"${UNBIASED_EVENTS}"'); hf.Scale(1. / '"${FORCED_EVENTS}"');
+    const double p = hu.Chi2Test(&hf, "WW");
+    printf("unit %d  integral unbiased %.4e forced %.4e  chi2 p-value %.3g  %s\n",
+           unit, hu.Integral(), hf.Integral(), p, p < 1e-3 ? "FAIL" : "ok");
+  }')
+
+echo "===== Weighted step energy deposit spectra (unbiased vs importance) ====="
+(cd "${BUILD_DIR}" && root -l -b -q -e '
+  TFile u("biasing_unbiased_steps.root"), f("biasing_importance.root");
+  auto tu = static_cast<TTree*>(u.Get("Hits"));
+  auto tf = static_cast<TTree*>(f.Get("Hits"));
+  for (int unit = 0; unit < 2; ++unit) {
+    TH1D hu(Form("su%d", unit), "", 70, 0., 1.4), hf(Form("sf%d", unit), "", 70, 0., 1.4);
+    hu.Sumw2(); hf.Sumw2();
+    tu->Project(hu.GetName(), "energyDeposit_MeV", Form("weight*(detectorID==%d)", unit));
+    tf->Project(hf.GetName(), "energyDeposit_MeV", Form("weight*(detectorID==%d)", unit));
+    hu.Scale(1. / '"${STEPS_EVENTS}"'); hf.Scale(1. / '"${IMPORTANCE_EVENTS}"');
+    const double p = hu.Chi2Test(&hf, "WW");
+    printf("unit %d  steps per event unbiased %.4e importance %.4e  chi2 p-value %.3g  %s\n",
+           unit, hu.Integral(), hf.Integral(), p, p < 1e-3 ? "FAIL" : "ok");
+  }')
@@ -2,6 +2,7 @@
 #define ActionInitialization_h 1
 
 #include "G4VUserActionInitialization.hh"
+#include "globals.hh"
 
 /**
  * @class ActionInitialization
@@ -9,15 +10,19 @@
  *
  * Geant4의 멀티스레딩(MT) 모드에서 Master 스레드와 Worker 스레드에 각각 필요한
  * Action 클래스들을 적절히 배분하는 중요한 역할을 담당합니다.
+ * 감마 중요도 편향 여부는 물리 리스트에서 받아 RunAction에 넘깁니다.
  */
 class ActionInitialization : public G4VUserActionInitialization
 {
 public:
-  ActionInitialization();
+  explicit ActionInitialization(G4bool importanceBiasing = false);
   virtual ~ActionInitialization();
 
   virtual void BuildForMaster() const override;
   virtual void Build() const override;
+
+private:
+  G4bool fImportanceBiasing;
 };
 
 #endif
@@ -0,0 +1,65 @@
+#ifndef AdaptiveManager_h
+#define AdaptiveManager_h 1
+
+#include "globals.hh"
+
+class G4GenericMessenger;
+class Run;
+
+/**
+ * @class AdaptiveManager
+ * @brief 목표 통계 정밀도에 도달할 때까지 이벤트를 묶음(batch)으로 처리하는 적응형 런 길이 싱글톤입니다.
+ *
+ * 고정된 /run/beamOn 100000은 180° 근처나 짧은 거리의 점에서는 필요 이상이고, 30 cm 점에서는 부족합니다.
+ * 적응형 런은 묶음마다 BeamOn을 호출하고, 모든 Worker가 병합된 Master Run의 카운터를 누적한 뒤
+ * 동시계수율의 상대 오차 σ_r/r = sqrt((1 - r)/(r N))를 계산합니다. 모든 PMT 쌍 중 가장 나쁜 값이
+ * 목표 이하가 되거나 이벤트 상한에 도달하면 멈춥니다. includeGated를 켜면 에너지 창 안의 동시계수와
+ * 유닛별 에너지 창 계수(스펙트럼 창)도 같은 목표를 만족해야 합니다.
+ *
+ * 묶음마다 출력 파일(<이름>_part<k>)을 닫으며 eventID는 점 안의 전역 번호입니다. (cpnr_merge로 합칩니다)
+ * Master 엔진은 묶음 사이에도 이어지므로, N 이벤트에서 멈춘 결과는 한 번에 N 이벤트를 실행한 결과와 같습니다.
+ * 다음 묶음 크기는 지금까지의 오차로 예측한 필요 이벤트 수를 따르되, 과도하게 넘치지 않도록
+ * 한 번에 누적 이벤트 수의 두 배를 넘지 않게 합니다.
+ * 설정은 Master의 싱글톤에만 있으므로, main()에서 RunManager 초기화 전에 Instance()를 한 번 호출합니다.
+ */
+class AdaptiveManager
+{
+public:
+  struct Result {
+    G4int events = 0;
+    G4int batches = 0;
+    G4long coincidences = 0;     // 모든 PMT 쌍의 동시계수 합
+    G4double coincidenceWeight = 0.;   // 같은 동시계수의 이벤트 가중치 합과 제곱합 (편향이 없으면 계수와 같음)
+    G4double coincidenceWeight2 = 0.;
+    G4double relativeError = 0.; // 가장 나쁜 상대 오차
+    G4bool converged = false;
+  };
+
+  static AdaptiveManager* Instance();
+  ~AdaptiveManager();
+
+  // /myApp/adaptive/targetRelError > 0 이면 스캔 점도 적응형으로 실행합니다.
+  G4bool IsEnabled() const { return fTargetRelError > 0.; }
+  // 한 점을 목표 정밀도 또는 이벤트 상한까지 실행합니다. 출력은 <baseName>_part<k>입니다.
+  Result RunPoint(const G4String& baseName);
+
+private:
+  AdaptiveManager();
+  void DefineCommands();
+  void RunAdaptive();
+
+  G4double RelativeError(const Run& total) const;
+  G4int NextBatchSize(G4int processed, G4double relativeError) const;
+
+  static AdaptiveManager* fgInstance;
+
+  G4double fTargetRelError;
+  G4int fBatchEvents;
+  G4int fMinEvents;
+  G4int fMaxEvents;
+  G4bool fIncludeGated;
+
+  G4GenericMessenger* fMessenger;
+};
+
+#endif
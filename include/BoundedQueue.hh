@@ -0,0 +1,112 @@
+#ifndef BoundedQueue_h
+#define BoundedQueue_h 1
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @class BoundedQueue
+ * @brief 고정 크기 링 버퍼 기반의 lock-free 다중 생산자/다중 소비자 큐입니다.
+ *
+ * 각 칸(cell)의 순번(sequence)으로 칸의 상태를 판별하는 방식(D. Vyukov의 bounded MPMC queue)이므로
+ * 뮤텍스 없이 원자적 비교-교환 한 번으로 넣고 뺍니다. 용량은 2의 거듭제곱으로 올림합니다.
+ * TryPush/TryPop은 기다리지 않고 즉시 실패를 반환하므로, 대기(backpressure) 정책은 호출하는 쪽이 정합니다.
+ */
+template <typename T>
+class BoundedQueue
+{
+public:
+  explicit BoundedQueue(size_t capacity)
+  {
+    size_t size = 2;
+    while (size < capacity) size <<= 1;
+    fMask = size - 1;
+    fCells = std::vector<Cell>(size);
+    for (size_t i = 0; i < size; ++i) fCells[i].sequence.store(i, std::memory_order_relaxed);
+    fEnqueuePos.store(0, std::memory_order_relaxed);
+    fDequeuePos.store(0, std::memory_order_relaxed);
+  }
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  size_t Capacity() const { return fMask + 1; }
+
+  // 대략적인 현재 깊이 (다른 스레드가 동시에 넣고 빼는 중이면 근사값)
+  size_t SizeApprox() const
+  {
+    size_t enqueue = fEnqueuePos.load(std::memory_order_relaxed);
+    size_t dequeue = fDequeuePos.load(std::memory_order_relaxed);
+    return enqueue > dequeue ? enqueue - dequeue : 0;
+  }
+
+  bool TryPush(const T& value)
+  {
+    size_t pos = fEnqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = fCells[pos & fMask];
+      size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+      if (diff == 0) {
+        if (fEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          cell.value = value;
+          cell.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (diff < 0) {
+        return false; // 가득 참
+      }
+      else {
+        pos = fEnqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool TryPop(T& value)
+  {
+    size_t pos = fDequeuePos.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = fCells[pos & fMask];
+      size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+      if (diff == 0) {
+        if (fDequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          value = cell.value;
+          cell.sequence.store(pos + fMask + 1, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (diff < 0) {
+        return false; // 비어 있음
+      }
+      else {
+        pos = fDequeuePos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T value;
+
+    Cell() : sequence(0), value() {}
+    Cell(Cell&& other) noexcept : sequence(other.sequence.load(std::memory_order_relaxed)), value(other.value) {}
+    Cell& operator=(Cell&& other) noexcept
+    {
+      sequence.store(other.sequence.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      value = other.value;
+      return *this;
+    }
+  };
+
+  // 생산자와 소비자의 위치가 같은 캐시 라인을 두고 경합하지 않도록 떨어뜨려 둡니다.
+  alignas(64) std::vector<Cell> fCells;
+  size_t fMask;
+  alignas(64) std::atomic<size_t> fEnqueuePos;
+  alignas(64) std::atomic<size_t> fDequeuePos;
+};
+
+#endif
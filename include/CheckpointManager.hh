@@ -0,0 +1,70 @@
+#ifndef CheckpointManager_h
+#define CheckpointManager_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+class G4GenericMessenger;
+class Run;
+
+/**
+ * @class CheckpointManager
+ * @brief 긴 생산 런을 여러 구간(segment)으로 나누어 실행하고, 구간마다 체크포인트를 남기는 싱글톤입니다.
+ *
+ * 한 번의 /run/beamOn은 EndOfRunAction에서만 파일을 닫으므로, 도중에 작업이 중단되면 결과가 모두 사라집니다.
+ * 체크포인트 런은 전체 이벤트를 N 이벤트(또는 약 M분) 구간으로 나누어 구간마다 BeamOn을 호출합니다.
+ * 구간이 끝나면 그 구간의 출력 파일(<이름>_part<k>)은 이미 닫혀 일관된 상태이며, 이어서 다음을 기록합니다.
+ *   - Master 난수 엔진 상태: MT RunManager는 이벤트마다 Worker 시드를 Master 엔진에서 순서대로 뽑으므로,
+ *     이 상태가 이후 모든 Worker의 난수열을 정합니다.
+ *   - 다음 이벤트 번호와 구간 번호, 완료된 출력 파일 목록
+ *   - 지금까지 병합된 Run 카운터 (단일 계수, 동시계수, 트리거, 광자 제거 통계)
+ * 모든 내용은 한 텍스트 파일에 담기며, 임시 파일에 쓴 뒤 rename하므로, 쓰는 도중 중단되어도 이전 체크포인트가 남습니다.
+ *
+ * resume은 체크포인트를 읽어 엔진 상태와 카운터를 복원하고 다음 구간부터 이어서 실행합니다.
+ * 이벤트 e의 시드는 구간을 어떻게 나누든 Master 엔진에서 같은 순서로 뽑히므로, 중단 후 재개한 결과는
+ * 중단 없이 같은 시드로 실행한 결과와 이벤트 단위로 같습니다. 기록되는 eventID는 전역 번호입니다.
+ * 설정은 Master의 싱글톤에만 있으므로, main()에서 RunManager 초기화 전에 Instance()를 한 번 호출합니다.
+ */
+class CheckpointManager
+{
+public:
+  static CheckpointManager* Instance();
+  ~CheckpointManager();
+
+private:
+  CheckpointManager();
+  void DefineCommands();
+
+  void Start();
+  void Resume();
+  // fNextEvent부터 fTotalEvents까지 남은 구간을 실행합니다.
+  void RunSegments();
+  // 다음 구간의 이벤트 수 (이벤트 간격과 시간 간격 중 먼저 도달하는 쪽)
+  G4int NextSegmentSize(G4double eventsPerSecond) const;
+
+  G4bool WriteCheckpoint() const;
+  G4bool ReadCheckpoint();
+
+  static CheckpointManager* fgInstance;
+
+  // --- 설정 (/myApp/checkpoint/) ---
+  G4int fEvents;           // 전체 이벤트 수
+  G4int fEventInterval;    // 구간당 최대 이벤트 수 (0 = 제한 없음)
+  G4double fMinutes;       // 구간당 목표 시간 (분, 0 = 제한 없음)
+  G4long fSeed;            // 새로 시작할 때의 Master 시드
+  G4String fCheckpointFile;
+
+  // --- 진행 상태 (체크포인트에 기록) ---
+  G4int fTotalEvents;
+  G4int fNextEvent;
+  G4int fSegment;
+  G4bool fComplete;
+  G4String fOutputPrefix;
+  std::vector<G4String> fParts;  // 완료된 구간의 출력 파일
+  Run* fTotal;                   // 완료된 구간들의 병합 카운터
+
+  G4GenericMessenger* fMessenger;
+};
+
+#endif
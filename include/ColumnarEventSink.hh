@@ -0,0 +1,33 @@
+#ifndef ColumnarEventSink_h
+#define ColumnarEventSink_h 1
+
+#include "EventSink.hh"
+#include "ColumnarFile.hh"
+
+/**
+ * @class ColumnarEventSink
+ * @brief EventRecord를 열 단위 mmap 형식(ColumnarFile.hh)으로 기록합니다.
+ *
+ * 테이블과 열 이름은 ROOT 출력의 Hits, EventSummary, PMTHits, PMTSummary와 같습니다.
+ * 고정 폭 열만 지원하므로 PMTSummary의 도달 시간 히스토그램(timeHist)은 기록하지 않습니다.
+ * 이름 코드 사전은 footer에 함께 저장됩니다.
+ */
+class ColumnarEventSink : public EventSink
+{
+public:
+  ColumnarEventSink();
+  virtual ~ColumnarEventSink();
+
+  virtual G4bool Open(const G4String& fileName) override;
+  virtual void Write(const EventRecord& record) override;
+  virtual void Close(const std::vector<G4String>& dictionary) override;
+
+private:
+  columnar::Writer fWriter;
+  std::size_t fHitsTable;
+  std::size_t fSummaryTable;
+  std::size_t fPMTHitsTable;
+  std::size_t fPMTSummaryTable;
+};
+
+#endif
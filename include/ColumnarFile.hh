@@ -0,0 +1,186 @@
+#ifndef ColumnarFile_h
+#define ColumnarFile_h 1
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * @namespace columnar
+ * @brief 시뮬레이션 출력용 열(column) 단위 바이너리 형식과, 이를 쓰고 mmap으로 읽는 작은 라이브러리입니다.
+ *
+ * Geant4와 ROOT에 의존하지 않으므로 오프라인 분석 코드에서 cpnr_columnar 라이브러리만 링크해 사용합니다.
+ *
+ * 파일 구조 (리틀 엔디언):
+ *   [magic 8바이트]
+ *   [청크 데이터: 테이블별로 최대 rowsPerChunk 행씩, 열마다 고정 폭 값의 연속 배열, 8바이트 정렬]
+ *   [footer: 테이블 목록(이름, 열 이름/형식, 청크별 행 수와 열 오프셋) + 이름 코드 사전]
+ *   [footer 크기 uint64][magic 8바이트]
+ *
+ * 열 데이터는 파일 안에서 8바이트 정렬되어 있고 mmap 주소는 페이지 정렬이므로,
+ * Reader는 역직렬화 없이 파일 내용을 그대로 int32_t/double 배열로 돌려줍니다.
+ */
+namespace columnar
+{
+
+constexpr char kMagic[8] = {'C', 'P', 'N', 'R', 'C', 'O', 'L', '1'};
+
+enum class ColumnType : std::uint32_t { kInt32 = 1, kFloat64 = 2 };
+
+std::size_t SizeOf(ColumnType type);
+
+template <typename T> struct TypeOf;
+template <> struct TypeOf<std::int32_t> { static constexpr ColumnType value = ColumnType::kInt32; };
+template <> struct TypeOf<double> { static constexpr ColumnType value = ColumnType::kFloat64; };
+
+struct ColumnSpec {
+  std::string name;
+  ColumnType type;
+};
+
+/**
+ * @class Writer
+ * @brief 행을 열별 버퍼에 모았다가 rowsPerChunk 행마다 한 청크로 기록합니다.
+ * Append는 열 형식을 검사하지 않으므로(assert만), 호출하는 쪽이 스키마와 같은 형식으로 넣어야 합니다.
+ */
+class Writer
+{
+public:
+  explicit Writer(std::size_t rowsPerChunk = 65536);
+  ~Writer();
+
+  Writer(const Writer&) = delete;
+  Writer& operator=(const Writer&) = delete;
+
+  bool Open(const std::string& fileName);
+  // 첫 행을 넣기 전에 모든 테이블을 정의합니다. 반환값은 테이블 번호입니다.
+  std::size_t AddTable(const std::string& name, const std::vector<ColumnSpec>& columns);
+
+  void Append(std::size_t table, std::size_t column, std::int32_t value);
+  void Append(std::size_t table, std::size_t column, double value);
+  void EndRow(std::size_t table);
+
+  void SetDictionary(const std::vector<std::string>& names) { fDictionary = names; }
+  // 남은 행을 기록하고 footer를 쓴 뒤 파일을 닫습니다.
+  bool Close();
+
+private:
+  struct Chunk {
+    std::uint64_t rows;
+    std::vector<std::uint64_t> offsets;   // 열별 파일 오프셋
+  };
+  struct TableState {
+    std::string name;
+    std::vector<ColumnSpec> columns;
+    std::vector<std::vector<char>> buffers; // 열별 아직 기록하지 않은 값
+    std::size_t pendingRows = 0;
+    std::vector<Chunk> chunks;
+  };
+
+  void FlushChunk(TableState& table);
+  void WriteBytes(const void* data, std::size_t size);
+  void WritePadding();
+
+  std::FILE* fFile;
+  std::uint64_t fOffset;
+  std::size_t fRowsPerChunk;
+  bool fGood;
+  std::vector<TableState> fTables;
+  std::vector<std::string> fDictionary;
+};
+
+/**
+ * @class ColumnView
+ * @brief mmap된 파일 안의 한 열 청크를 가리키는 읽기 전용 배열 뷰입니다. (복사 없음)
+ */
+template <typename T>
+class ColumnView
+{
+public:
+  ColumnView() : fData(nullptr), fSize(0) {}
+  ColumnView(const T* data, std::size_t size) : fData(data), fSize(size) {}
+
+  const T* begin() const { return fData; }
+  const T* end() const { return fData + fSize; }
+  const T* data() const { return fData; }
+  std::size_t size() const { return fSize; }
+  bool empty() const { return fSize == 0; }
+  const T& operator[](std::size_t i) const { return fData[i]; }
+
+private:
+  const T* fData;
+  std::size_t fSize;
+};
+
+class Table
+{
+public:
+  const std::string& GetName() const { return fName; }
+  std::size_t GetNumberOfColumns() const { return fColumns.size(); }
+  const ColumnSpec& GetColumnSpec(std::size_t column) const { return fColumns[column]; }
+  // 열 이름으로 번호를 찾습니다. 없으면 -1.
+  int FindColumn(const std::string& name) const;
+
+  std::size_t GetNumberOfChunks() const { return fChunkRows.size(); }
+  std::size_t GetChunkRows(std::size_t chunk) const { return fChunkRows[chunk]; }
+  std::uint64_t GetNumberOfRows() const { return fTotalRows; }
+
+  // 청크의 열 데이터. 형식이 맞지 않으면 빈 뷰를 반환합니다.
+  template <typename T>
+  ColumnView<T> GetColumn(std::size_t chunk, std::size_t column) const
+  {
+    if (fColumns[column].type != TypeOf<T>::value) return ColumnView<T>();
+    const char* data = fBase + fOffsets[chunk * fColumns.size() + column];
+    return ColumnView<T>(reinterpret_cast<const T*>(data), fChunkRows[chunk]);
+  }
+
+private:
+  friend class Reader;
+
+  std::string fName;
+  std::vector<ColumnSpec> fColumns;
+  std::vector<std::size_t> fChunkRows;
+  std::vector<std::uint64_t> fOffsets;  // [chunk x nColumns + column]
+  std::uint64_t fTotalRows = 0;
+  const char* fBase = nullptr;
+};
+
+/**
+ * @class Reader
+ * @brief 파일 전체를 읽기 전용으로 mmap하고 footer만 해석합니다. 열 데이터는 필요할 때 페이지 단위로 읽힙니다.
+ */
+class Reader
+{
+public:
+  Reader();
+  ~Reader();
+
+  Reader(const Reader&) = delete;
+  Reader& operator=(const Reader&) = delete;
+
+  bool Open(const std::string& fileName);
+  void Close();
+
+  const Table* GetTable(const std::string& name) const;
+  const std::vector<Table>& GetTables() const { return fTables; }
+  const std::vector<std::string>& GetDictionary() const { return fDictionary; }
+  std::size_t GetFileSize() const { return fSize; }
+  const std::string& GetError() const { return fError; }
+
+private:
+  bool Fail(const std::string& message);
+  bool ParseFooter();
+
+  int fFd;
+  char* fBase;
+  std::size_t fSize;
+  std::vector<Table> fTables;
+  std::vector<std::string> fDictionary;
+  std::string fError;
+};
+
+} // namespace columnar
+
+#endif
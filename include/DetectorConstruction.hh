@@ -18,10 +18,22 @@ class G4VPhysicalVolume;
 class G4LogicalVolume;
 class G4Material;
 
+#include "G4RotationMatrix.hh"
+
+#include <vector>
+
 /**
  * @class DetectorConstruction
  * @brief 시뮬레이션 환경의 모든 물질과 기하학적 구조를 생성하는 클래스.
  *        UI 커맨드를 통해 런타임에 검출기 각도와 거리를 동적으로 변경할 수 있다.
+ *
+ *        지오메트리는 한 번만 만든다. 이후 각도/거리를 바꾸면 두 검출기 유닛 placement의
+ *        회전과 위치만 제자리에서 갱신하고, 두 유닛의 어미 볼륨(World)의 voxel만 다시 최적화한다.
+ *        논리 볼륨, SD, 광학 표면은 그대로 재사용되므로 반복된 /run/beamOn 사이에 객체가 새로 만들어지지 않는다.
+ *
+ *        링 모드(/myApp/detector/setRingAngles)에서는 N개의 검출기 유닛을 선원 둘레의 XZ 평면에
+ *        지정한 각도로 배치한다. 유닛 i의 copy number는 i이며 PMT 번호도 유닛 번호와 같으므로,
+ *        한 번의 런에서 모든 유닛 쌍의 사잇각에 대한 동시계수를 얻는다.
  */
 class DetectorConstruction : public G4VUserDetectorConstruction
 {
@@ -39,6 +51,16 @@ public:
     void SetMovablePMTAngle(G4double angle);
     // 매크로에서 /myApp/detector/setDistance 명령어를 사용하면 이 함수가 호출.
     void SetDetectorDistance(G4double distance);
+    // 매크로에서 /myApp/detector/setRingAngles 명령어를 사용하면 이 함수가 호출. ("off"이면 두 유닛 모드)
+    void SetRingAngles(const G4String& angles);
+
+    // 현재 설정된 사잇각과 거리 (Run 요약의 W(θ) 기록에 사용)
+    G4double GetMovablePMTAngle() const { return fMovablePMTAngle; }
+    G4double GetDetectorDistance() const { return fDetectorDistance; }
+    // 유닛별 배치 각도 (+X 축에서 +Z 방향으로). 두 유닛 모드에서는 {0, 사잇각}.
+    std::vector<G4double> GetUnitAngles() const;
+    // 두 유닛이 선원에서 이루는 사잇각 [0, 180°]
+    G4double GetOpeningAngle(G4int unitA, G4int unitB) const;
 
 private:
     // --- Private 도우미 함수 (Helper Methods) ---
@@ -48,6 +70,14 @@ private:
     void DefineOpticalProperties();
     G4LogicalVolume* ConstructDetectorUnit();
     G4LogicalVolume* ConstructPMT();
+
+    // 현재 각도/거리로 검출기 유닛들의 회전과 위치를 설정한다. (placement와 회전 행렬은 재사용하고,
+    // 유닛 수가 바뀐 경우에만 placement를 추가/삭제한다.) 유닛 수가 바뀌었으면 true.
+    G4bool PlaceDetectorUnits();
+    // Setter에서 호출: 지오메트리가 이미 있으면 제자리에서 옮기고 World의 voxel만 다시 최적화한다.
+    void UpdateDetectorPlacement();
+    // /run/reinitializeGeometry 등으로 저장소가 비워져 보관한 포인터가 무효가 되었는지 확인한다.
+    G4bool IsGeometryBuilt() const;
     
     // [!리팩토링 핵심!] UI 커맨드 정의를 위한 전용 함수를 선언.
     // 생성자 로직을 깔끔하게 유지하고, UI 관련 코드를 한 곳에 모아 관리하기 위함.
@@ -61,6 +91,7 @@ private:
     // 지오메트리 제어 변수
     G4double fMovablePMTAngle; // 사잇각 (θ)
     G4double fDetectorDistance;  // 거리 (r): 선원 중심 -> LS 중심
+    std::vector<G4double> fRingAngles; // 링 모드의 유닛별 각도 (비어 있으면 두 유닛 모드)
 
     // --- [리팩토링] Messenger 포인터 교체 ---
     // 기존 DetectorMessenger* 대신 G4GenericMessenger*를 사용합니다.
@@ -71,6 +102,13 @@ private:
     G4LogicalVolume* logicLS;
     G4LogicalVolume* logicPhotocathode;
 
+    // 제자리 재배치를 위해 보관하는 World, 검출기 유닛 논리 볼륨, 유닛별 placement와 회전 행렬
+    G4VPhysicalVolume* fPhysWorld;
+    G4LogicalVolume* fLogicWorld;
+    G4LogicalVolume* fLogicDetectorUnit;
+    std::vector<G4VPhysicalVolume*> fPhysUnits;   // [copy number]
+    std::vector<G4RotationMatrix*> fUnitRotations;
+
 public:
     // --- 지오메트리 상수 정의 (변경 없음) ---
     // static constexpr을 사용하여 컴파일 타임 상수를 정의하는 것은 매우 좋은 현대 C++ 관행.
@@ -100,6 +138,9 @@ public:
     static constexpr G4double kAssemblyTotalLength = 2*kLSHalfZ + 2*kGreaseHalfZ + 2*kPmtAssemblyHalfZ;
     static constexpr G4double kAssemblyHalfZ = kAssemblyTotalLength / 2.0;
     static constexpr G4double kAssemblyCenterOffset = kAssemblyHalfZ - kLSHalfZ;
+    // LS 광학 속성 테이블(방출 스펙트럼)이 정의된 광자 에너지 범위
+    static constexpr G4double kPhotonEnergyMin = 2.38*CLHEP::eV;
+    static constexpr G4double kPhotonEnergyMax = 3.44*CLHEP::eV;
 };
 
 #endif
@@ -3,21 +3,65 @@
 
 #include "G4UserEventAction.hh"
 #include "globals.hh"
+#include "EventRecord.hh"
+
+#include <utility>
+#include <vector>
+
+class LSSD;
+class PMTHit;
+class RunAction;
+class G4Event;
+class G4GenericMessenger;
 
 /**
  * @class EventAction
  * @brief 각 이벤트(Event)의 시작과 끝에서 필요한 작업을 수행하는 클래스입니다.
  *
- * 이벤트가 끝날 때마다 LSHitsCollection과 PMTHitsCollection을 분석하여
- * 정의된 모든 TTree에 데이터를 기록하는 핵심적인 역할을 합니다.
+ * 이벤트가 끝날 때마다 LSSD의 Hit 버퍼와 PMTHitsCollection을 분석하여 EventRecord로 만들고,
+ * 동기 모드에서는 G4 Ntuple에, 비동기 모드에서는 OutputWriter를 통해 기록하는 핵심적인 역할을 합니다.
+ * SD 포인터와 컬렉션 ID는 처음 한 번만 조회하여 보관합니다.
+ * PMT 출력은 광자별 행(PMTHits), PMT별 요약(PMTSummary), 둘 다 또는 끔(none)을 선택할 수 있습니다.
+ * (끄더라도 W(θ) 동시계수는 Run::RecordEvent에서 PMTHitsCollection으로 직접 셉니다.)
+ *
+ * 기록 트리거(/myApp/trigger/)를 켜면, 시간 창 안에서 문턱을 넘은 PMT 수가 majority 이상인 이벤트만
+ * 기록하고 나머지는 Run의 카운터만 올립니다. W(θ) 누적은 트리거와 무관하게 모든 이벤트를 봅니다.
+ * 감마 중요도 편향에서는 트리거를 적용하지 않고 EventSummary의 에너지 열을 -1로 기록합니다. (RunAction::IsImportanceBiasing)
  */
 class EventAction : public G4UserEventAction
 {
 public:
-  EventAction();
+  EventAction(RunAction* runAction);
   virtual ~EventAction();
 
   virtual void EndOfEventAction(const G4Event*) override;
+
+private:
+  void DefineCommands();
+  void SetPMTOutput(const G4String& mode);
+  // 기록 트리거 판정 (트리거가 꺼져 있으면 항상 통과)
+  G4bool PassesTrigger(const G4Event* event);
+  void BuildRecord(const G4Event* event, EventRecord& record);
+  // 이벤트의 PMT Hit을 (PMT, 시간) 순으로 제자리 정렬한 뒤 PMT별 요약 한 행씩 추가합니다.
+  void BuildPMTSummary(std::vector<PMTHit*>& hits, EventRecord& record);
+  void FillNtuples(const EventRecord& record);
+
+  RunAction* fRunAction;
+  G4bool fWriteSteps;                 // 스텝별 Hits TTree 기록 여부
+  G4bool fWritePMTHits;               // 광자별 PMTHits TTree 기록 여부
+  G4bool fWritePMTSummary;            // PMT별 PMTSummary TTree 기록 여부
+  G4int fPMTTimeBins;                 // 도달 시간 히스토그램 bin 수 (0 = 끔)
+  G4double fPMTTimeBinWidth;
+  G4bool fTriggerEnabled;             // 기록 트리거 사용 여부
+  G4double fTriggerPEThreshold;       // PMT 트리거 문턱 (가중 광전자 수)
+  G4double fTriggerWindow;            // majority 판정 시간 창
+  G4int fTriggerMajority;             // 시간 창 안에서 필요한 트리거 PMT 수
+  LSSD* fLSSD;                        // 같은 스레드의 LSSD (최초 이벤트에서 조회)
+  G4int fPMTHcID;                     // PMTHitsCollection ID (-1 = 아직 조회 전)
+  std::vector<std::pair<G4int, G4int>> fTrackKeys; // (유닛, 부호 있는 트랙 ID) 작업 버퍼 (이벤트 간 재사용)
+  EventRecord fRecord;                // 동기 모드에서 재사용하는 레코드
+  G4GenericMessenger* fMessenger;
+  G4GenericMessenger* fTriggerMessenger;
 };
 
 #endif
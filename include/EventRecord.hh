@@ -0,0 +1,72 @@
+#ifndef EventRecord_h
+#define EventRecord_h 1
+
+#include "globals.hh"
+#include "LSHitBuffer.hh"
+
+#include <vector>
+
+/**
+ * @struct EventRecord
+ * @brief 한 이벤트에서 출력할 모든 행(row)을 담는 재사용 가능한 레코드입니다.
+ *
+ * EventAction이 이벤트 종료 시 채우며, 동기 모드에서는 곧바로 G4 Ntuple로,
+ * 비동기 모드에서는 OutputWriter의 큐를 거쳐 쓰기 스레드의 EventSink로 전달됩니다.
+ * Clear()는 용량을 유지하므로, 레코드를 풀(pool)에서 재사용하면 정상 상태에서 할당이 없습니다.
+ * 단위는 Ntuple과 같이 mm, ns, MeV입니다.
+ */
+struct EventRecord
+{
+  // EventSummary TTree의 한 행 (증착이 있는 유닛마다)
+  struct UnitRow {
+    G4int detectorID;
+    G4int nPrimaries;
+    G4int nSecondaries;
+    G4double edep;
+    G4double visibleEnergy;
+    G4double centroidX, centroidY, centroidZ;
+    G4double firstTime;
+    G4double weight;     // 이벤트 가중치 x 증착의 에너지 가중 평균 트랙 가중치 (편향이 없으면 1)
+  };
+
+  // PMTHits TTree의 한 행 (광전자마다)
+  struct PMTHitRow {
+    G4int pmtID;
+    G4double time;
+    G4double weight;
+  };
+
+  // PMTSummary TTree의 한 행 (PMT마다). 히스토그램은 pmtTimeHist에 행 순서대로 이어 붙입니다.
+  struct PMTSummaryRow {
+    G4int pmtID;
+    G4int nPE;
+    G4double weightedPE;
+    G4double firstTime, medianTime, lastTime;
+  };
+
+  G4int eventID = -1;
+  LSHitBuffer steps;                        // Hits TTree (writeSteps가 꺼져 있으면 비어 있음)
+  std::vector<UnitRow> units;
+  std::vector<PMTHitRow> pmtHits;
+  std::vector<PMTSummaryRow> pmtSummaries;
+  G4int pmtTimeBins = 0;
+  std::vector<G4double> pmtTimeHist;        // [행 x pmtTimeBins + bin]
+
+  void Clear()
+  {
+    eventID = -1;
+    steps.Clear();
+    units.clear();
+    pmtHits.clear();
+    pmtSummaries.clear();
+    pmtTimeBins = 0;
+    pmtTimeHist.clear();
+  }
+
+  G4bool IsEmpty() const
+  {
+    return steps.Size() == 0 && units.empty() && pmtHits.empty() && pmtSummaries.empty();
+  }
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef EventSink_h
+#define EventSink_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+struct EventRecord;
+
+/**
+ * @class EventSink
+ * @brief OutputWriter의 쓰기 스레드가 EventRecord를 기록하는 출력 형식의 공통 인터페이스입니다.
+ *
+ * Open/Close는 Master 스레드가, Write/EndBatch는 쓰기 스레드가 호출하지만 서로 겹치지 않으므로
+ * 구현은 스레드 안전할 필요가 없습니다.
+ */
+class EventSink
+{
+public:
+  virtual ~EventSink() {}
+
+  virtual G4bool Open(const G4String& fileName) = 0;
+  virtual void Write(const EventRecord& record) = 0;
+  // 한 묶음(batch)을 다 쓴 뒤 호출됩니다. 버퍼를 비우는 시점을 구현이 정할 수 있습니다.
+  virtual void EndBatch() {}
+  // Run 종료 시 이름 코드 사전을 기록하고 파일을 닫습니다.
+  virtual void Close(const std::vector<G4String>& dictionary) = 0;
+};
+
+#endif
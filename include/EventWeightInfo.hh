@@ -0,0 +1,34 @@
+#ifndef EventWeightInfo_h
+#define EventWeightInfo_h 1
+
+#include "G4VUserEventInformation.hh"
+#include "globals.hh"
+
+class G4Event;
+
+/**
+ * @class EventWeightInfo
+ * @brief 편향된 1차 입자 생성(방향 강제)의 이벤트 가중치를 담는 사용자 이벤트 정보입니다.
+ *
+ * PrimaryGeneratorAction이 실제 확률 밀도와 편향된 밀도의 비를 이벤트에 붙이고,
+ * Run(단일 계수/동시계수)과 EventAction(EventSummary의 weight 열)이 읽습니다.
+ * 트랙 가중치와 달리 광전자 가중치(솎아내기 보정)에 곱해지지 않으므로 PMT 트리거 문턱 판정은 바뀌지 않습니다.
+ */
+class EventWeightInfo : public G4VUserEventInformation
+{
+public:
+  explicit EventWeightInfo(G4double weight);
+  virtual ~EventWeightInfo();
+
+  virtual void Print() const override;
+
+  G4double GetWeight() const { return fWeight; }
+
+  // 이벤트의 가중치 (EventWeightInfo가 없으면 1)
+  static G4double EventWeight(const G4Event* event);
+
+private:
+  G4double fWeight;
+};
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef ImportanceWorld_h
+#define ImportanceWorld_h 1
+
+#include "G4VUserParallelWorld.hh"
+#include "G4SystemOfUnits.hh"
+#include "globals.hh"
+
+#include <vector>
+
+class DetectorConstruction;
+class G4LogicalVolume;
+class G4VPhysicalVolume;
+
+/**
+ * @class ImportanceWorld
+ * @brief 감마 중요도 편향(importance biasing)에 쓰는 병렬 세계(parallel world)입니다.
+ *
+ * 검출기 유닛마다 LS 중심에 겹겹이 포개진 구 껍질(cell)을 두고, 안쪽 껍질일수록 중요도를 ratio배씩 높입니다.
+ * (병렬 세계의 나머지 = 1, 가장 바깥 껍질 = ratio, ..., 가장 안쪽 = ratio^shells)
+ * G4ImportanceBiasing은 감마가 중요도가 높은 껍질로 들어가면 트랙을 나누고(splitting),
+ * 낮은 껍질로 나가면 러시안 룰렛으로 줄이며, 트랙 가중치를 그만큼 조정합니다.
+ * 가장 안쪽 껍질은 LS 병을 감싸는 구이므로, 검출기로 향하는 감마의 상호작용이 여러 번 표본화됩니다.
+ *
+ * 껍질은 질량 세계와 독립이므로 검출기를 옮기면(/myApp/detector/...) DetectorConstruction이
+ * PlaceCells()를 호출해 껍질도 같은 위치로 옮깁니다. 바깥 껍질 placement는 유닛 번호를 copy number로 가지며,
+ * 안쪽 껍질은 논리 볼륨 안에 한 번만 배치되므로 모든 유닛이 같은 G4IStore 항목을 공유합니다.
+ * 중요도 저장소는 placement가 처음 만들어질 때 한 번만 등록합니다. (유닛 수가 줄면 placement를 지우지 않고 떼어 둠)
+ */
+class ImportanceWorld : public G4VUserParallelWorld
+{
+public:
+  // /myApp/physics/importance* 명령어로 PreInit에서 정합니다. (PhysicsList가 보관)
+  struct Settings {
+    G4int shells = 3;                // 유닛당 껍질 수
+    G4double ratio = 2.;             // 인접 껍질 사이의 중요도 비
+    G4double outerRadius = 15.*cm;   // 가장 바깥 껍질의 반지름 (LS 중심 기준)
+  };
+
+  // G4ImportanceBiasing, G4ParallelWorldPhysics에 같은 이름을 줍니다.
+  static constexpr const char* kWorldName = "ImportanceWorld";
+
+  ImportanceWorld(const DetectorConstruction* detector, const Settings& settings);
+  virtual ~ImportanceWorld();
+
+  virtual void Construct() override;
+  virtual void ConstructSD() override;
+
+  // 현재 검출기 배치(거리, 유닛 각도)에 맞추어 유닛별 껍질을 옮깁니다.
+  void PlaceCells();
+
+private:
+  // 아직 등록되지 않은 셀의 중요도를 이 스레드에서 보이는 G4IStore에 등록합니다.
+  void RegisterImportances();
+
+  const DetectorConstruction* fDetector;
+  Settings fSettings;
+  G4VPhysicalVolume* fGhostWorld;
+  G4LogicalVolume* fOuterShell;                 // 유닛마다 하나씩 배치되는 가장 바깥 껍질
+  std::vector<G4VPhysicalVolume*> fInnerShells; // 껍질 1..shells-1의 placement (각자 바로 바깥 껍질 안)
+  std::vector<G4VPhysicalVolume*> fCells;       // [유닛] 바깥 껍질 placement (사용하지 않는 것은 World에서 뗌)
+  size_t fActiveCells;
+};
+
+#endif
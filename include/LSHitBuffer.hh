@@ -0,0 +1,82 @@
+#ifndef LSHitBuffer_h
+#define LSHitBuffer_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+#include <vector>
+
+/**
+ * @class LSHitBuffer
+ * @brief LS 에너지 증착 스텝을 열(column) 단위 연속 배열로 저장하는 스레드별 재사용 버퍼입니다.
+ *
+ * 스텝마다 Hit 객체를 할당하는 대신, LSSD가 소유한 이 버퍼의 각 배열에 값을 추가합니다.
+ * 이벤트가 시작될 때 Clear()로 길이만 0으로 되돌리고 용량(capacity)은 유지하므로,
+ * 첫 몇 이벤트 이후에는 스텝 처리 중 힙 할당이 일어나지 않습니다.
+ * 단위는 Ntuple과 동일하게 위치 mm, 시간 ns, 에너지 MeV로 저장합니다.
+ * weight는 스텝을 만든 트랙의 가중치입니다. (중요도 편향이 없으면 1)
+ */
+class LSHitBuffer
+{
+public:
+  LSHitBuffer();
+  ~LSHitBuffer();
+
+  void Clear();
+  void Reserve(size_t n);
+  size_t Size() const { return fEnergyDeposit.size(); }
+
+  inline void Add(G4int detectorID, G4int trackID, G4int parentID,
+                  G4int particleCode, G4int processCode, G4int volumeCode,
+                  const G4ThreeVector& position, G4double time,
+                  G4double kineticEnergy, G4double energyDeposit, G4double weight);
+
+  const std::vector<G4int>& GetDetectorID() const { return fDetectorID; }
+  const std::vector<G4int>& GetTrackID() const { return fTrackID; }
+  const std::vector<G4int>& GetParentID() const { return fParentID; }
+  const std::vector<G4int>& GetParticleCode() const { return fParticleCode; }
+  const std::vector<G4int>& GetProcessCode() const { return fProcessCode; }
+  const std::vector<G4int>& GetVolumeCode() const { return fVolumeCode; }
+  const std::vector<G4double>& GetX() const { return fX; }
+  const std::vector<G4double>& GetY() const { return fY; }
+  const std::vector<G4double>& GetZ() const { return fZ; }
+  const std::vector<G4double>& GetTime() const { return fTime; }
+  const std::vector<G4double>& GetKineticEnergy() const { return fKineticEnergy; }
+  const std::vector<G4double>& GetEnergyDeposit() const { return fEnergyDeposit; }
+  const std::vector<G4double>& GetWeight() const { return fWeight; }
+
+private:
+  std::vector<G4int>    fDetectorID;   // 유닛 copy number
+  std::vector<G4int>    fTrackID;
+  std::vector<G4int>    fParentID;
+  std::vector<G4int>    fParticleCode;
+  std::vector<G4int>    fProcessCode;
+  std::vector<G4int>    fVolumeCode;
+  std::vector<G4double> fX, fY, fZ;
+  std::vector<G4double> fTime;
+  std::vector<G4double> fKineticEnergy;
+  std::vector<G4double> fEnergyDeposit;
+  std::vector<G4double> fWeight;
+};
+
+inline void LSHitBuffer::Add(G4int detectorID, G4int trackID, G4int parentID,
+                             G4int particleCode, G4int processCode, G4int volumeCode,
+                             const G4ThreeVector& position, G4double time,
+                             G4double kineticEnergy, G4double energyDeposit, G4double weight)
+{
+  fDetectorID.push_back(detectorID);
+  fTrackID.push_back(trackID);
+  fParentID.push_back(parentID);
+  fParticleCode.push_back(particleCode);
+  fProcessCode.push_back(processCode);
+  fVolumeCode.push_back(volumeCode);
+  fX.push_back(position.x());
+  fY.push_back(position.y());
+  fZ.push_back(position.z());
+  fTime.push_back(time);
+  fKineticEnergy.push_back(kineticEnergy);
+  fEnergyDeposit.push_back(energyDeposit);
+  fWeight.push_back(weight);
+}
+
+#endif
@@ -2,26 +2,73 @@
 #define LSSD_h 1
 
 #include "G4VSensitiveDetector.hh"
-#include "LSHit.hh"
+#include "G4MaterialPropertyVector.hh"
+#include "LSHitBuffer.hh"
+
+#include <unordered_map>
+#include <vector>
 
 class G4Step;
 class G4HCofThisEvent;
+class G4Material;
+class PMTSD;
 
 /**
  * @class LSSD
  * @brief LS와 PMT 윈도우의 에너지 증착을 감지하는 Sensitive Detector 클래스입니다.
+ *
+ * 스텝별 정보는 G4 HitsCollection 대신 스레드별로 재사용되는 LSHitBuffer(열 단위 배열)에 기록합니다.
+ * EventAction은 GetHitBuffer()로 같은 스레드의 버퍼를 직접 읽습니다.
+ *
+ * 두 유닛이 같은 logicLS를 공유하므로, 유닛 구분은 PhysDetectorUnit의 copy number로 합니다.
+ * 유닛별로 총 에너지 증착, Birks 보정 가시 에너지, 에너지 가중 중심, 첫 증착 시간을 이벤트 단위로 누적합니다.
  */
 class LSSD : public G4VSensitiveDetector
 {
 public:
+  // 이벤트 단위 유닛별 LS 요약 (길이는 내부 단위, 중심은 에너지 가중 합이므로 edep로 나누어 사용)
+  struct UnitSummary {
+    G4double edep = 0.;
+    G4double visibleEdep = 0.;          // Birks 보정 가시 에너지
+    G4ThreeVector weightedPosition;     // sum(edep x 스텝 중점), 전역 좌표
+    G4double firstTime = DBL_MAX;       // 첫 에너지 증착의 전역 시간
+    G4double weightedEdep = 0.;         // sum(트랙 가중치 x edep), 중요도 편향이 없으면 edep와 같음
+  };
+
   LSSD(const G4String& name);
   virtual ~LSSD();
 
   virtual void Initialize(G4HCofThisEvent* hce) override;
   virtual G4bool ProcessHits(G4Step* aStep, G4TouchableHistory* ROhist) override;
 
+  // 현재 이벤트에서 유닛(copy number)별로 누적된 LS 에너지 증착 (StackingAction의 동시계수 판정용)
+  G4double GetUnitEnergyDeposit(G4int unit) const;
+  G4int GetNumberOfUnitsAbove(G4double threshold) const;
+
+  const std::vector<UnitSummary>& GetUnitSummaries() const { return fUnitSummary; }
+
+  // 현재 이벤트의 LS 스텝 데이터 (다음 이벤트의 Initialize()에서 비워집니다)
+  const LSHitBuffer& GetHitBuffer() const { return fHitBuffer; }
+
 private:
-  LSHitsCollection* fHitsCollection;
+  void GenerateFastPMTHits(const G4Step* aStep);
+  void CacheLSConstants(const G4Material* material);
+  // MPT의 BIRKSCONSTANT로 보정한 스텝의 가시 에너지: edep / (1 + kB x edep/dx)
+  G4double GetQuenchedEnergy(const G4Step* aStep) const;
+  // 객체 포인터(입자 정의, 프로세스, 논리 볼륨)를 키로 하는 스레드별 이름 코드 캐시
+  G4int GetNameCode(const void* key, const G4String& name);
+
+  LSHitBuffer fHitBuffer;
+  std::vector<UnitSummary> fUnitSummary; // [유닛 copy number] 이벤트 단위 요약
+  std::unordered_map<const void*, G4int> fNameCodeCache;
+  G4int fPrimaryProcessCode;       // 생성 프로세스가 없는 1차 입자의 "primary" 코드
+
+  // LS 물질 상수 (최초 스텝에서 한 번 읽음). 섬광 상수와 PMTSD는 fast 광학 모드에서 사용합니다.
+  G4bool fConstantsCached;
+  G4MaterialPropertyVector* fBirksConstant;
+  PMTSD* fPMTSD;
+  G4double fScintYield;
+  G4double fScintTimeConstant;
 };
 
 #endif
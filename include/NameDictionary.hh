@@ -0,0 +1,48 @@
+#ifndef NameDictionary_h
+#define NameDictionary_h 1
+
+#include "globals.hh"
+#include "G4Threading.hh"
+
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class NameDictionary
+ * @brief 입자/프로세스/볼륨 이름을 작은 정수 코드로 바꾸는 스레드 안전한 문자열 사전(interning)입니다.
+ *
+ * 모든 스레드가 하나의 사전을 공유하므로, 같은 이름은 어느 스레드에서든 같은 코드를 받습니다.
+ * 따라서 Worker들의 Ntuple을 병합해도 코드가 일관되며, Run 종료 시 Master가 'Dictionary' TTree에
+ * (코드, 이름) 쌍을 한 번 기록하여 ROOT 분석에서 코드를 이름으로 되돌릴 수 있게 합니다.
+ *
+ * 코드가 스레드 경쟁이나 이벤트 내용에 따라 달라지지 않도록, "primary"는 항상 코드 0이고
+ * Master가 Run 시작 시(Worker의 이벤트 처리 전) RegisterKnownNames()로 입자/프로세스/논리 볼륨 테이블의
+ * 이름을 정렬된 순서로 미리 등록합니다. 같은 물리 목록과 지오메트리로 실행한 독립 프로세스(shard)는
+ * 같은 코드를 쓰므로 cpnr_merge로 합칠 수 있습니다. 테이블에 없던 이름(런 도중 만들어지는 들뜬 이온 등)만
+ * 처음 본 순서로 뒤에 붙습니다.
+ *
+ * Intern()은 뮤텍스를 잡으므로, 스텝마다 호출하는 곳(LSSD)은 스레드별 포인터 캐시를 앞에 둡니다.
+ */
+class NameDictionary
+{
+public:
+  static NameDictionary* Instance();
+
+  // 이름에 해당하는 코드를 반환합니다. 처음 보는 이름이면 새 코드를 할당합니다.
+  G4int Intern(const G4String& name);
+  // 입자/프로세스/논리 볼륨 테이블의 모든 이름을 종류별 정렬 순서로 등록합니다. (Master, Run 시작 시)
+  void RegisterKnownNames();
+  // 코드 순서대로 정렬된 모든 이름의 복사본
+  std::vector<G4String> GetNames() const;
+
+private:
+  NameDictionary();
+
+  static NameDictionary* fgInstance;
+
+  mutable G4Mutex fMutex;
+  std::unordered_map<std::string, G4int> fCodes;
+  std::vector<G4String> fNames;
+};
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef OpticalLookupMap_h
+#define OpticalLookupMap_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+#include <vector>
+
+/**
+ * @class OpticalLookupMap
+ * @brief LS 내부 위치/광자 에너지별 PMT 검출 확률과 도달 시간 분포를 담는 복셀 맵입니다.
+ *
+ * 두 검출기 유닛은 동일한 구조이므로, 맵은 LS 로컬 좌표계(원통 r, z) 하나로 정의되며
+ * 같은 유닛의 PMT에 대한 검출 확률을 저장합니다. r 방향은 부피가 같도록 r^2 기준으로 나눕니다.
+ * 'build' 모드에서 전체 광학 추적으로 채우고, 'fast' 모드에서 파일로부터 읽어
+ * 에너지 증착을 PMT Hit으로 직접 변환(샘플링)하는 데 사용합니다.
+ */
+class OpticalLookupMap
+{
+public:
+  OpticalLookupMap();
+  ~OpticalLookupMap();
+
+  // 격자를 정의하고 모든 카운터를 0으로 초기화합니다.
+  void Configure(G4int nR, G4int nZ, G4int nE, G4int nT,
+                 G4double rMax, G4double zHalf,
+                 G4double eMin, G4double eMax, G4double tMax);
+  void Reset();
+  G4bool IsConfigured() const { return !fEmitted.empty(); }
+
+  // LS 로컬 좌표와 광자 에너지로부터 (복셀, 에너지) bin 번호를 계산합니다. 범위 밖이면 -1.
+  G4int FindBin(const G4ThreeVector& localPos, G4double photonEnergy) const;
+  G4int FindVoxel(const G4ThreeVector& localPos) const;
+
+  // --- 맵 생성(build) 단계 ---
+  // 솎아내기/가중치가 있는 광자도 편향 없이 누적되도록 가중치를 함께 받습니다.
+  void FillEmitted(G4int bin, G4double weight = 1.) { if (bin >= 0) fEmitted[bin] += weight; }
+  void FillDetected(G4int bin, G4double transitTime, G4double weight = 1.);
+  void FillForeign(G4double weight = 1.) { fForeign += weight; }
+  void Merge(const OpticalLookupMap& other);
+
+  // --- 파일 입출력 ---
+  void Write(const G4String& fileName) const;
+  G4bool Read(const G4String& fileName);
+
+  // --- 빠른 모드(fast) 샘플링 ---
+  // 복셀별 (에너지 적분) 검출 확률
+  G4double GetDetectionProbability(G4int voxel) const;
+  // 복셀별 광자 이동 시간(transit time) 분포로부터 무작위 샘플링
+  G4double SampleTransitTime(G4int voxel) const;
+
+  G4double GetTotalEmitted() const;
+  G4double GetTotalDetected() const;
+  G4double GetForeign() const { return fForeign; }
+
+private:
+  // 복셀별 검출 확률과 시간 누적분포(CDF)를 미리 계산합니다.
+  void Finalize();
+
+  G4int fNR, fNZ, fNE, fNT;
+  G4double fRMax, fZHalf, fEMin, fEMax, fTMax;
+
+  std::vector<G4double> fEmitted;     // [voxel*nE + e] 생성된 광자 수
+  std::vector<G4double> fDetected;    // [voxel*nE + e] 같은 유닛 PMT에서 검출된 광자 수
+  std::vector<G4double> fTimeHist;    // [voxel*nT + t] 검출 광자의 이동 시간 히스토그램
+  G4double fForeign;                  // 다른 유닛의 PMT에서 검출된 광자 수 (근사 오차 점검용)
+
+  std::vector<G4double> fVoxelProb;   // [voxel] 에너지 적분 검출 확률 (Finalize 결과)
+  std::vector<G4double> fTimeCDF;     // [voxel*nT + t] 이동 시간 누적분포 (Finalize 결과)
+};
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef OpticalMapManager_h
+#define OpticalMapManager_h 1
+
+#include "globals.hh"
+#include "OpticalLookupMap.hh"
+
+class G4GenericMessenger;
+
+/**
+ * @class OpticalMapManager
+ * @brief 광학 시뮬레이션 모드(full/build/fast), 광학 룩업 맵, 광자 솎아내기(thinning)를 관리하는 싱글톤입니다.
+ *
+ * - full : 모든 광학 광자를 끝까지 추적합니다. (기존 동작)
+ * - build: 전체 광학 추적을 수행하면서 OpticalLookupMap을 채우고, Run 종료 시 파일로 저장합니다.
+ * - fast : 저장된 맵을 읽어, LSSD의 에너지 증착을 PMT Hit으로 직접 샘플링합니다.
+ *          이때 생성된 광학 광자는 StackingAction이 모두 버리며, 매크로의 /process/inactivate Scintillation 등으로
+ *          광자 생성 자체를 끄면 더 빠릅니다.
+ *
+ * 솎아내기(thinning): 광학 광자를 생성 시점에 f = min(1, scale x 최대 QE)의 확률로만 남기고
+ * 가중치 1/f를 부여합니다. PMTSD는 수용 확률을 QE/f로 보정하므로 검출 광자 수의 기댓값은 변하지 않습니다.
+ *
+ * 설정과 마스터 맵은 Master 스레드에 하나만 존재하며, build 모드의 누적은
+ * 스레드별 맵에서 이루어진 뒤 Worker의 EndOfRunAction에서 마스터 맵으로 병합됩니다.
+ */
+class OpticalMapManager
+{
+public:
+  enum class Mode { kFull, kBuild, kFast };
+
+  static OpticalMapManager* Instance();
+  ~OpticalMapManager();
+
+  Mode GetMode() const { return fMode; }
+  G4bool IsBuildMode() const { return fMode == Mode::kBuild; }
+  G4bool IsFastMode() const { return fMode == Mode::kFast; }
+
+  // RunAction에서 호출: Master는 맵을 읽거나 초기화하고, Worker는 스레드별 맵을 준비합니다.
+  void BeginOfRun(G4bool isMaster);
+  void EndOfRun(G4bool isMaster);
+
+  // build 모드에서 현재 스레드가 채워야 할 맵 (Worker는 스레드별 맵, 순차 모드는 마스터 맵)
+  OpticalLookupMap* GetFillMap();
+  // fast 모드에서 읽기 전용으로 공유되는 맵
+  const OpticalLookupMap& GetMap() const { return fMasterMap; }
+
+  // 광학 광자 생존 확률 f (솎아내기를 사용하지 않으면 1)
+  G4bool IsThinningEnabled() const { return fThinningFraction < 1.; }
+  G4double GetThinningFraction() const { return fThinningFraction; }
+
+private:
+  OpticalMapManager();
+  void DefineCommands();
+  void SetMode(const G4String& mode);
+  void ConfigureMap(OpticalLookupMap& map) const;
+  void UpdateThinningFraction();
+
+  static OpticalMapManager* fgInstance;
+  static G4ThreadLocal OpticalLookupMap* fgWorkerMap;
+
+  Mode fMode;
+  G4String fMapFile;
+  G4String fLoadedFile;
+  G4int fNBinsR, fNBinsZ, fNBinsE, fNBinsT;
+  G4double fTimeMax;
+
+  G4double fThinningScale;     // 사용자 배율 (0 = 솎아내기 끔)
+  G4double fThinningFraction;  // BeginOfRun에서 계산된 생존 확률 f
+
+  OpticalLookupMap fMasterMap;
+  G4GenericMessenger* fMessenger;
+};
+
+#endif
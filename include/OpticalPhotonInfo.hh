@@ -0,0 +1,28 @@
+#ifndef OpticalPhotonInfo_h
+#define OpticalPhotonInfo_h 1
+
+#include "G4VUserTrackInformation.hh"
+#include "globals.hh"
+
+/**
+ * @class OpticalPhotonInfo
+ * @brief LS에서 생성된 광학 광자에 붙는 사용자 트랙 정보입니다.
+ *
+ * 광학 룩업 맵 생성(build) 모드에서, 광자가 생성된 유닛 번호와 맵 bin 번호를
+ * PMTSD까지 전달하기 위해 TrackingAction에서 부착합니다.
+ */
+class OpticalPhotonInfo : public G4VUserTrackInformation
+{
+public:
+  OpticalPhotonInfo(G4int sourceUnit, G4int mapBin);
+  virtual ~OpticalPhotonInfo();
+
+  G4int GetSourceUnit() const { return fSourceUnit; }
+  G4int GetMapBin() const { return fMapBin; }
+
+private:
+  G4int fSourceUnit; // 광자가 생성된 검출기 유닛의 copy number
+  G4int fMapBin;     // OpticalLookupMap의 (복셀, 에너지) bin 번호
+};
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef OutputWriter_h
+#define OutputWriter_h 1
+
+#include "globals.hh"
+#include "BoundedQueue.hh"
+
+#include <atomic>
+#include <thread>
+
+struct EventRecord;
+class EventSink;
+class G4GenericMessenger;
+
+/**
+ * @class OutputWriter
+ * @brief 이벤트 루프와 분리된 비동기 출력 단계를 관리하는 싱글톤입니다.
+ *
+ * Worker는 이벤트 종료 시 EventRecord를 채워 lock-free 큐(BoundedQueue)에 넣고 바로 다음 이벤트로 넘어갑니다.
+ * 전용 쓰기 스레드가 큐에서 최대 batchSize개씩 꺼내 EventSink에 기록한 뒤, 레코드를 재사용 풀로 돌려보냅니다.
+ * 큐가 가득 차면 Worker는 자리가 날 때까지 기다리며(backpressure), 그 시간을 정체(stall) 시간으로 집계합니다.
+ * Run 종료 시 큐 깊이(최대/평균), 정체 횟수와 시간, 기록 시간을 출력하여 큐 크기를 정하는 데 사용합니다.
+ * 출력 형식은 ROOT(RootEventSink) 또는 열 단위 mmap 형식(ColumnarEventSink) 중에서 고릅니다.
+ *
+ * 비동기 모드에서는 파일이 하나뿐이므로 Master의 Ntuple 병합 단계가 없습니다.
+ * 동기 모드에서 Master 병합을 피하려면 스레드별 파일(setPerThreadFiles)을 쓰고, Run 뒤에 cpnr_merge로 합칩니다.
+ * 설정은 Master의 싱글톤에만 있으므로, main()에서 RunManager 초기화 전에 Instance()를 한 번 호출합니다.
+ */
+class OutputWriter
+{
+public:
+  static OutputWriter* Instance();
+  ~OutputWriter();
+
+  // /myApp/writer/setAsync 설정 (Run 시작 시 Master와 Worker의 RunAction이 참조)
+  G4bool IsEnabled() const { return fEnabled; }
+  // /myApp/writer/setPerThreadFiles 설정 (동기 모드에서 Ntuple 병합 대신 스레드별 파일 기록)
+  G4bool IsPerThreadFiles() const { return fPerThreadFiles; }
+  // 출력 파일 이름 (확장자 제외, /myApp/writer/setFileName, 기본값 "output")
+  const G4String& GetFileName() const { return fFileName; }
+  void SetFileName(const G4String& fileName) { fFileName = fileName; }
+  // 기록하는 eventID에 더할 값 (여러 번의 BeamOn으로 나눈 런에서 전역 이벤트 번호를 만들 때 사용)
+  G4int GetEventIDOffset() const { return fEventIDOffset; }
+  void SetEventIDOffset(G4int offset) { fEventIDOffset = offset; }
+  // 현재 형식의 파일 확장자 (".root" 또는 ".col")
+  G4String GetFileExtension() const { return fColumnar ? ".col" : ".root"; }
+  // 쓰기 스레드가 동작 중인지 (Master의 BeginOfRun ~ EndOfRun 사이)
+  G4bool IsRunning() const { return fRunning.load(std::memory_order_acquire); }
+
+  // Master의 RunAction에서 호출합니다. 파일 이름은 확장자 없이 받아 형식에 맞는 확장자를 붙입니다.
+  void Start(const G4String& baseName);
+  void Stop();
+
+  // Worker의 EventAction에서 호출합니다. Acquire()로 받은 레코드는 반드시 Push()로 돌려줍니다.
+  EventRecord* Acquire();
+  void Push(EventRecord* record);
+
+private:
+  OutputWriter();
+  void DefineCommands();
+  void SetFormat(const G4String& format);
+  void WriterLoop();
+  void Recycle(EventRecord* record);
+  void PrintStatistics() const;
+
+  static OutputWriter* fgInstance;
+
+  G4bool fEnabled;
+  G4bool fPerThreadFiles;
+  G4bool fColumnar;            // 출력 형식: false = ROOT (.root), true = 열 단위 mmap 형식 (.col)
+  G4int fQueueSize;
+  G4int fBatchSize;
+  G4String fFileName;
+  G4int fEventIDOffset;
+
+  BoundedQueue<EventRecord*>* fQueue;        // 기록 대기 중인 레코드
+  BoundedQueue<EventRecord*>* fFreeRecords;  // 재사용 풀
+  EventSink* fSink;
+  std::thread fThread;
+  std::atomic<bool> fRunning;
+  std::atomic<bool> fStopRequested;
+
+  // --- 통계 (Worker가 갱신하는 값은 원자적, 쓰기 스레드 전용 값은 일반 변수) ---
+  std::atomic<G4long> fRecordsAllocated;
+  std::atomic<G4long> fStalledPushes;
+  std::atomic<G4long> fStallNanoseconds;
+  G4long fRecordsWritten;
+  G4long fBatches;
+  size_t fMaxDepth;
+  G4double fDepthSum;
+  G4double fWriteSeconds;
+
+  G4GenericMessenger* fMessenger;
+};
+
+#endif
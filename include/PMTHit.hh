@@ -24,9 +24,13 @@ public:
   void SetTime(G4double time) { fTime = time; }
   G4double GetTime() const { return fTime; }
 
+  void SetWeight(G4double weight) { fWeight = weight; }
+  G4double GetWeight() const { return fWeight; }
+
 private:
   G4int fPMTID;     // 광자를 검출한 PMT의 번호
   G4double fTime;   // 광자 검출 시간
+  G4double fWeight; // 통계적 가중치 (솎아내기/편향이 없으면 1)
 };
 
 typedef G4THitsCollection<PMTHit> PMTHitsCollection;
@@ -20,6 +20,9 @@ public:
   virtual void Initialize(G4HCofThisEvent* hce) override;
   virtual G4bool ProcessHits(G4Step* aStep, G4TouchableHistory* ROhist) override;
 
+  // PMT 번호와 시간(ns), 가중치로 Hit을 직접 기록합니다. (fast 광학 모드에서 LSSD가 호출)
+  void RecordHit(G4int pmtID, G4double time, G4double weight = 1.);
+
 private:
   PMTHitsCollection* fHitsCollection;
 };
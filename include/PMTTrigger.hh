@@ -0,0 +1,44 @@
+#ifndef PMTTrigger_h
+#define PMTTrigger_h 1
+
+#include "globals.hh"
+#include "PMTHit.hh"
+
+#include <utility>
+#include <vector>
+
+/**
+ * @class PMTTrigger
+ * @brief 한 이벤트의 PMTHitsCollection으로부터 PMT별 트리거 시각을 구하는 작은 판별기입니다.
+ *
+ * PMT의 광전자를 시간 순으로 더해 가중치 합이 문턱에 도달한 시각을 그 PMT의 트리거 시각으로 봅니다.
+ * Worker의 Run이 하나를 소유하고, EventAction의 기록 트리거(/myApp/trigger/)와 Run의 W(θ) 동시계수(/myApp/coincidence/)가
+ * 같은 인스턴스를 씁니다. 광전자 복사/정렬은 이벤트당 한 번만 하고(Load), 트리거 목록은 문턱이 바뀔 때만 다시 계산합니다.
+ * 작업 버퍼를 이벤트 간에 재사용하므로 스레드마다 하나씩 둡니다.
+ */
+class PMTTrigger
+{
+public:
+  PMTTrigger() = default;
+
+  // 이벤트의 광전자를 (PMT, 시간) 순으로 정렬해 둡니다. 이미 읽은 이벤트 번호면 아무것도 하지 않습니다. (hits가 없으면 비움)
+  void Load(const PMTHitsCollection* hits, G4int eventID);
+  // 읽어 둔 광전자로 트리거된 PMT 목록을 구합니다. 직전과 같은 문턱이면 다시 계산하지 않습니다.
+  void Evaluate(G4double peThreshold);
+
+  // (PMT 번호, 트리거 시각 ns), PMT 번호 순
+  const std::vector<std::pair<G4int, G4double>>& GetTriggers() const { return fTriggers; }
+
+  // 폭 window인 어떤 시간 창 안에 함께 들어가는 트리거 PMT 수의 최댓값 (majority 판정)
+  G4int GetMultiplicity(G4double window);
+
+private:
+  struct PhotoElectron { G4int pmtID; G4double time; G4double weight; };
+  G4int fEventID = -1;          // fPhotoElectrons를 읽은 이벤트 (-1 = 없음)
+  G4double fThreshold = -1.;    // fTriggers를 계산한 문턱 (-1 = 아직 계산 전)
+  std::vector<PhotoElectron> fPhotoElectrons;
+  std::vector<std::pair<G4int, G4double>> fTriggers;
+  std::vector<G4double> fTimes;
+};
+
+#endif
@@ -2,19 +2,66 @@
 #define PhysicsList_h 1
 
 #include "G4VModularPhysicsList.hh"
+#include "globals.hh"
+#include "ImportanceWorld.hh"
+
+class G4GenericMessenger;
+class G4GeometrySampler;
 
 /**
  * @class PhysicsList
- * @brief 시뮬레이션에 사용될 모든 물리 프로세스를 정의하고 등록하는 클래스입니다.
+ * @brief 시뮬레이션에 사용할 물리 모듈을 프리셋(preset) 단위로 조립하고, 물리 테이블 디스크 캐시를 관리합니다.
+ *
+ * - full     : 전자기 + 붕괴/방사성 붕괴 + 강입자(FTFP_BERT_HP) + 이온/정지 + 광학 (기존 구성, 기본값)
+ * - minimal  : 전자기 + 붕괴/방사성 붕괴 + 광학. 밀봉 Co-60 감마 선원에는 강입자 모듈이 필요 없으므로
+ *              HP 데이터 로딩과 강입자 테이블 생성이 빠져 시작 시간이 크게 줄어듭니다.
+ * - nooptical: 전자기 + 붕괴/방사성 붕괴. 광학 광자를 만들지 않으므로 /myApp/optics/setMode fast 전용입니다.
+ *
+ * 물리 모듈 등록은 PreInit 상태에서만 가능하므로, main은 명령행 옵션과 --preinit 매크로를 적용한 뒤
+ * ConstructPreset()을 호출하고 나서 RunManager에 등록합니다.
  *
- * G4VModularPhysicsList를 상속받아, 필요한 물리 모듈(전자기, 방사성 붕괴, 광학 등)을
- * 독립적으로 조합하여 사용합니다. Geant4에서 권장하는 현대적인 방식입니다.
+ * 물리 테이블 캐시: 첫 Run에서 만든 테이블을 <cacheDir>/<preset>_g4<버전>_cut<감마-전자-양전자-양성자 컷>um/ 에
+ * 저장하고, 다음 실행부터는 같은 키의 디렉터리에서 읽습니다. 저장된 컷과 현재 컷이 다르면
+ * Geant4가 읽기를 포기하고 테이블을 다시 계산하므로 잘못된 테이블을 쓰지 않습니다.
+ *
+ * 감마 중요도 편향(/myApp/physics/importance): 켜면 ImportanceWorld 병렬 세계에서 감마의 splitting/roulette을 하는
+ * G4ImportanceBiasing과 병렬 세계 내비게이션(G4ParallelWorldPhysics)을 함께 등록합니다.
+ * 병렬 세계 자체는 main이 DetectorConstruction에 등록합니다.
  */
 class PhysicsList : public G4VModularPhysicsList
 {
 public:
-  PhysicsList();
+  explicit PhysicsList(const G4String& preset = "full");
   virtual ~PhysicsList();
+
+  // 현재 프리셋의 물리 모듈을 등록하고, 캐시가 있으면 테이블을 읽도록 설정합니다. (PreInit, 한 번만)
+  void ConstructPreset();
+  // 이번 실행에서 테이블을 새로 만들었고 캐시가 아직 없으면 저장합니다. (Idle 상태의 Master에서 호출)
+  void StorePhysicsTableCache();
+
+  void SetPreset(const G4String& preset);
+  void SetCacheDirectory(const G4String& directory) { fCacheRoot = directory; }
+  void SetCacheEnabled(G4bool enabled) { fCacheEnabled = enabled; }
+
+  const G4String& GetPreset() const { return fPreset; }
+  G4bool IsImportanceBiasingEnabled() const { return fImportanceEnabled; }
+  const ImportanceWorld::Settings& GetImportanceSettings() const { return fImportance; }
+  // 프리셋, Geant4 버전, 기본 영역의 입자별 컷으로 정해지는 캐시 디렉터리
+  G4String GetCacheKeyDirectory() const;
+
+private:
+  void DefineCommands();
+  G4bool IsCacheComplete(const G4String& directory) const;
+
+  G4String fPreset;
+  G4String fCacheRoot;
+  G4bool fCacheEnabled;
+  G4bool fConstructed;
+  G4String fRetrievedFrom;  // 캐시에서 테이블을 읽도록 설정한 디렉터리 (없으면 빈 문자열)
+  G4bool fImportanceEnabled;
+  ImportanceWorld::Settings fImportance;
+  G4GeometrySampler* fGeometrySampler;  // G4ImportanceBiasing이 참조하므로 물리 리스트와 수명을 같이 합니다.
+  G4GenericMessenger* fMessenger;
 };
 
 #endif
@@ -2,16 +2,32 @@
 #define PrimaryGeneratorAction_h 1
 
 #include "G4VUserPrimaryGeneratorAction.hh"
+#include "G4ThreeVector.hh"
 #include "globals.hh"
 
+#include <vector>
+
 class G4GeneralParticleSource;
+class G4GenericMessenger;
 class G4Event;
 
 /**
  * @class PrimaryGeneratorAction
  * @brief 각 이벤트의 초기 입자를 생성하는 클래스입니다.
  *
- * G4GeneralParticleSource(GPS)를 사용하여, 매크로 파일에서 소스를 유연하게 제어합니다.
+ * 두 가지 모드(/myApp/generator/mode)를 지원합니다.
+ * - gps    : G4GeneralParticleSource(GPS)를 사용하여, 매크로 파일에서 소스를 유연하게 제어합니다. (기본값)
+ *            Co-60 이온을 만들고 G4RadioactiveDecay가 붕괴를 처리합니다.
+ * - cascade: 선원 원기둥(kSourceRadius x kSourceHalfZ) 안에서 꼭짓점을 해석적으로 샘플링하고,
+ *            ⁶⁰Ni의 4⁺→2⁺→0⁺ 감마 캐스케이드(1173.2 / 1332.5 keV)를 각도 상관
+ *            W(θ) = 1 + a₂cos²θ + a₄cos⁴θ (a₂ = 1/8, a₄ = 1/24)에 따라 직접 방출합니다.
+ *            선택적으로 318 keV 종점의 베타 전자도 함께 방출합니다.
+ *            이온 추적과 붕괴 처리가 없어 빠르고, RDM 경로를 검증하는 기준(ground truth) 생성기로 쓸 수 있습니다.
+ *
+ * 방향 강제(/myApp/generator/forceDirection, cascade 모드 전용): 감마를 검출기 유닛의 LS 외접구를 향한 원뿔 쪽으로
+ * 몰아 뽑고, 실제 밀도(등방 또는 W(θ))와 편향된 밀도의 비를 이벤트 가중치(EventWeightInfo)로 붙입니다.
+ * 편향된 밀도는 등방 성분(isotropicFraction)을 섞은 방어적 혼합이므로 원뿔 밖의 방향도 뽑히며,
+ * 가중 단일 계수/동시계수/W(θ)/스펙트럼은 모두 편향 없는 추정량입니다. (선원/에폭시에서 산란되어 들어오는 감마 포함)
  */
 class PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
 {
@@ -22,7 +38,41 @@ public:
   virtual void GeneratePrimaries(G4Event* anEvent) override;
 
 private:
+  void DefineCommands();
+  void SetMode(const G4String& mode);
+  void GenerateCascade(G4Event* anEvent);
+
+  G4ThreeVector SampleSourceVertex() const;
+  G4ThreeVector SampleIsotropicDirection() const;
+  // 첫 번째 감마 방향에 대해 W(θ)를 따르는 두 번째 감마 방향
+  G4ThreeVector SampleCorrelatedDirection(const G4ThreeVector& first) const;
+  G4double SampleBetaEnergy() const;
+  G4double BetaSpectrum(G4double kineticEnergy) const;
+
+  // 방향 강제: 유닛별 원뿔 (선원 중심 기준), 런이 바뀌면 검출기 배치에서 다시 계산합니다.
+  struct Cone {
+    G4ThreeVector axis;
+    G4double cosHalfAngle;
+    G4double solidAngle;
+  };
+  void UpdateCones();
+  // isotropicFraction의 확률로 등방, 나머지는 원뿔 하나를 균등하게 고른 뒤 그 안에서 균일한 방향을 뽑습니다.
+  G4ThreeVector SampleForcedDirection() const;
+  // 위 샘플링의 방향 밀도 (등방 성분 + 원뿔 성분, 원뿔이 겹치면 모든 원뿔의 기여를 더함)
+  G4double ForcedDirectionDensity(const G4ThreeVector& direction) const;
+
   G4GeneralParticleSource* fGPS;
+  G4bool fUseCascade;
+  G4bool fEmitBeta;
+  G4bool fCorrelation;       // false면 두 감마를 서로 독립적인 등방으로 방출 (W = 1 검증용)
+  G4double fBetaSpectrumMax; // 베타 스펙트럼 기각 샘플링의 상한
+  G4bool fForceDirection;
+  G4int fForcedGammas;       // 1 = 1173 keV 감마만, 2 = 두 감마 모두 원뿔 안으로
+  G4double fConeMargin;      // LS 외접구 반지름에 더하는 여유
+  G4double fIsotropicFraction; // 방향 강제 감마 중 등방으로 뽑는 비율 (방어적 혼합, 0 < ε <= 1)
+  std::vector<Cone> fCones;
+  G4int fConeRunID;          // fCones를 계산한 런 번호 (-1 = 아직 없음)
+  G4GenericMessenger* fMessenger;
 };
 
 #endif
@@ -0,0 +1,50 @@
+#ifndef RootEventSink_h
+#define RootEventSink_h 1
+
+#include "EventSink.hh"
+
+#include <vector>
+
+class TFile;
+class TTree;
+
+/**
+ * @class RootEventSink
+ * @brief EventRecord를 ROOT TTree(Hits, EventSummary, PMTHits, PMTSummary, Dictionary)로 기록합니다.
+ *
+ * 트리와 브랜치 이름은 RunAction이 정의하는 G4 Ntuple과 같으므로, 동기/비동기 출력 파일을
+ * 같은 분석 코드로 읽을 수 있습니다. G4AnalysisManager 대신 ROOT를 직접 사용하는 이유는
+ * 쓰기 스레드가 Geant4 스레드가 아니어서 스레드별 분석 관리자를 가질 수 없기 때문입니다.
+ */
+class RootEventSink : public EventSink
+{
+public:
+  RootEventSink();
+  virtual ~RootEventSink();
+
+  virtual G4bool Open(const G4String& fileName) override;
+  virtual void Write(const EventRecord& record) override;
+  virtual void Close(const std::vector<G4String>& dictionary) override;
+
+private:
+  TFile* fFile;
+  TTree* fHitsTree;
+  TTree* fSummaryTree;
+  TTree* fPMTHitsTree;
+  TTree* fPMTSummaryTree;
+  TTree* fDictionaryTree;
+
+  // 브랜치 버퍼 (모든 트리가 공유하는 eventID 포함)
+  G4int fEventID;
+  G4int fDetectorID, fTrackID, fParentID, fParticleCode, fProcessCode, fVolumeCode;
+  G4double fX, fY, fZ, fTime, fKineticEnergy, fEnergyDeposit, fStepWeight;
+  G4int fNPrimaries, fNSecondaries;
+  G4double fEdep, fVisibleEnergy, fCentroidX, fCentroidY, fCentroidZ, fFirstTime, fUnitWeight;
+  G4int fPMTID, fNPE;
+  G4double fPMTTime, fWeight, fWeightedPE, fPMTFirstTime, fMedianTime, fLastTime;
+  std::vector<G4double> fTimeHist;
+  G4int fCode;
+  char fName[256];       // G4 Ntuple의 문자열 열과 같은 C 문자열(leaf 형식 "C")
+};
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef Run_h
+#define Run_h 1
+
+#include "G4Run.hh"
+#include "G4SystemOfUnits.hh"
+#include "globals.hh"
+#include "PMTTrigger.hh"
+#include "StepProfile.hh"
+
+#include <array>
+#include <iosfwd>
+#include <map>
+#include <utility>
+#include <vector>
+
+class LSSD;
+class G4Event;
+
+/**
+ * @class Run
+ * @brief 런 단위 카운터를 누적하는 사용자 정의 G4Run 클래스입니다.
+ *
+ * 각 Worker 스레드는 자신의 Run 객체에 카운터를 누적하고, 런이 끝나면
+ * Geant4 커널이 Merge()를 호출하여 Master의 Run 객체로 합칩니다.
+ * Master의 RunAction::EndOfRunAction에서 병합된 결과를 출력합니다.
+ *
+ * 각도 상관 W(θ) 누적기: RecordEvent()에서 이벤트마다 PMT별 트리거(가중 광전자 수가 문턱을 넘은 시각)와
+ * 유닛별 가시 에너지를 보고, PMT별 단일 계수(singles), 시간 창 안의 PMT 쌍 동시계수,
+ * 그리고 두 유닛의 가시 에너지가 모두 에너지 창 안에 있는 동시계수를 셉니다.
+ * 광자별 출력 없이도 스캔 한 점의 W(θ)를 얻을 수 있습니다.
+ *
+ * 방향 강제 생성기(EventWeightInfo)를 쓰면 이벤트마다 가중치가 있으므로, 계수와 함께 가중치 합과 제곱합을 누적하고
+ * 비율, 오차, W는 가중치 합으로 계산합니다. 가중치가 모두 1이면 계수로 계산한 값과 같습니다.
+ *
+ * 감마 중요도 편향(/myApp/physics/importance)에서는 한 이벤트에 같은 감마의 분할 사본이 함께 있어
+ * 이벤트 단위 트리거와 가시 에너지가 편향되므로, 누적기를 끈 채로(coincidenceEnabled = false) 만듭니다.
+ *
+ * 스텝 프로파일(/myApp/profile/)을 켜면 (볼륨 × 입자 × 프로세스)별 스텝/트랙/시간 카운터도 함께 병합합니다.
+ */
+class Run : public G4Run
+{
+public:
+  // SteppingAction의 광학 광자 제거 규칙
+  enum PhotonKillRule {
+    kKillOutsideAssembly = 0, // 검출기 유닛(assembly)을 벗어나 World로 나간 광자
+    kKillDeadVolume,          // PMT 몸체, 선원/에폭시 등 광음극에 도달할 수 없는 볼륨에 들어간 광자
+    kKillTimeWindow,          // 전역 시간 창(time window)이 닫힌 뒤의 광자
+    kKillMaxReflections,      // 경계면 반사 횟수가 한도를 넘은 광자
+    kNumPhotonKillRules
+  };
+
+  // 동시계수 조건 (/myApp/coincidence/, RunAction이 보관하고 Run을 만들 때 복사합니다)
+  struct CoincidenceSettings {
+    G4double window = 10.*ns;       // 두 PMT 트리거 시각 차이의 허용 범위
+    G4double peThreshold = 1.;      // PMT 트리거 문턱 (가중 광전자 수)
+    G4double gateMin = 0.;          // 가시 에너지 창 (gateMax <= gateMin이면 에너지 조건 계수를 하지 않음)
+    G4double gateMax = 0.;
+  };
+
+  // 이벤트 가중치의 합과 제곱합 (편향이 없으면 둘 다 계수와 같음)
+  struct WeightSum {
+    G4double sum = 0.;
+    G4double sum2 = 0.;
+
+    void Add(G4double weight) { sum += weight; sum2 += weight*weight; }
+    void Add(const WeightSum& other) { sum += other.sum; sum2 += other.sum2; }
+    // 이벤트당 비율 r = sum/N 과 그 표준 오차 sqrt(sum2 - sum²/N)/N (가중치 1이면 이항 오차 sqrt(r(1-r)/N))
+    G4double Rate(G4int nEvents) const { return nEvents > 0 ? sum / nEvents : 0.; }
+    G4double RateError(G4int nEvents) const;
+  };
+
+  // PMT 쌍 (작은 번호, 큰 번호)별 동시계수
+  struct PairCounts {
+    G4long coincidences = 0;
+    G4long gatedCoincidences = 0;
+    WeightSum weight;
+    WeightSum gatedWeight;
+    WeightSum overlapWeight;        // 두 PMT가 모두 트리거된 이벤트 (시간 창과 무관, W 오차의 S_a-S_b 공분산)
+  };
+
+  explicit Run(const CoincidenceSettings& settings, G4bool coincidenceEnabled = true);
+  virtual ~Run();
+
+  virtual void RecordEvent(const G4Event* event) override;
+  virtual void Merge(const G4Run* run) override;
+
+  void CountPhotonKill(PhotonKillRule rule, G4int stepsTaken);
+  void CountOpticalStep() { ++fOpticalSteps; }
+  // EventAction의 기록 트리거 판정 결과 (/myApp/trigger/)
+  void CountTrigger(G4bool accepted) { ++(accepted ? fTriggerAccepted : fTriggerRejected); }
+  // StackingAction의 2단계 스태킹 판정 결과 (/myApp/stacking/)
+  void CountStacking(G4bool accepted) { ++(accepted ? fStackingAccepted : fStackingRejected); }
+  // 이벤트당 한 번 정렬한 광전자를 기록 트리거와 W(θ) 누적이 함께 쓰는 판별기 (EventAction이 먼저 호출)
+  PMTTrigger& GetTrigger() { return fTrigger; }
+  // 스텝 프로파일 카운터 (SteppingAction/TrackingAction이 채우고, Master에서 StepProfiler가 보고)
+  StepProfile& GetProfile() { return fProfile; }
+  const StepProfile& GetProfile() const { return fProfile; }
+
+  G4long GetSingles(G4int pmtID) const;
+  G4long GetGatedSingles(G4int unit) const;
+  WeightSum GetSinglesWeight(G4int pmtID) const;
+  WeightSum GetGatedSinglesWeight(G4int unit) const;
+  const std::map<std::pair<G4int, G4int>, PairCounts>& GetPairCounts() const { return fPairCounts; }
+  const CoincidenceSettings& GetCoincidenceSettings() const { return fSettings; }
+  // false면 W(θ) 누적기(단일 계수/동시계수/에너지 창)를 세지 않습니다. (중요도 편향)
+  G4bool IsCoincidenceEnabled() const { return fCoincidenceEnabled; }
+
+  void PrintSummary() const;
+
+  // 체크포인트: 동시계수 조건과 병합된 카운터(이벤트 수 포함)를 텍스트로 저장하고 되읽습니다. (CheckpointManager)
+  void WriteCounters(std::ostream& out) const;
+  G4bool ReadCounters(std::istream& in);
+
+private:
+  G4bool IsGateEnabled() const { return fSettings.gateMax > fSettings.gateMin; }
+  void PrintPhotonKills() const;
+  void PrintTrigger() const;
+  void PrintStacking() const;
+  void PrintAngularCorrelation() const;
+
+  std::array<G4long, kNumPhotonKillRules> fPhotonKills;      // 규칙별 제거된 광자 수
+  std::array<G4long, kNumPhotonKillRules> fPhotonKillSteps;  // 규칙별 제거 시점까지 진행된 스텝 수 합
+  G4long fOpticalSteps;                                      // 추적된 전체 광학 광자 스텝 수
+  G4long fTriggerAccepted;                                   // 기록 트리거를 통과해 기록된 이벤트 수
+  G4long fTriggerRejected;                                   // 기록 트리거에서 버려진 이벤트 수
+  G4long fStackingAccepted;                                  // 2단계 스태킹에서 광학 광자를 추적한 이벤트 수
+  G4long fStackingRejected;                                  // 2단계 스태킹에서 광학 광자를 버린 이벤트 수
+
+  CoincidenceSettings fSettings;
+  G4bool fCoincidenceEnabled;
+  std::vector<G4long> fSingles;                              // [PMT] 트리거된 이벤트 수
+  std::vector<G4long> fGatedSingles;                         // [유닛] 가시 에너지가 창 안에 있는 이벤트 수
+  std::vector<WeightSum> fSinglesWeight;                     // [PMT] 트리거된 이벤트의 가중치
+  std::vector<WeightSum> fGatedSinglesWeight;                // [유닛] 에너지 창 안인 이벤트의 가중치
+  std::map<std::pair<G4int, G4int>, PairCounts> fPairCounts;
+  StepProfile fProfile;
+
+  // 이벤트별 작업 버퍼 (병합하지 않음)
+  PMTTrigger fTrigger;
+  std::vector<char> fUnitGated;                              // [유닛] 이번 이벤트에서 에너지 창 안인지
+  LSSD* fLSSD;
+  G4int fPMTHcID;
+};
+
+#endif
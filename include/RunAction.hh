@@ -3,21 +3,44 @@
 
 #include "G4UserRunAction.hh"
 #include "globals.hh"
+#include "Run.hh"
+
+#include <vector>
+
+class G4GenericMessenger;
 
 /**
  * @class RunAction
  * @brief Run의 시작과 끝에서 수행할 작업을 정의하는 클래스입니다.
  *
  * 주로 데이터 파일(ROOT)을 열고 닫으며, 생성자에서 저장할 TTree의 구조를 정의합니다.
+ * 동시계수 조건(/myApp/coincidence/)을 보관하고, 매 런마다 이 조건으로 Run 객체를 만듭니다.
+ * 감마 중요도 편향이 켜져 있으면 이벤트 단위 양(W(θ) 누적, 기록 트리거, EventSummary 에너지 열)을 끕니다.
  */
 class RunAction : public G4UserRunAction
 {
 public:
-  RunAction();
+  explicit RunAction(G4bool importanceBiasing = false);
   virtual ~RunAction();
 
+  virtual G4Run* GenerateRun() override;
   virtual void BeginOfRunAction(const G4Run*) override;
   virtual void EndOfRunAction(const G4Run*) override;
+
+  // PMTSummary TTree의 도달 시간 히스토그램(vector 열)에 연결된 버퍼. EventAction이 채웁니다.
+  std::vector<G4double>& GetPMTTimeHistogram() { return fPMTTimeHistogram; }
+  // 감마 중요도 편향(/myApp/physics/importance) 사용 여부. EventAction이 기록 트리거와 에너지 열을 끌 때 봅니다.
+  G4bool IsImportanceBiasing() const { return fImportanceBiasing; }
+
+private:
+  void DefineCommands();
+
+  std::vector<G4double> fPMTTimeHistogram;
+  Run::CoincidenceSettings fCoincidence;
+  G4bool fImportanceBiasing;
+  G4bool fAsyncOutput;   // 이번 Run에서 OutputWriter를 사용하는지 (BeginOfRunAction에서 결정)
+  G4bool fNtupleMerging; // 현재 G4AnalysisManager에 설정된 Ntuple 병합 여부
+  G4GenericMessenger* fMessenger;
 };
 
 #endif
@@ -0,0 +1,62 @@
+#ifndef ScanManager_h
+#define ScanManager_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+class G4GenericMessenger;
+
+/**
+ * @class ScanManager
+ * @brief 한 프로세스 안에서 (거리, 각도) 스캔 점들을 차례로 실행하는 스캔 드라이버 싱글톤입니다.
+ *
+ * run_all.sh처럼 점마다 새 프로세스를 띄우면 Geant4 초기화, 물리 테이블 생성(HP 중성자 데이터 포함),
+ * Worker 스레드 생성을 매번 반복합니다. 스캔 모드에서는 초기화된 커널과 Worker 스레드를 그대로 두고
+ * 점마다 검출기를 제자리에서 옮긴 뒤(/myApp/detector/) /run/beamOn만 반복합니다.
+ * 각 점은 자신의 출력 파일과 난수 시드를 가지며, 점별 소요 시간과 W(θ) 결과를 manifest 파일에 한 줄씩 기록합니다.
+ *
+ * 스캔 점은 명시적 목록(addPoint)과 격자(distances x angles)를 합친 것이며, 목록 순서 -> 격자 순서로 실행합니다.
+ * 설정은 Master의 싱글톤에만 있으므로, main()에서 RunManager 초기화 전에 Instance()를 한 번 호출합니다.
+ */
+class ScanManager
+{
+public:
+  struct ScanPoint {
+    G4double distance;
+    G4double angle;
+  };
+
+  static ScanManager* Instance();
+  ~ScanManager();
+
+  // 현재 설정으로 실행할 점 목록 (명시적 점 + 격자)
+  std::vector<ScanPoint> GetPoints() const;
+
+private:
+  ScanManager();
+  void DefineCommands();
+
+  void AddPoint(const G4String& values);
+  void SetDistances(const G4String& values);
+  void SetAngles(const G4String& values);
+  void Clear();
+  void RunScan();
+
+  // 점 번호와 기본 시드로부터 점별 시드를 만듭니다. (같은 설정이면 항상 같은 시드)
+  long PointSeed(size_t index) const;
+
+  static ScanManager* fgInstance;
+
+  std::vector<ScanPoint> fPoints;   // addPoint로 추가한 점
+  std::vector<G4double> fDistances; // 격자의 거리 목록
+  std::vector<G4double> fAngles;    // 격자의 각도 목록
+  G4int fEvents;
+  G4long fBaseSeed;
+  G4String fOutputPrefix;
+  G4String fManifestFile;
+
+  G4GenericMessenger* fMessenger;
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef ShardManager_h
+#define ShardManager_h 1
+
+#include "globals.hh"
+
+class G4GenericMessenger;
+
+/**
+ * @class ShardManager
+ * @brief 하나의 논리적 런을 여러 독립 프로세스(shard)로 나누어 실행하는 싱글톤입니다.
+ *
+ * 전체 N 이벤트 중 shard i/K는 전역 이벤트 [N·i/K, N·(i+1)/K)를 처리하고, 출력 파일
+ * <writer 파일 이름>_shard<i>of<K>와 병합 카운터 파일(.counters)을 남깁니다.
+ * shard 모드에서는 Master 엔진이 나눠 주는 시드 대신, 이벤트마다 (런 시드, 전역 이벤트 번호)로부터
+ * 시드를 만들어 스레드 엔진을 다시 초기화합니다. 따라서 이벤트 내용은 shard 수와 스레드 수에 무관하고,
+ * replayEvent로 임의의 이벤트 하나를 나중에 그대로 재현할 수 있습니다.
+ *
+ * 클러스터 서비스 없이 작업 배열(job array)에서 index만 바꾸어 실행하고,
+ * cpnr_merge에 .counters 파일들을 주면 카운터와 출력 파일을 한 데이터셋으로 합칩니다.
+ * 설정은 Master의 싱글톤에만 있으므로, main()에서 RunManager 초기화 전에 Instance()를 한 번 호출합니다.
+ */
+class ShardManager
+{
+public:
+  static ShardManager* Instance();
+  ~ShardManager();
+
+  // 이번 Run에서 이벤트별 시드를 쓰는지 (shard/replay 실행 중에만 true, Worker가 읽기만 합니다)
+  G4bool IsPerEventSeeding() const { return fPerEventSeeding; }
+  // 현재 스레드의 엔진을 (런 시드, 전역 이벤트 번호)로 초기화합니다. PrimaryGeneratorAction이 이벤트 시작 시 호출합니다.
+  void SeedEvent(G4long globalEventID) const;
+
+private:
+  ShardManager();
+  void DefineCommands();
+
+  void RunShard();
+  void ReplayEvent(G4int globalEventID);
+  G4bool WriteCounters(const G4String& fileName, const G4String& output, G4long firstEvent) const;
+
+  static ShardManager* fgInstance;
+
+  G4long fRunSeed;
+  G4long fTotalEvents;
+  G4int fShardIndex;
+  G4int fShardCount;
+  G4bool fPerEventSeeding;
+
+  G4GenericMessenger* fMessenger;
+};
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef SplitMix64_h
+#define SplitMix64_h 1
+
+#include <cstdint>
+
+/**
+ * @brief splitmix64 혼합 함수입니다. (S. Vigna)
+ *
+ * 연속된 정수(스캔 점 번호, 전역 이벤트 번호)를 서로 상관없는 64비트 값으로 바꾸므로,
+ * ScanManager와 ShardManager가 (기준 시드, 번호)로부터 재현 가능한 시드를 만들 때 씁니다.
+ */
+inline std::uint64_t SplitMix64(std::uint64_t x)
+{
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+#endif
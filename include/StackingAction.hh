@@ -0,0 +1,47 @@
+#ifndef StackingAction_h
+#define StackingAction_h 1
+
+#include "G4UserStackingAction.hh"
+#include "globals.hh"
+
+class G4GenericMessenger;
+class LSSD;
+
+/**
+ * @class StackingAction
+ * @brief 광학 광자 추적을 동시계수(coincidence) 판정 이후로 미루는 2단계 스태킹 클래스입니다.
+ *
+ * 1단계에서는 광학 광자를 대기 스택(waiting stack)에 넣고 나머지 입자만 추적합니다.
+ * 1단계가 끝나는 NewStage()에서 LSSD의 유닛별 에너지 증착을 확인하여, 설정된 수 이상의
+ * LS에 임계값을 넘는 증착이 있으면 광자를 추적하고, 그렇지 않으면 대기 중인 광자를 모두 버립니다.
+ * 각도 상관 분석은 동시계수 이벤트만 사용하므로, 대부분의 이벤트에서 광학 추적을 생략할 수 있습니다.
+ * 추적/생략한 이벤트 수는 Run에 세어 런 요약에 출력합니다.
+ *
+ * 광학 광자 솎아내기(/myApp/optics/setThinningScale)도 생성 시점인 이 클래스에서 적용하고,
+ * fast 모드(/myApp/optics/setMode fast)에서는 맵 Hit과 이중으로 세지 않도록 광학 광자를 모두 버립니다.
+ *
+ * UI 명령어(/myApp/stacking/)는 Worker 스레드의 인스턴스가 등록하므로 /run/initialize 이후에 사용합니다.
+ */
+class StackingAction : public G4UserStackingAction
+{
+public:
+  StackingAction();
+  virtual ~StackingAction();
+
+  virtual G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track* track) override;
+  virtual void NewStage() override;
+  virtual void PrepareNewEvent() override;
+
+private:
+  void DefineCommands();
+
+  G4bool fEnabled;          // 2단계 스태킹 사용 여부
+  G4int fMinUnits;          // 광자를 추적하기 위해 증착이 있어야 하는 최소 유닛 수 (2 = 동시계수)
+  G4double fEdepThreshold;  // 유닛별 에너지 증착 임계값
+  G4int fStage;             // 현재 이벤트의 스택 단계 (0 = 광자 대기 중)
+
+  LSSD* fLSSD;
+  G4GenericMessenger* fMessenger;
+};
+
+#endif
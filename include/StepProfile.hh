@@ -0,0 +1,74 @@
+#ifndef StepProfile_h
+#define StepProfile_h 1
+
+#include "globals.hh"
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
+class G4LogicalVolume;
+class G4ParticleDefinition;
+class G4VProcess;
+
+/**
+ * @class StepProfile
+ * @brief (논리 볼륨 × 입자 × 프로세스)별 스텝 수, 트랙 수, 표본 CPU 시간을 누적하는 스레드별 카운터입니다.
+ *
+ * Run 객체가 하나씩 가지며 SteppingAction/TrackingAction이 채웁니다. (/myApp/profile/)
+ * 스텝 중에는 포인터 세 개를 키로 쓰고, 직전 키를 기억해 같은 조합이 이어지는 경우(LS 안의 광학 광자 등)
+ * 해시 조회도 건너뜁니다. 프로세스 객체는 스레드마다 다르므로, Merge()에서 이름 키로 바꾸어 합칩니다.
+ * - 스텝: 스텝 시작 볼륨, 입자, 스텝을 정한 프로세스
+ * - 트랙: 트랙이 생성된 볼륨, 입자, 생성 프로세스 (1차 입자는 "primary")
+ */
+class StepProfile
+{
+public:
+  struct Counts {
+    G4long steps = 0;
+    G4long tracks = 0;
+    G4long timedSteps = 0;   // 시간을 잰 표본 스텝 수
+    G4double seconds = 0.;   // 표본 CPU 시간 × 표본 주기 (전체 스텝 CPU 시간의 추정값)
+  };
+  // (볼륨, 입자, 프로세스) 이름
+  using NameKey = std::tuple<G4String, G4String, G4String>;
+
+  // 스텝 하나를 세고 그 조합의 카운터를 돌려줍니다. (시간 표본은 호출자가 더합니다)
+  Counts& CountStep(const G4LogicalVolume* volume, const G4ParticleDefinition* particle, const G4VProcess* process);
+  void CountTrack(const G4LogicalVolume* volume, const G4ParticleDefinition* particle, const G4VProcess* creator);
+
+  void Merge(const StepProfile& other);
+  // 이름 키로 합친 전체 표 (병합된 결과와 이 스레드의 카운터)
+  std::map<NameKey, Counts> GetTable() const;
+  G4bool IsEmpty() const { return fCounts.empty() && fMerged.empty(); }
+
+private:
+  struct Key {
+    const G4LogicalVolume* volume;
+    const G4ParticleDefinition* particle;
+    const G4VProcess* process;
+    bool operator==(const Key& other) const
+    { return volume == other.volume && particle == other.particle && process == other.process; }
+  };
+  struct KeyHash {
+    std::size_t operator()(const Key& key) const
+    {
+      std::size_t h = std::hash<const void*>()(key.volume);
+      h = h * 31 + std::hash<const void*>()(key.particle);
+      return h * 31 + std::hash<const void*>()(key.process);
+    }
+  };
+
+  Counts& Find(const Key& key);
+  static NameKey ToNames(const Key& key);
+  static void Add(Counts& sum, const Counts& counts);
+
+  std::unordered_map<Key, Counts, KeyHash> fCounts;  // 이 스레드의 카운터 (노드 기반이라 참조가 유지됨)
+  std::map<NameKey, Counts> fMerged;                  // Merge()로 받은 카운터
+  Key fLastKey = {nullptr, nullptr, nullptr};
+  Counts* fLastCounts = nullptr;
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef StepProfiler_h
+#define StepProfiler_h 1
+
+#include "globals.hh"
+
+class G4GenericMessenger;
+class StepProfile;
+
+/**
+ * @class StepProfiler
+ * @brief 스텝 시간 프로파일링(/myApp/profile/)의 설정과 런 종료 보고를 맡는 싱글톤입니다.
+ *
+ * 켜면 SteppingAction/TrackingAction이 Worker의 Run에 (논리 볼륨 × 입자 × 프로세스)별 스텝/트랙 수를 세고,
+ * samplePeriod 스텝마다 한 번 다음 스텝이 끝날 때까지의 스레드 CPU 시간(CLOCK_THREAD_CPUTIME_ID)을 재어 주기를 곱해 더합니다.
+ * 시계는 표본 스텝에서만 읽으므로 꺼져 있을 때의 비용은 스텝당 분기 하나입니다.
+ * 트랙의 첫 스텝은 트랙 생성과 스택 처리 시간이 섞이므로 표본에서 빼고 다음 스텝을 잽니다.
+ *
+ * Master의 EndOfRunAction에서 병합된 표를 추정 시간 순으로 정렬해 상위 항목을 출력하고,
+ * 모든 항목을 탭으로 구분한 파일에 런 번호와 함께 씁니다. (첫 런에서 새로 쓰고 이후 런은 이어 씀)
+ * 설정은 Master의 싱글톤에만 있으므로, main()에서 RunManager 초기화 전에 Instance()를 한 번 호출합니다.
+ */
+class StepProfiler
+{
+public:
+  static StepProfiler* Instance();
+  ~StepProfiler();
+
+  // Worker가 스텝/트랙마다 읽습니다. (명령어는 Idle 상태에서만 바뀜)
+  G4bool IsEnabled() const { return fEnabled; }
+  G4int GetSamplePeriod() const { return fSamplePeriod; }
+
+  // 병합된 프로파일을 출력하고 파일에 씁니다. (Master의 EndOfRunAction)
+  void Report(const StepProfile& profile, G4int runID);
+
+private:
+  StepProfiler();
+  void DefineCommands();
+
+  static StepProfiler* fgInstance;
+
+  G4bool fEnabled;
+  G4int fSamplePeriod;   // 시간을 재는 간격 (스텝 수, 0 = 시간 측정 안 함)
+  G4int fTopRows;        // 출력할 상위 항목 수
+  G4String fFileName;    // 탭 구분 출력 파일 ("none"이면 쓰지 않음)
+  G4bool fFileStarted;   // 이번 프로세스에서 파일을 이미 새로 썼는지
+
+  G4GenericMessenger* fMessenger;
+};
+
+#endif
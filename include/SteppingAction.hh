@@ -2,13 +2,27 @@
 #define SteppingAction_h 1
 
 #include "G4UserSteppingAction.hh"
+#include "globals.hh"
+
+class G4GenericMessenger;
+class G4OpBoundaryProcess;
 
 /**
  * @class SteppingAction
  * @brief 입자의 모든 스텝(step)마다 호출되는 클래스입니다.
  *
- * 이 프로젝트에서는 데이터 수집 로직을 G4VSensitiveDetector (LSSD)로 이전했기 때문에,
- * 이 클래스의 내용은 의도적으로 비워두었습니다.
+ * 데이터 수집은 Sensitive Detector(LSSD, PMTSD)가 담당하며, 이 클래스는 더 이상
+ * 광음극에 도달할 수 없는 광학 광자를 일찍 제거하는 규칙 엔진 역할을 합니다.
+ * - outsideAssembly: 검출기 유닛을 벗어나 World(진공)로 나간 광자
+ * - deadVolume     : PMT 몸체, 선원, 에폭시에 들어간 광자
+ * - timeWindow     : 전역 시간이 설정값을 넘은 광자
+ * - maxReflections : 경계면 반사 횟수가 설정값을 넘은 광자
+ * 규칙별 제거 수는 Run 객체에 누적되어 런 요약에 출력됩니다.
+ *
+ * 스텝 프로파일(/myApp/profile/, StepProfiler)을 켜면 모든 스텝을 (볼륨 × 입자 × 프로세스)로 세고,
+ * 표본 주기마다 다음 스텝까지의 스레드 CPU 시간을 잽니다.
+ *
+ * UI 명령어(/myApp/photonKill/)는 Worker 스레드의 인스턴스가 등록하므로 /run/initialize 이후에 사용합니다.
  */
 class SteppingAction : public G4UserSteppingAction
 {
@@ -16,6 +30,27 @@ public:
   SteppingAction();
   virtual ~SteppingAction();
   virtual void UserSteppingAction(const G4Step*) override;
+
+private:
+  void DefineCommands();
+  G4bool IsReflection();
+  void ProfileStep(const G4Step* step);
+
+  // 규칙 설정 (0 또는 false = 비활성)
+  G4bool fKillOutsideAssembly;
+  G4bool fKillDeadVolume;
+  G4double fTimeWindow;
+  G4int fMaxReflections;
+
+  G4int fReflections;                 // 현재 추적 중인 광자의 반사 횟수
+  G4OpBoundaryProcess* fBoundary;     // 반사 판정용 경계 프로세스 (최초 사용 시 검색)
+
+  // 스텝 프로파일 시간 표본
+  G4int fStepsToSample;                                   // 다음 표본까지 남은 스텝 수
+  G4bool fTiming;                                         // 다음 스텝의 시간을 재는 중인지
+  G4double fTimingStart;                                  // 표본 시작 시각의 스레드 CPU 시간 [s]
+
+  G4GenericMessenger* fMessenger;
 };
 
 #endif
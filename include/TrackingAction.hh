@@ -8,7 +8,7 @@
  * @class TrackingAction
  * @brief 입자 하나의 트랙(생성부터 소멸까지) 단위로 작업을 수행하는 클래스입니다.
  *
- * 현재 프로젝트에서는 사용하고 있지 않지만, 향후 확장을 위한 틀(placeholder)로 남겨두었습니다.
+ * 광학 룩업 맵 생성(build) 모드에서 섬광 광자의 생성 위치를 맵에 기록하는 데 사용합니다.
  */
 class TrackingAction : public G4UserTrackingAction
 {
@@ -0,0 +1,75 @@
+#!/bin/bash
+
+# =============================================================
+# 물리 프리셋별 시작 시간 / 처리량 벤치마크
+# =============================================================
+# 프리셋마다 다음 세 번의 실행 시간을 잽니다.
+#   1) cold   : 캐시를 지운 뒤 /run/beamOn 0 (커널 초기화 + 물리 테이블 계산, 캐시 저장)
+#   2) warm   : 같은 캐시로 /run/beamOn 0 (물리 테이블을 캐시에서 읽음)
+#   3) run    : 같은 캐시로 /run/beamOn NUM_EVENTS
+# 처리량은 NUM_EVENTS / (run - warm) 입니다.
+# nooptical 프리셋은 광학 광자를 만들지 않으므로 PMT Hit이 없고, 처리량은 감마/전자 추적만의 값입니다.
+
+# --- 벤치마크 매개변수 설정 ---
+PRESETS=(full minimal nooptical)
+NUM_EVENTS=10000
+BUILD_DIR="./build"
+CACHE_DIR="physics_cache_bench"
+RESULT_FILE="physics_benchmark.tsv"
+EXECUTABLE="./CPNR_OMEG_colab_low_energy_optical"
+
+# --- 공통 매크로 작성 ---
+write_macro() {
+  cat > "${BUILD_DIR}/$1" <<MAC
+/run/verbose 0
+/event/verbose 0
+/tracking/verbose 0
+/process/had/rdm/thresholdForVeryLongDecayTime 1.0e+60 year
+/process/had/rdm/nucleusLimits 60 60 27 27
+/gps/particle ion
+/gps/ion 27 60 0 0
+/gps/energy 0. keV
+/gps/source/confine LogicSource
+/gps/ang/type iso
+/myApp/output/writeSteps false
+/myApp/output/pmtOutput none
+/myApp/writer/setFileName physics_benchmark
+/random/setSeeds 12345 67890
+/run/beamOn $2
+MAC
+}
+
+# 한 번 실행하고 걸린 벽시계 시간(초)을 출력합니다.
+time_run() {
+  local start end
+  start=$(date +%s.%N)
+  (cd "${BUILD_DIR}" && ${EXECUTABLE} --physics "$1" --physics-cache "${CACHE_DIR}" "$2" > "bench_$1_$3.log" 2>&1)
+  end=$(date +%s.%N)
+  echo "${end} - ${start}" | bc -l
+}
+
+write_macro "bench_startup.mac" 0
+write_macro "bench_run.mac" "${NUM_EVENTS}"
+
+echo "===== Physics preset benchmark (${NUM_EVENTS} events) ====="
+printf "preset\tstartup_cold_s\tstartup_warm_s\trun_s\tevents_per_s\n" > "${BUILD_DIR}/${RESULT_FILE}"
+
+for preset in "${PRESETS[@]}"; do
+  echo "--- Preset: ${preset} ---"
+  rm -rf "${BUILD_DIR}/${CACHE_DIR}"
+
+  cold=$(time_run "${preset}" bench_startup.mac cold)
+  warm=$(time_run "${preset}" bench_startup.mac warm)
+  run=$(time_run "${preset}" bench_run.mac run)
+  rate=$(echo "${NUM_EVENTS} / (${run} - ${warm})" | bc -l)
+
+  printf "%s\t%.2f\t%.2f\t%.2f\t%.1f\n" "${preset}" "${cold}" "${warm}" "${run}" "${rate}" \
+    >> "${BUILD_DIR}/${RESULT_FILE}"
+done
+
+# 임시 매크로 파일 삭제
+rm "${BUILD_DIR}/bench_startup.mac" "${BUILD_DIR}/bench_run.mac"
+
+echo ""
+column -t -s $'\t' "${BUILD_DIR}/${RESULT_FILE}"
+echo "===== Results written to ${BUILD_DIR}/${RESULT_FILE} ====="
@@ -0,0 +1,83 @@
+#!/bin/bash
+
+# =============================================================
+# 독립 프로세스 shard 병합 확인
+# =============================================================
+# 한 런을 두 shard로 나누어 서로 다른 Master 시드와 스레드 수로 각각 별도 프로세스에서 실행한 뒤,
+# cpnr_merge로 합칩니다. 두 shard는 서로 다른 이벤트를 보므로 이름을 처음 만나는 순서도 다르지만,
+# 이름 코드는 Run 시작 시 정렬 순서로 정해지므로 Dictionary가 일치해야 합니다.
+# 병합 Ntuple 모드와 스레드별 파일 모드(/myApp/writer/setPerThreadFiles true) 각각에 대해
+# 다음을 확인하고 하나라도 어긋나면 FAIL과 함께 1을 반환합니다.
+#   1) cpnr_merge가 성공하는지 (Dictionary 충돌이나 누락된 shard가 없음)
+#   2) 합친 카운터의 이벤트 수가 전체 이벤트 수와 같은지
+#   3) 합친 Hits 항목 수가 두 shard의 모든 출력 파일(<이름>.root, <이름>_t<n>.root)의 Hits 항목 수의 합과 같고 0보다 큰지
+
+BUILD_DIR="./build"
+EXECUTABLE="./CPNR_OMEG_colab_low_energy_optical"
+MERGE="./cpnr_merge"
+TOTAL_EVENTS=2000
+FILE_NAME="shard_check"
+
+# --- shard 매크로 작성: $1 = shard 번호, $2 $3 = Master 시드, $4 = 스레드별 파일 여부 ---
+write_macro() {
+  cat > "${BUILD_DIR}/shard_check_$1.mac" <<MAC
+/run/verbose 0
+/event/verbose 0
+/tracking/verbose 0
+/process/had/rdm/thresholdForVeryLongDecayTime 1.0e+60 year
+/process/had/rdm/nucleusLimits 60 60 27 27
+/gps/particle ion
+/gps/ion 27 60 0 0
+/gps/energy 0. keV
+/gps/source/confine LogicSource
+/gps/ang/type iso
+/myApp/writer/setFileName ${FILE_NAME}
+/myApp/writer/setPerThreadFiles $4
+/random/setSeeds $2 $3
+/myApp/shard/runSeed 12345
+/myApp/shard/events ${TOTAL_EVENTS}
+/myApp/shard/count 2
+/myApp/shard/index $1
+/myApp/shard/run
+MAC
+}
+
+fail() {
+  echo "FAIL: $1"
+  exit 1
+}
+
+# --- 한 출력 모드로 두 shard를 실행하고 병합 결과를 확인: $1 = 모드 이름, $2 = 스레드별 파일 여부 ---
+check_mode() {
+  rm -f "${BUILD_DIR}/${FILE_NAME}"_shard* "${BUILD_DIR}/${FILE_NAME}_merged".*
+  write_macro 0 12345 67890 "$2"
+  write_macro 1 13579 24680 "$2"
+
+  (cd "${BUILD_DIR}" && ${EXECUTABLE} -t 2 shard_check_0.mac > shard_check_0.log 2>&1) || fail "$1: shard 0, see ${BUILD_DIR}/shard_check_0.log"
+  (cd "${BUILD_DIR}" && ${EXECUTABLE} -t 3 shard_check_1.mac > shard_check_1.log 2>&1) || fail "$1: shard 1, see ${BUILD_DIR}/shard_check_1.log"
+  rm "${BUILD_DIR}/shard_check_0.mac" "${BUILD_DIR}/shard_check_1.mac"
+
+  (cd "${BUILD_DIR}" && ${MERGE} -o "${FILE_NAME}_merged.root" "${FILE_NAME}"_shard*.counters) || fail "$1: cpnr_merge refused the shards"
+
+  events=$(awk '$1 == "events" { print $2 }' "${BUILD_DIR}/${FILE_NAME}_merged.counters")
+  [ "${events}" = "${TOTAL_EVENTS}" ] || fail "$1: merged counters have ${events} events, expected ${TOTAL_EVENTS}"
+
+  # 병합 모드는 <이름>.root 하나, 스레드별 모드는 <이름>.root(Master)와 <이름>_t<n>.root들
+  shard_files=$(cd "${BUILD_DIR}" && ls "${FILE_NAME}"_shard*.root | sed 's/.*/"&",/' | tr -d '\n')
+  hits=$(cd "${BUILD_DIR}" && root -l -b -q -e '
+    Long64_t shards = 0;
+    for (auto name : {'"${shard_files%,}"'}) {
+      TFile f(name);
+      shards += static_cast<TTree*>(f.Get("Hits"))->GetEntries();
+    }
+    TFile merged("'"${FILE_NAME}"'_merged.root");
+    printf("%lld %lld\n", shards, static_cast<TTree*>(merged.Get("Hits"))->GetEntries());' | tail -1)
+  read -r shard_hits merged_hits <<< "${hits}"
+  [ -n "${merged_hits}" ] && [ "${shard_hits}" = "${merged_hits}" ] || fail "$1: merged Hits has ${merged_hits} entries, shards have ${shard_hits}"
+  [ "${merged_hits}" -gt 0 ] || fail "$1: merged Hits is empty"
+
+  echo "ok ($1): 2 shards (${TOTAL_EVENTS} events, ${merged_hits} Hits entries) merged into ${BUILD_DIR}/${FILE_NAME}_merged.root"
+}
+
+check_mode merged false
+check_mode per-thread true
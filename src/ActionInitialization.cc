@@ -4,11 +4,13 @@
 #include "EventAction.hh"
 #include "SteppingAction.hh"
 #include "TrackingAction.hh"
+#include "StackingAction.hh"
 
 /**
- * @brief 생성자: 기본 생성자를 호출합니다.
+ * @brief 생성자: 감마 중요도 편향 여부(/myApp/physics/importance)를 보관합니다.
  */
-ActionInitialization::ActionInitialization() : G4VUserActionInitialization() {}
+ActionInitialization::ActionInitialization(G4bool importanceBiasing)
+: G4VUserActionInitialization(), fImportanceBiasing(importanceBiasing) {}
 
 /**
  * @brief 소멸자: 관련된 메모리 해제는 Geant4 커널이 담당합니다.
@@ -22,7 +24,7 @@ ActionInitialization::~ActionInitialization() {}
  */
 void ActionInitialization::BuildForMaster() const
 {
-  SetUserAction(new RunAction());
+  SetUserAction(new RunAction(fImportanceBiasing));
 }
 
 /**
@@ -32,9 +34,11 @@ void ActionInitialization::BuildForMaster() const
  */
 void ActionInitialization::Build() const
 {
+  auto runAction = new RunAction(fImportanceBiasing);
   SetUserAction(new PrimaryGeneratorAction());
-  SetUserAction(new RunAction());
-  SetUserAction(new EventAction());
+  SetUserAction(runAction);
+  SetUserAction(new EventAction(runAction));
   SetUserAction(new SteppingAction());
   SetUserAction(new TrackingAction());
+  SetUserAction(new StackingAction());
 }
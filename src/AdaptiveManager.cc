@@ -0,0 +1,196 @@
+#include "AdaptiveManager.hh"
+#include "OutputWriter.hh"
+#include "Run.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4RunManager.hh"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace {
+  // 이벤트당 비율 r = sum/N 의 상대 오차 (가중치 1이면 이항 분포 sqrt((1 - r)/c)). 계수가 없으면 무한대.
+  G4double RateRelativeError(const Run::WeightSum& weight, G4int nEvents)
+  {
+    if (weight.sum <= 0. || nEvents <= 0) return DBL_MAX;
+    return weight.RateError(nEvents) / weight.Rate(nEvents);
+  }
+
+  // 예측을 믿기 전에 필요한 최소 동시계수 수
+  const G4long kMinCountsForPrediction = 100;
+}
+
+AdaptiveManager* AdaptiveManager::fgInstance = nullptr;
+
+AdaptiveManager* AdaptiveManager::Instance()
+{
+  if (!fgInstance) fgInstance = new AdaptiveManager();
+  return fgInstance;
+}
+
+AdaptiveManager::AdaptiveManager()
+: fTargetRelError(0.), fBatchEvents(10000), fMinEvents(10000), fMaxEvents(10000000), fIncludeGated(false),
+  fMessenger(nullptr)
+{
+  DefineCommands();
+}
+
+AdaptiveManager::~AdaptiveManager()
+{
+  delete fMessenger;
+}
+
+void AdaptiveManager::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/myApp/adaptive/", "Adaptive run length driven by a target relative error.");
+
+  // 적응형 런은 Master에서만 실행되므로 모든 명령어를 Worker로 전파하지 않습니다.
+  auto& targetCmd = fMessenger->DeclareProperty("targetRelError", fTargetRelError,
+                                                "Stop once the worst relative error of the coincidence rates is below this (0 = off; scan points use fixed events).");
+  targetCmd.SetParameterName("RelError", false);
+  targetCmd.SetRange("RelError>=0.");
+  targetCmd.SetToBeBroadcasted(false);
+
+  auto& batchCmd = fMessenger->DeclareProperty("batchEvents", fBatchEvents, "Events of the first (and smallest) batch.");
+  batchCmd.SetParameterName("NEvents", false);
+  batchCmd.SetRange("NEvents>0");
+  batchCmd.SetToBeBroadcasted(false);
+
+  auto& minCmd = fMessenger->DeclareProperty("minEvents", fMinEvents, "Never stop before this many events.");
+  minCmd.SetParameterName("NEvents", false);
+  minCmd.SetRange("NEvents>=0");
+  minCmd.SetToBeBroadcasted(false);
+
+  auto& maxCmd = fMessenger->DeclareProperty("maxEvents", fMaxEvents, "Event cap per point, reached or not the target.");
+  maxCmd.SetParameterName("NEvents", false);
+  maxCmd.SetRange("NEvents>0");
+  maxCmd.SetToBeBroadcasted(false);
+
+  auto& gatedCmd = fMessenger->DeclareProperty("includeGated", fIncludeGated,
+                                               "Also require the target for energy-gated coincidences and per-unit energy-window counts (/myApp/coincidence/gateMin, gateMax).");
+  gatedCmd.SetParameterName("Flag", false);
+  gatedCmd.SetToBeBroadcasted(false);
+
+  auto& runCmd = fMessenger->DeclareMethod("run", &AdaptiveManager::RunAdaptive,
+                                           "Run the current setup until the target relative error or the event cap is reached.");
+  runCmd.SetStates(G4State_Idle);
+  runCmd.SetToBeBroadcasted(false);
+}
+
+void AdaptiveManager::RunAdaptive()
+{
+  if (!IsEnabled()) {
+    G4Exception("AdaptiveManager::RunAdaptive()", "Adaptive_NoTarget", JustWarning,
+                "목표 상대 오차가 없습니다. (/myApp/adaptive/targetRelError)");
+    return;
+  }
+  RunPoint(OutputWriter::Instance()->GetFileName());
+}
+
+/**
+ * @brief 모든 PMT 쌍(과 includeGated이면 에너지 창 계수) 중 가장 나쁜 상대 오차
+ */
+G4double AdaptiveManager::RelativeError(const Run& total) const
+{
+  const G4int nEvents = total.GetNumberOfEvent();
+  const auto& settings = total.GetCoincidenceSettings();
+  const G4bool gated = fIncludeGated && settings.gateMax > settings.gateMin;
+
+  // 창 밖에서만 함께 트리거된 쌍(동시계수 0)은 W 오차의 공분산용 기록이므로 건너뜁니다.
+  G4double worst = 0.;
+  G4bool anyPair = false;
+  for (const auto& entry : total.GetPairCounts()) {
+    if (entry.second.coincidences == 0) continue;
+    anyPair = true;
+    worst = std::max(worst, RateRelativeError(entry.second.weight, nEvents));
+    if (gated) {
+      worst = std::max(worst, RateRelativeError(entry.second.gatedWeight, nEvents));
+      worst = std::max(worst, RateRelativeError(total.GetGatedSinglesWeight(entry.first.first), nEvents));
+      worst = std::max(worst, RateRelativeError(total.GetGatedSinglesWeight(entry.first.second), nEvents));
+    }
+  }
+  return anyPair ? worst : DBL_MAX;
+}
+
+/**
+ * @brief 상대 오차는 1/sqrt(N)로 줄어들므로 필요한 이벤트 수는 N·(현재 오차/목표)²로 예측합니다.
+ * 동시계수(가중 이벤트에서는 유효 계수 1/오차²)가 적을 때는 예측이 불안정하므로 첫 묶음 크기를 그대로 씁니다.
+ */
+G4int AdaptiveManager::NextBatchSize(G4int processed, G4double relativeError) const
+{
+  G4double size = fBatchEvents;
+  const G4double countsEstimate = relativeError < DBL_MAX ? 1. / (relativeError * relativeError) : 0.;
+  if (processed > 0 && countsEstimate >= kMinCountsForPrediction) {
+    const G4double ratio = relativeError / fTargetRelError;
+    const G4double needed = processed * ratio * ratio;
+    size = std::min(needed - processed, static_cast<G4double>(processed));
+    size = std::max(size, static_cast<G4double>(fBatchEvents));
+  }
+  size = std::max(size, static_cast<G4double>(fMinEvents - processed));
+  size = std::min(size, static_cast<G4double>(fMaxEvents - processed));
+  return std::max(1, static_cast<G4int>(std::ceil(size)));
+}
+
+AdaptiveManager::Result AdaptiveManager::RunPoint(const G4String& baseName)
+{
+  auto runManager = G4RunManager::GetRunManager();
+  auto writer = OutputWriter::Instance();
+  const G4String savedFileName = writer->GetFileName();
+
+  Result result;
+  result.relativeError = DBL_MAX;
+  ::Run* total = nullptr;
+
+  while (result.events < fMaxEvents) {
+    const G4int nEvents = NextBatchSize(result.events, result.relativeError);
+
+    writer->SetFileName(baseName + "_part" + std::to_string(result.batches));
+    writer->SetEventIDOffset(result.events);
+    runManager->BeamOn(nEvents);
+
+    auto run = static_cast<const ::Run*>(runManager->GetCurrentRun());
+    if (!run || run->GetNumberOfEvent() != nEvents) {
+      G4Exception("AdaptiveManager::RunPoint()", "Adaptive_Incomplete", JustWarning,
+                  "묶음이 끝까지 처리되지 않아 적응형 런을 멈춥니다.");
+      break;
+    }
+    if (!run->IsCoincidenceEnabled()) {
+      G4Exception("AdaptiveManager::RunPoint()", "Adaptive_NoCoincidence", JustWarning,
+                  "감마 중요도 편향에서는 W(θ) 동시계수를 세지 않으므로 목표 오차에 도달할 수 없어 적응형 런을 멈춥니다.");
+      break;
+    }
+    if (!total) total = new ::Run(run->GetCoincidenceSettings());
+    total->Merge(run);
+
+    result.events += nEvents;
+    ++result.batches;
+    result.relativeError = RelativeError(*total);
+
+    G4cout << "--> Adaptive batch " << result.batches << ": " << result.events << " events, worst relative error ";
+    if (result.relativeError < DBL_MAX) G4cout << result.relativeError;
+    else G4cout << "n/a (no coincidences)";
+    G4cout << " (target " << fTargetRelError << ")" << G4endl;
+
+    if (result.events >= fMinEvents && result.relativeError <= fTargetRelError) {
+      result.converged = true;
+      break;
+    }
+  }
+
+  writer->SetEventIDOffset(0);
+  writer->SetFileName(savedFileName);
+
+  if (total) {
+    for (const auto& entry : total->GetPairCounts()) {
+      result.coincidences += entry.second.coincidences;
+      result.coincidenceWeight += entry.second.weight.sum;
+      result.coincidenceWeight2 += entry.second.weight.sum2;
+    }
+    G4cout << "=== Adaptive run " << (result.converged ? "reached the target" : "stopped at the event cap")
+           << ": " << result.events << " events in " << result.batches << " batches ===" << G4endl;
+    total->PrintSummary();
+    delete total;
+  }
+  return result;
+}
@@ -0,0 +1,250 @@
+#include "CheckpointManager.hh"
+#include "OutputWriter.hh"
+#include "Run.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4RunManager.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+CheckpointManager* CheckpointManager::fgInstance = nullptr;
+
+CheckpointManager* CheckpointManager::Instance()
+{
+  if (!fgInstance) fgInstance = new CheckpointManager();
+  return fgInstance;
+}
+
+CheckpointManager::CheckpointManager()
+: fEvents(1000000), fEventInterval(100000), fMinutes(0.), fSeed(12345), fCheckpointFile("checkpoint.txt"),
+  fTotalEvents(0), fNextEvent(0), fSegment(0), fComplete(false), fOutputPrefix(""), fTotal(nullptr),
+  fMessenger(nullptr)
+{
+  DefineCommands();
+}
+
+CheckpointManager::~CheckpointManager()
+{
+  delete fTotal;
+  delete fMessenger;
+}
+
+void CheckpointManager::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/myApp/checkpoint/", "Checkpointed production runs that can be resumed.");
+
+  // 구간 실행은 Master에서만 이루어지므로 모든 명령어를 Worker로 전파하지 않습니다.
+  auto& eventsCmd = fMessenger->DeclareProperty("events", fEvents, "Total number of events of the checkpointed run.");
+  eventsCmd.SetParameterName("NEvents", false);
+  eventsCmd.SetRange("NEvents>0");
+  eventsCmd.SetToBeBroadcasted(false);
+
+  auto& intervalCmd = fMessenger->DeclareProperty("eventInterval", fEventInterval,
+                                                  "Write a checkpoint at least every N events (0 = no event limit).");
+  intervalCmd.SetParameterName("N", false);
+  intervalCmd.SetRange("N>=0");
+  intervalCmd.SetToBeBroadcasted(false);
+
+  auto& minutesCmd = fMessenger->DeclareProperty("minutes", fMinutes,
+                                                 "Write a checkpoint about every M minutes of wall time (0 = no time limit).");
+  minutesCmd.SetParameterName("M", false);
+  minutesCmd.SetRange("M>=0.");
+  minutesCmd.SetToBeBroadcasted(false);
+
+  auto& seedCmd = fMessenger->DeclareProperty("seed", fSeed, "Master seed of a new checkpointed run (resume restores the saved engine state).");
+  seedCmd.SetParameterName("Seed", false);
+  seedCmd.SetToBeBroadcasted(false);
+
+  auto& fileCmd = fMessenger->DeclareProperty("file", fCheckpointFile, "Checkpoint file name.");
+  fileCmd.SetParameterName("FileName", false);
+  fileCmd.SetToBeBroadcasted(false);
+
+  auto& runCmd = fMessenger->DeclareMethod("run", &CheckpointManager::Start,
+                                           "Start a new checkpointed run; output parts are <writer file name>_part<k>.");
+  runCmd.SetStates(G4State_Idle);
+  runCmd.SetToBeBroadcasted(false);
+
+  auto& resumeCmd = fMessenger->DeclareMethod("resume", &CheckpointManager::Resume,
+                                              "Continue the run recorded in the checkpoint file from its next event.");
+  resumeCmd.SetStates(G4State_Idle);
+  resumeCmd.SetToBeBroadcasted(false);
+}
+
+void CheckpointManager::Start()
+{
+  fTotalEvents = fEvents;
+  fNextEvent = 0;
+  fSegment = 0;
+  fComplete = false;
+  fOutputPrefix = OutputWriter::Instance()->GetFileName();
+  fParts.clear();
+  delete fTotal;
+  fTotal = nullptr;
+
+  G4Random::setTheSeed(fSeed);
+  G4cout << "=== Checkpointed run: " << fTotalEvents << " events, seed " << fSeed
+         << ", checkpoint " << fCheckpointFile << " ===" << G4endl;
+  RunSegments();
+}
+
+void CheckpointManager::Resume()
+{
+  if (!ReadCheckpoint()) {
+    G4Exception("CheckpointManager::Resume()", "Checkpoint_ReadError", JustWarning,
+                ("체크포인트 파일을 읽을 수 없습니다: " + fCheckpointFile).c_str());
+    return;
+  }
+  if (fComplete) {
+    G4cout << "=== Checkpointed run in " << fCheckpointFile << " is already complete ("
+           << fTotalEvents << " events) ===" << G4endl;
+    return;
+  }
+
+  G4cout << "=== Resuming checkpointed run at event " << fNextEvent << "/" << fTotalEvents
+         << " (segment " << fSegment << ") ===" << G4endl;
+  RunSegments();
+}
+
+G4int CheckpointManager::NextSegmentSize(G4double eventsPerSecond) const
+{
+  const G4int remaining = fTotalEvents - fNextEvent;
+  G4int size = fEventInterval > 0 ? fEventInterval : remaining;
+  if (fMinutes > 0.) {
+    // 처리 속도를 모르는 첫 구간은 짧게 실행해 속도를 잽니다.
+    G4double byTime = eventsPerSecond > 0. ? fMinutes * 60. * eventsPerSecond : 1000.;
+    size = std::min<G4double>(size, std::max(1., byTime));
+  }
+  return std::max(1, std::min(size, remaining));
+}
+
+/**
+ * @brief 남은 구간을 차례로 실행합니다.
+ * @details 구간마다 출력 파일 이름과 eventID 오프셋을 정하고 BeamOn을 호출합니다. 구간이 끝까지 처리된 경우에만
+ *          카운터를 병합하고 체크포인트를 갱신하므로, 중단(/run/abort)된 구간은 resume에서 처음부터 다시 실행됩니다.
+ */
+void CheckpointManager::RunSegments()
+{
+  auto runManager = G4RunManager::GetRunManager();
+  auto writer = OutputWriter::Instance();
+  const G4String savedFileName = writer->GetFileName();
+
+  G4double eventsPerSecond = 0.;
+  while (fNextEvent < fTotalEvents) {
+    const G4int nEvents = NextSegmentSize(eventsPerSecond);
+
+    std::ostringstream fileName;
+    fileName << fOutputPrefix << "_part" << fSegment;
+    writer->SetFileName(fileName.str());
+    writer->SetEventIDOffset(fNextEvent);
+
+    G4cout << "=== Checkpoint segment " << fSegment << ": events " << fNextEvent << " - "
+           << fNextEvent + nEvents - 1 << " of " << fTotalEvents << " ===" << G4endl;
+
+    const auto start = std::chrono::steady_clock::now();
+    runManager->BeamOn(nEvents);
+    const G4double seconds = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - start).count();
+
+    auto run = static_cast<const Run*>(runManager->GetCurrentRun());
+    if (!run || run->GetNumberOfEvent() != nEvents) {
+      G4Exception("CheckpointManager::RunSegments()", "Checkpoint_Incomplete", JustWarning,
+                  "구간이 끝까지 처리되지 않아 체크포인트를 갱신하지 않습니다. resume하면 이 구간부터 다시 실행합니다.");
+      break;
+    }
+
+    if (!fTotal) fTotal = new Run(run->GetCoincidenceSettings(), run->IsCoincidenceEnabled());
+    fTotal->Merge(run);
+    fParts.push_back(fileName.str() + writer->GetFileExtension());
+    fNextEvent += nEvents;
+    ++fSegment;
+    fComplete = (fNextEvent >= fTotalEvents);
+    eventsPerSecond = seconds > 0. ? nEvents / seconds : 0.;
+
+    if (!WriteCheckpoint()) {
+      G4Exception("CheckpointManager::RunSegments()", "Checkpoint_WriteError", JustWarning,
+                  ("체크포인트 파일을 쓸 수 없습니다: " + fCheckpointFile).c_str());
+    }
+  }
+
+  writer->SetFileName(savedFileName);
+  writer->SetEventIDOffset(0);
+
+  if (fComplete && fTotal) {
+    G4cout << "=== Checkpointed run complete: " << fTotalEvents << " events in " << fParts.size()
+           << " parts (merge with: cpnr_merge -o " << fOutputPrefix << ".root " << fOutputPrefix << "_part*) ===" << G4endl;
+    fTotal->PrintSummary();
+  }
+}
+
+/**
+ * @brief 진행 상태, 병합 카운터, Master 엔진 상태를 한 파일에 기록합니다.
+ */
+G4bool CheckpointManager::WriteCheckpoint() const
+{
+  const std::string tmpName = fCheckpointFile + ".tmp";
+  {
+    std::ofstream out(tmpName);
+    if (!out) return false;
+
+    out << "# CPNR checkpoint (continue with /myApp/checkpoint/resume)\n";
+    out << "totalEvents " << fTotalEvents << "\n";
+    out << "nextEvent " << fNextEvent << "\n";
+    out << "segment " << fSegment << "\n";
+    out << "complete " << (fComplete ? 1 : 0) << "\n";
+    out << "outputPrefix " << fOutputPrefix << "\n";
+    out << "parts " << fParts.size() << "\n";
+    for (const auto& part : fParts) out << part << "\n";
+    fTotal->WriteCounters(out);
+    out << "engine\n";
+    G4Random::getTheEngine()->put(out);
+    out << "\n";
+
+    out.flush();
+    if (!out) return false;
+  }
+  return std::rename(tmpName.c_str(), fCheckpointFile.c_str()) == 0;
+}
+
+G4bool CheckpointManager::ReadCheckpoint()
+{
+  std::ifstream in(fCheckpointFile);
+  if (!in) return false;
+
+  auto expect = [&in](const char* key) {
+    std::string word;
+    return static_cast<bool>(in >> word) && word == key;
+  };
+
+  std::string header;
+  std::getline(in, header);
+
+  G4int complete = 0;
+  size_t nParts = 0;
+  std::string prefix;
+  if (!expect("totalEvents") || !(in >> fTotalEvents)) return false;
+  if (!expect("nextEvent") || !(in >> fNextEvent)) return false;
+  if (!expect("segment") || !(in >> fSegment)) return false;
+  if (!expect("complete") || !(in >> complete)) return false;
+  if (!expect("outputPrefix") || !(in >> prefix)) return false;
+  if (!expect("parts") || !(in >> nParts)) return false;
+  fComplete = (complete != 0);
+  fOutputPrefix = prefix;
+  fParts.clear();
+  for (size_t i = 0; i < nParts; ++i) {
+    std::string part;
+    if (!(in >> part)) return false;
+    fParts.push_back(part);
+  }
+
+  delete fTotal;
+  fTotal = new Run(Run::CoincidenceSettings());
+  if (!fTotal->ReadCounters(in)) return false;
+
+  if (!expect("engine")) return false;
+  G4Random::getTheEngine()->get(in);
+  return static_cast<bool>(in);
+}
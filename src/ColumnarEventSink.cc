@@ -0,0 +1,107 @@
+#include "ColumnarEventSink.hh"
+#include "EventRecord.hh"
+
+#include <cstdint>
+
+namespace {
+  using columnar::ColumnType;
+  const ColumnType kI = ColumnType::kInt32;
+  const ColumnType kD = ColumnType::kFloat64;
+}
+
+ColumnarEventSink::ColumnarEventSink()
+: fHitsTable(0), fSummaryTable(0), fPMTHitsTable(0), fPMTSummaryTable(0)
+{}
+
+ColumnarEventSink::~ColumnarEventSink()
+{}
+
+G4bool ColumnarEventSink::Open(const G4String& fileName)
+{
+  if (!fWriter.Open(fileName)) return false;
+
+  // 열 순서는 아래 Write()의 열 번호와 일치해야 합니다.
+  fHitsTable = fWriter.AddTable("Hits", {
+    {"eventID", kI}, {"detectorID", kI}, {"trackID", kI}, {"parentID", kI},
+    {"particleCode", kI}, {"processCode", kI}, {"volumeCode", kI},
+    {"x_mm", kD}, {"y_mm", kD}, {"z_mm", kD}, {"time_ns", kD},
+    {"kineticEnergy_MeV", kD}, {"energyDeposit_MeV", kD}, {"weight", kD}});
+  fSummaryTable = fWriter.AddTable("EventSummary", {
+    {"eventID", kI}, {"detectorID", kI}, {"nPrimaries_LS", kI}, {"nSecondaries_LS", kI},
+    {"edep_MeV", kD}, {"visibleEnergy_MeV", kD},
+    {"centroidX_mm", kD}, {"centroidY_mm", kD}, {"centroidZ_mm", kD}, {"firstTime_ns", kD},
+    {"weight", kD}});
+  fPMTHitsTable = fWriter.AddTable("PMTHits", {
+    {"eventID", kI}, {"pmtID", kI}, {"time_ns", kD}, {"weight", kD}});
+  fPMTSummaryTable = fWriter.AddTable("PMTSummary", {
+    {"eventID", kI}, {"pmtID", kI}, {"nPE", kI}, {"weightedPE", kD},
+    {"firstTime_ns", kD}, {"medianTime_ns", kD}, {"lastTime_ns", kD}});
+  return true;
+}
+
+void ColumnarEventSink::Write(const EventRecord& record)
+{
+  const std::int32_t eventID = record.eventID;
+
+  const LSHitBuffer& steps = record.steps;
+  for (size_t i = 0; i < steps.Size(); ++i) {
+    fWriter.Append(fHitsTable, 0, eventID);
+    fWriter.Append(fHitsTable, 1, std::int32_t(steps.GetDetectorID()[i]));
+    fWriter.Append(fHitsTable, 2, std::int32_t(steps.GetTrackID()[i]));
+    fWriter.Append(fHitsTable, 3, std::int32_t(steps.GetParentID()[i]));
+    fWriter.Append(fHitsTable, 4, std::int32_t(steps.GetParticleCode()[i]));
+    fWriter.Append(fHitsTable, 5, std::int32_t(steps.GetProcessCode()[i]));
+    fWriter.Append(fHitsTable, 6, std::int32_t(steps.GetVolumeCode()[i]));
+    fWriter.Append(fHitsTable, 7, steps.GetX()[i]);
+    fWriter.Append(fHitsTable, 8, steps.GetY()[i]);
+    fWriter.Append(fHitsTable, 9, steps.GetZ()[i]);
+    fWriter.Append(fHitsTable, 10, steps.GetTime()[i]);
+    fWriter.Append(fHitsTable, 11, steps.GetKineticEnergy()[i]);
+    fWriter.Append(fHitsTable, 12, steps.GetEnergyDeposit()[i]);
+    fWriter.Append(fHitsTable, 13, steps.GetWeight()[i]);
+    fWriter.EndRow(fHitsTable);
+  }
+
+  for (const auto& unit : record.units) {
+    fWriter.Append(fSummaryTable, 0, eventID);
+    fWriter.Append(fSummaryTable, 1, std::int32_t(unit.detectorID));
+    fWriter.Append(fSummaryTable, 2, std::int32_t(unit.nPrimaries));
+    fWriter.Append(fSummaryTable, 3, std::int32_t(unit.nSecondaries));
+    fWriter.Append(fSummaryTable, 4, unit.edep);
+    fWriter.Append(fSummaryTable, 5, unit.visibleEnergy);
+    fWriter.Append(fSummaryTable, 6, unit.centroidX);
+    fWriter.Append(fSummaryTable, 7, unit.centroidY);
+    fWriter.Append(fSummaryTable, 8, unit.centroidZ);
+    fWriter.Append(fSummaryTable, 9, unit.firstTime);
+    fWriter.Append(fSummaryTable, 10, unit.weight);
+    fWriter.EndRow(fSummaryTable);
+  }
+
+  for (const auto& hit : record.pmtHits) {
+    fWriter.Append(fPMTHitsTable, 0, eventID);
+    fWriter.Append(fPMTHitsTable, 1, std::int32_t(hit.pmtID));
+    fWriter.Append(fPMTHitsTable, 2, hit.time);
+    fWriter.Append(fPMTHitsTable, 3, hit.weight);
+    fWriter.EndRow(fPMTHitsTable);
+  }
+
+  for (const auto& summary : record.pmtSummaries) {
+    fWriter.Append(fPMTSummaryTable, 0, eventID);
+    fWriter.Append(fPMTSummaryTable, 1, std::int32_t(summary.pmtID));
+    fWriter.Append(fPMTSummaryTable, 2, std::int32_t(summary.nPE));
+    fWriter.Append(fPMTSummaryTable, 3, summary.weightedPE);
+    fWriter.Append(fPMTSummaryTable, 4, summary.firstTime);
+    fWriter.Append(fPMTSummaryTable, 5, summary.medianTime);
+    fWriter.Append(fPMTSummaryTable, 6, summary.lastTime);
+    fWriter.EndRow(fPMTSummaryTable);
+  }
+}
+
+void ColumnarEventSink::Close(const std::vector<G4String>& dictionary)
+{
+  fWriter.SetDictionary(std::vector<std::string>(dictionary.begin(), dictionary.end()));
+  if (!fWriter.Close()) {
+    G4Exception("ColumnarEventSink::Close()", "Writer_FileError", JustWarning,
+                "열 단위 출력 파일을 기록하는 중 오류가 발생했습니다.");
+  }
+}
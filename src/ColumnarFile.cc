@@ -0,0 +1,303 @@
+#include "ColumnarFile.hh"
+
+#include <cassert>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace columnar
+{
+
+std::size_t SizeOf(ColumnType type)
+{
+  return type == ColumnType::kInt32 ? sizeof(std::int32_t) : sizeof(double);
+}
+
+// ============================================================================
+// Writer
+// ============================================================================
+
+Writer::Writer(std::size_t rowsPerChunk)
+: fFile(nullptr), fOffset(0), fRowsPerChunk(rowsPerChunk), fGood(false)
+{}
+
+Writer::~Writer()
+{
+  if (fFile) Close();
+}
+
+bool Writer::Open(const std::string& fileName)
+{
+  fFile = std::fopen(fileName.c_str(), "wb");
+  if (!fFile) return false;
+
+  fOffset = 0;
+  fGood = true;
+  fTables.clear();
+  fDictionary.clear();
+  WriteBytes(kMagic, sizeof(kMagic));
+  return fGood;
+}
+
+std::size_t Writer::AddTable(const std::string& name, const std::vector<ColumnSpec>& columns)
+{
+  TableState table;
+  table.name = name;
+  table.columns = columns;
+  table.buffers.resize(columns.size());
+  for (std::size_t c = 0; c < columns.size(); ++c) {
+    table.buffers[c].reserve(fRowsPerChunk * SizeOf(columns[c].type));
+  }
+  fTables.push_back(std::move(table));
+  return fTables.size() - 1;
+}
+
+void Writer::Append(std::size_t table, std::size_t column, std::int32_t value)
+{
+  assert(fTables[table].columns[column].type == ColumnType::kInt32);
+  auto& buffer = fTables[table].buffers[column];
+  const char* bytes = reinterpret_cast<const char*>(&value);
+  buffer.insert(buffer.end(), bytes, bytes + sizeof(value));
+}
+
+void Writer::Append(std::size_t table, std::size_t column, double value)
+{
+  assert(fTables[table].columns[column].type == ColumnType::kFloat64);
+  auto& buffer = fTables[table].buffers[column];
+  const char* bytes = reinterpret_cast<const char*>(&value);
+  buffer.insert(buffer.end(), bytes, bytes + sizeof(value));
+}
+
+void Writer::EndRow(std::size_t table)
+{
+  TableState& state = fTables[table];
+  if (++state.pendingRows >= fRowsPerChunk) FlushChunk(state);
+}
+
+void Writer::FlushChunk(TableState& table)
+{
+  if (table.pendingRows == 0) return;
+
+  Chunk chunk;
+  chunk.rows = table.pendingRows;
+  for (auto& buffer : table.buffers) {
+    chunk.offsets.push_back(fOffset);
+    WriteBytes(buffer.data(), buffer.size());
+    WritePadding();
+    buffer.clear();
+  }
+  table.chunks.push_back(std::move(chunk));
+  table.pendingRows = 0;
+}
+
+void Writer::WriteBytes(const void* data, std::size_t size)
+{
+  if (size == 0) return;
+  if (std::fwrite(data, 1, size, fFile) != size) fGood = false;
+  fOffset += size;
+}
+
+// int32 열 뒤에도 다음 열이 8바이트 경계에서 시작하도록 0으로 채웁니다.
+void Writer::WritePadding()
+{
+  static const char zeros[8] = {0};
+  std::size_t remainder = fOffset % 8;
+  if (remainder != 0) WriteBytes(zeros, 8 - remainder);
+}
+
+namespace {
+  template <typename T>
+  void PutValue(std::vector<char>& out, T value)
+  {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+  }
+
+  void PutString(std::vector<char>& out, const std::string& value)
+  {
+    PutValue<std::uint32_t>(out, static_cast<std::uint32_t>(value.size()));
+    out.insert(out.end(), value.begin(), value.end());
+  }
+}
+
+bool Writer::Close()
+{
+  if (!fFile) return false;
+
+  for (auto& table : fTables) FlushChunk(table);
+
+  std::vector<char> footer;
+  PutValue<std::uint32_t>(footer, static_cast<std::uint32_t>(fTables.size()));
+  for (const auto& table : fTables) {
+    PutString(footer, table.name);
+    PutValue<std::uint32_t>(footer, static_cast<std::uint32_t>(table.columns.size()));
+    for (const auto& column : table.columns) {
+      PutString(footer, column.name);
+      PutValue<std::uint32_t>(footer, static_cast<std::uint32_t>(column.type));
+    }
+    PutValue<std::uint64_t>(footer, table.chunks.size());
+    for (const auto& chunk : table.chunks) {
+      PutValue<std::uint64_t>(footer, chunk.rows);
+      for (auto offset : chunk.offsets) PutValue<std::uint64_t>(footer, offset);
+    }
+  }
+  PutValue<std::uint32_t>(footer, static_cast<std::uint32_t>(fDictionary.size()));
+  for (const auto& name : fDictionary) PutString(footer, name);
+
+  WriteBytes(footer.data(), footer.size());
+  std::uint64_t footerSize = footer.size();
+  WriteBytes(&footerSize, sizeof(footerSize));
+  WriteBytes(kMagic, sizeof(kMagic));
+
+  if (std::fclose(fFile) != 0) fGood = false;
+  fFile = nullptr;
+  return fGood;
+}
+
+// ============================================================================
+// Table / Reader
+// ============================================================================
+
+int Table::FindColumn(const std::string& name) const
+{
+  for (std::size_t c = 0; c < fColumns.size(); ++c) {
+    if (fColumns[c].name == name) return static_cast<int>(c);
+  }
+  return -1;
+}
+
+Reader::Reader()
+: fFd(-1), fBase(nullptr), fSize(0)
+{}
+
+Reader::~Reader()
+{
+  Close();
+}
+
+bool Reader::Fail(const std::string& message)
+{
+  fError = message;
+  Close();
+  return false;
+}
+
+bool Reader::Open(const std::string& fileName)
+{
+  Close();
+
+  fFd = ::open(fileName.c_str(), O_RDONLY);
+  if (fFd < 0) return Fail("cannot open " + fileName);
+
+  struct stat info;
+  if (::fstat(fFd, &info) != 0) return Fail("cannot stat " + fileName);
+  fSize = static_cast<std::size_t>(info.st_size);
+  if (fSize < 2 * sizeof(kMagic) + sizeof(std::uint64_t)) return Fail(fileName + " is too small");
+
+  void* base = ::mmap(nullptr, fSize, PROT_READ, MAP_PRIVATE, fFd, 0);
+  if (base == MAP_FAILED) return Fail("cannot mmap " + fileName);
+  fBase = static_cast<char*>(base);
+  // 분석 패스는 열을 처음부터 끝까지 훑으므로 커널의 미리 읽기를 늘립니다.
+  ::madvise(fBase, fSize, MADV_SEQUENTIAL);
+
+  if (std::memcmp(fBase, kMagic, sizeof(kMagic)) != 0
+      || std::memcmp(fBase + fSize - sizeof(kMagic), kMagic, sizeof(kMagic)) != 0) {
+    return Fail(fileName + " is not a columnar output file (or was not closed)");
+  }
+  if (!ParseFooter()) return Fail(fileName + " has a corrupt footer");
+  return true;
+}
+
+void Reader::Close()
+{
+  if (fBase) ::munmap(fBase, fSize);
+  if (fFd >= 0) ::close(fFd);
+  fBase = nullptr;
+  fFd = -1;
+  fSize = 0;
+  fTables.clear();
+  fDictionary.clear();
+}
+
+bool Reader::ParseFooter()
+{
+  std::uint64_t footerSize = 0;
+  const char* tail = fBase + fSize - sizeof(kMagic) - sizeof(footerSize);
+  std::memcpy(&footerSize, tail, sizeof(footerSize));
+  if (footerSize > static_cast<std::uint64_t>(tail - fBase - sizeof(kMagic))) return false;
+
+  const char* cursor = tail - footerSize;
+  const char* end = tail;
+  bool ok = true;
+
+  auto get = [&](auto& value) {
+    if (static_cast<std::size_t>(end - cursor) < sizeof(value)) { ok = false; return; }
+    std::memcpy(&value, cursor, sizeof(value));
+    cursor += sizeof(value);
+  };
+  auto getString = [&](std::string& value) {
+    std::uint32_t length = 0;
+    get(length);
+    if (!ok || static_cast<std::size_t>(end - cursor) < length) { ok = false; return; }
+    value.assign(cursor, length);
+    cursor += length;
+  };
+
+  std::uint32_t nTables = 0;
+  get(nTables);
+  for (std::uint32_t t = 0; ok && t < nTables; ++t) {
+    Table table;
+    table.fBase = fBase;
+    getString(table.fName);
+
+    std::uint32_t nColumns = 0;
+    get(nColumns);
+    for (std::uint32_t c = 0; ok && c < nColumns; ++c) {
+      ColumnSpec spec;
+      std::uint32_t type = 0;
+      getString(spec.name);
+      get(type);
+      spec.type = static_cast<ColumnType>(type);
+      table.fColumns.push_back(spec);
+    }
+
+    std::uint64_t nChunks = 0;
+    get(nChunks);
+    for (std::uint64_t k = 0; ok && k < nChunks; ++k) {
+      std::uint64_t rows = 0;
+      get(rows);
+      table.fChunkRows.push_back(static_cast<std::size_t>(rows));
+      table.fTotalRows += rows;
+      for (std::uint32_t c = 0; ok && c < nColumns; ++c) {
+        std::uint64_t offset = 0;
+        get(offset);
+        // 열 데이터가 파일 안에 있는지 확인합니다.
+        if (offset + rows * SizeOf(table.fColumns[c].type) > fSize) ok = false;
+        table.fOffsets.push_back(offset);
+      }
+    }
+    fTables.push_back(std::move(table));
+  }
+
+  std::uint32_t nNames = 0;
+  get(nNames);
+  for (std::uint32_t i = 0; ok && i < nNames; ++i) {
+    std::string name;
+    getString(name);
+    fDictionary.push_back(name);
+  }
+  return ok;
+}
+
+const Table* Reader::GetTable(const std::string& name) const
+{
+  for (const auto& table : fTables) {
+    if (table.GetName() == name) return &table;
+  }
+  return nullptr;
+}
+
+} // namespace columnar
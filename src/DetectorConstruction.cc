@@ -4,6 +4,8 @@
 
 // --- Geant4 헤더 파일 ---
 #include "G4RunManager.hh"
+#include "G4GeometryManager.hh"
+#include "G4PhysicalVolumeStore.hh"
 #include "G4NistManager.hh"
 #include "G4Material.hh"
 #include "G4MaterialPropertiesTable.hh"
@@ -23,6 +25,7 @@
 // --- 사용자 정의 클래스 헤더 ---
 #include "PMTSD.hh"
 #include "LSSD.hh"
+#include "ImportanceWorld.hh"
 
 // --- [!리팩토링 핵심!] Messenger 관련 헤더 변경 ---
 // 기존 G4UImessenger 관련 헤더 대신, G4GenericMessenger 헤더 하나만 포함하면 된다.
@@ -34,6 +37,7 @@
 #include <string>
 #include <utility>
 #include <cmath>
+#include <algorithm>
 
 // ============================================================================
 // === [!삭제!] DetectorMessenger 클래스 구현부 ===
@@ -59,7 +63,8 @@ DetectorConstruction::DetectorConstruction()
    fMovablePMTAngle(kDefaultAngle),
    fDetectorDistance(kDefaultDistance),
    fMessenger(nullptr), // [수정] fMessenger 포인터 초기화
-   logicLS(nullptr), logicPhotocathode(nullptr)
+   logicLS(nullptr), logicPhotocathode(nullptr),
+   fPhysWorld(nullptr), fLogicWorld(nullptr), fLogicDetectorUnit(nullptr)
 {
     // 객체 생성 시 수행할 작업을 명확한 순서로 호출한다.
     DefineMaterials();
@@ -77,6 +82,7 @@ DetectorConstruction::~DetectorConstruction()
 {
     // 생성자에서 할당한 메신저 객체의 메모리를 해제한다.
     delete fMessenger;
+    for (auto rotation : fUnitRotations) delete rotation;
 }
 
 /**
@@ -109,6 +115,12 @@ void DetectorConstruction::DefineCommands()
     distCmd.SetUnitCategory("Length"); // 이 명령어의 파라미터가 '길이' 단위임을 지정한다.
     distCmd.SetParameterName("Distance", false);
     distCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+    // 4. 'setRingAngles' 명령어: 링 모드의 유닛별 각도 목록 (deg, 공백 구분). "off"이면 두 유닛 모드로 돌아간다.
+    auto& ringCmd = fMessenger->DeclareMethod("setRingAngles", &DetectorConstruction::SetRingAngles,
+                                              "Ring mode: place one detector unit per angle in deg (space separated), or 'off'.");
+    ringCmd.SetParameterName("Angles", false);
+    ringCmd.SetStates(G4State_PreInit, G4State_Idle);
 }
 
 
@@ -117,18 +129,20 @@ void DetectorConstruction::DefineCommands()
 // ============================================================================
 
 /**
- * @brief 이동형 PMT의 각도를 설정하고, 지오메트리 변경 사실을 RunManager에 알린다.
+ * @brief 이동형 PMT의 각도를 설정하고, 지오메트리가 이미 있으면 검출기 유닛을 제자리에서 옮긴다.
  * @param angle 새로운 각도 값 (단위 포함 가능, 예: 90*deg)
  */
 void DetectorConstruction::SetMovablePMTAngle(G4double angle)
 {
     fMovablePMTAngle = angle;
+    if (!fRingAngles.empty()) {
+        G4Exception("DetectorConstruction::SetMovablePMTAngle()", "Geom_RingMode", JustWarning,
+                    "링 모드에서는 유닛 각도를 /myApp/detector/setRingAngles로 정합니다. 값은 두 유닛 모드에서만 사용됩니다.");
+    }
     
-    // [!!!가장 중요한 부분!!!]
-    // RunManager에게 지오메트리가 변경될 예정임을 알린다.
-    // 이 함수가 호출되면, RunManager는 다음 /run/beamOn 명령이 실행되기 직전에
-    // 자동으로 DetectorConstruction::Construct() 함수를 다시 호출하여 지오메트리를 업데이트한다.
-    G4RunManager::GetRunManager()->GeometryHasBeenModified();
+    // 지오메트리를 다시 만들지 않고 두 유닛 placement의 변환만 갱신한다.
+    // (/run/initialize 전이라면 값만 저장하고 Construct()에서 적용된다.)
+    UpdateDetectorPlacement();
     
     // 사용자 피드백을 위해 변경된 값을 콘솔에 출력한다.
     G4cout << "--> Movable PMT Angle has been set to: " 
@@ -136,20 +150,144 @@ void DetectorConstruction::SetMovablePMTAngle(G4double angle)
 }
 
 /**
- * @brief 선원과 검출기 사이의 거리를 설정하고, 지오메트리 변경 사실을 RunManager에 알린다.
+ * @brief 선원과 검출기 사이의 거리를 설정하고, 지오메트리가 이미 있으면 검출기 유닛을 제자리에서 옮긴다.
  * @param distance 새로운 거리 값 (단위 포함 가능, 예: 20*cm)
  */
 void DetectorConstruction::SetDetectorDistance(G4double distance)
 {
     fDetectorDistance = distance;
     
-    // 위와 동일하게, 지오메트리 변경 사실을 RunManager에 통지한다.
-    G4RunManager::GetRunManager()->GeometryHasBeenModified();
+    // 위와 동일하게, 두 유닛 placement의 변환만 갱신한다.
+    UpdateDetectorPlacement();
     
     G4cout << "--> Detector Distance has been set to: " 
            << G4BestUnit(fDetectorDistance, "Length") << G4endl;
 }
 
+/**
+ * @brief 링 모드의 유닛 각도를 설정한다.
+ * @param angles 공백으로 구분된 각도 목록 (deg), 또는 "off"
+ */
+void DetectorConstruction::SetRingAngles(const G4String& angles)
+{
+    std::vector<G4double> parsed;
+    if (angles != "off") {
+        std::istringstream stream(angles);
+        G4double value = 0.;
+        while (stream >> value) parsed.push_back(value * deg);
+        if (!stream.eof() || parsed.size() < 2) {
+            G4Exception("DetectorConstruction::SetRingAngles()", "Geom_BadRing", JustWarning,
+                        ("링 모드에는 두 개 이상의 각도(deg)가 필요합니다: " + angles).c_str());
+            return;
+        }
+    }
+    fRingAngles = parsed;
+    UpdateDetectorPlacement();
+
+    if (fRingAngles.empty()) {
+        G4cout << "--> Ring mode off: two detector units (fixed + movable)." << G4endl;
+    }
+    else {
+        G4cout << "--> Ring mode: " << fRingAngles.size() << " detector units at";
+        for (auto angle : fRingAngles) G4cout << " " << angle / deg;
+        G4cout << " deg" << G4endl;
+    }
+}
+
+std::vector<G4double> DetectorConstruction::GetUnitAngles() const
+{
+    if (!fRingAngles.empty()) return fRingAngles;
+    return {0., fMovablePMTAngle};
+}
+
+G4double DetectorConstruction::GetOpeningAngle(G4int unitA, G4int unitB) const
+{
+    const std::vector<G4double> angles = GetUnitAngles();
+    if (unitA < 0 || unitB < 0 || unitA >= static_cast<G4int>(angles.size()) || unitB >= static_cast<G4int>(angles.size())) return 0.;
+    // 두 유닛 방향 벡터 사이의 각도이므로 [0, 180°]로 접는다.
+    return std::acos(std::cos(angles[unitB] - angles[unitA]));
+}
+
+/**
+ * @brief 이미 만들어진 지오메트리에서 검출기 유닛들을 현재 각도/거리로 옮긴다.
+ * @details 지오메트리가 닫혀 있으면(첫 /run/beamOn 이후) 유닛들의 어미 볼륨(World)의 voxel만 열고,
+ *          변환을 갱신한 뒤 같은 볼륨만 다시 최적화한다. 유닛 내부의 voxel은 그대로 유지된다.
+ *          Worker의 Navigator는 트랙마다 World부터 위치를 다시 찾으므로 별도의 초기화가 필요 없다.
+ *          링 모드 전환 등으로 유닛 수가 바뀐 경우에는 placement가 추가/삭제되므로,
+ *          RunManager에 알려 다음 런 시작 시 모든 스레드의 Navigator를 초기화하게 한다.
+ *          명령은 Idle 상태에서만 받으므로 Worker가 지오메트리를 읽는 도중에 바뀌지 않는다.
+ */
+void DetectorConstruction::UpdateDetectorPlacement()
+{
+    if (!IsGeometryBuilt()) return;
+
+    auto geometryManager = G4GeometryManager::GetInstance();
+    const G4bool closed = geometryManager->IsGeometryClosed();
+    if (closed) geometryManager->OpenGeometry(fPhysUnits.front());
+
+    const G4bool unitsChanged = PlaceDetectorUnits();
+    // 겹침 검사는 옮긴 유닛들에 대해서만 수행한다.
+    for (auto unit : fPhysUnits) unit->CheckOverlaps();
+
+    if (closed) geometryManager->CloseGeometry(true, false, fPhysUnits.front());
+    if (unitsChanged) G4RunManager::GetRunManager()->GeometryHasBeenModified();
+
+    // 감마 중요도 편향을 쓰면 병렬 세계의 껍질도 유닛을 따라 옮긴다.
+    for (G4int i = 0; i < GetNumberOfParallelWorld(); ++i) {
+        if (auto importanceWorld = dynamic_cast<ImportanceWorld*>(GetParallelWorld(i))) importanceWorld->PlaceCells();
+    }
+}
+
+/**
+ * @brief 보관한 World 포인터가 아직 유효한지 확인한다.
+ * @details /run/reinitializeGeometry true 등으로 저장소가 비워지면 보관한 포인터는 무효이므로,
+ *          그때는 Construct()가 지오메트리를 처음부터 다시 만든다.
+ */
+G4bool DetectorConstruction::IsGeometryBuilt() const
+{
+    if (!fPhysWorld) return false;
+    auto store = G4PhysicalVolumeStore::GetInstance();
+    return std::find(store->begin(), store->end(), fPhysWorld) != store->end();
+}
+
+G4bool DetectorConstruction::PlaceDetectorUnits()
+{
+    const std::vector<G4double> angles = GetUnitAngles();
+    const G4bool ringMode = !fRingAngles.empty();
+    const G4bool unitsChanged = (fPhysUnits.size() != angles.size());
+
+    // 유닛 수가 줄었으면 뒤쪽 placement를 World에서 떼어내고 삭제한다. (삭제 시 저장소에서도 빠진다)
+    while (fPhysUnits.size() > angles.size()) {
+        fLogicWorld->RemoveDaughter(fPhysUnits.back());
+        delete fPhysUnits.back();
+        delete fUnitRotations.back();
+        fPhysUnits.pop_back();
+        fUnitRotations.pop_back();
+    }
+    // 유닛 수가 늘었으면 같은 유닛 논리 볼륨의 placement를 추가한다. (copy number = 유닛 번호)
+    while (fPhysUnits.size() < angles.size()) {
+        const G4int copyNo = static_cast<G4int>(fPhysUnits.size());
+        auto rotation = new G4RotationMatrix();
+        fUnitRotations.push_back(rotation);
+        fPhysUnits.push_back(new G4PVPlacement(rotation, G4ThreeVector(), fLogicDetectorUnit,
+                                               "PhysDetectorUnit", fLogicWorld, false, copyNo, false));
+    }
+
+    // 유닛 i: XZ 평면에서 +X로부터 angles[i]만큼 회전 (두 유닛 모드의 0번은 +X 축 위의 고정 유닛)
+    G4double R_placement = fDetectorDistance + kAssemblyCenterOffset;
+    for (size_t i = 0; i < fPhysUnits.size(); ++i) {
+        G4double theta = angles[i];
+        *fUnitRotations[i] = G4RotationMatrix();
+        fUnitRotations[i]->rotateY(90.*deg + theta);
+        fPhysUnits[i]->SetRotation(fUnitRotations[i]);
+        fPhysUnits[i]->SetTranslation(G4ThreeVector(R_placement * std::cos(theta), 0., R_placement * std::sin(theta)));
+
+        if (ringMode) fPhysUnits[i]->SetName("PhysDetectorUnit_" + std::to_string(i));
+        else fPhysUnits[i]->SetName(i == 0 ? "PhysDetectorUnit_Fixed" : "PhysDetectorUnit_Movable");
+    }
+    return unitsChanged;
+}
+
 
 // ============================================================================
 // === 나머지 함수들 (DefineMaterials, Construct 등) ===
@@ -239,8 +377,8 @@ void DetectorConstruction::ValidateMaterials()
 void DetectorConstruction::DefineOpticalProperties()
 {
     const std::vector<G4double> photonEnergies = {
-        2.38*eV, 2.48*eV, 2.58*eV, 2.70*eV, 2.76*eV, 2.82*eV, 
-        2.92*eV, 2.95*eV, 3.02*eV, 3.10*eV, 3.26*eV, 3.44*eV
+        kPhotonEnergyMin, 2.48*eV, 2.58*eV, 2.70*eV, 2.76*eV, 2.82*eV, 
+        2.92*eV, 2.95*eV, 3.02*eV, 3.10*eV, 3.26*eV, kPhotonEnergyMax
     };
 
     std::vector<G4double> rindex_air(photonEnergies.size(), 1.0);
@@ -287,6 +425,16 @@ void DetectorConstruction::DefineOpticalProperties()
 // === 지오메트리 구성 (Construct) ===
 G4VPhysicalVolume* DetectorConstruction::Construct()
 {
+    // 지오메트리가 이미 있으면 (예: /run/reinitializeGeometry) 새로 만들지 않고 위치만 맞춘다.
+    if (IsGeometryBuilt()) {
+        PlaceDetectorUnits();
+        return fPhysWorld;
+    }
+    // 저장소가 비워졌다면 이전 placement는 이미 삭제되었으므로 회전 행렬만 정리한다.
+    for (auto rotation : fUnitRotations) delete rotation;
+    fUnitRotations.clear();
+    fPhysUnits.clear();
+
     auto solidWorld = new G4Box("SolidWorld", kWorldHalfSize, kWorldHalfSize, kWorldHalfSize);
     auto logicWorld = new G4LogicalVolume(solidWorld, fVacuumMaterial, "LogicWorld");
     auto physWorld = new G4PVPlacement(nullptr, G4ThreeVector(), logicWorld, "PhysWorld", nullptr, false, 0, true);
@@ -308,22 +456,13 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 
     G4LogicalVolume* logicDetectorUnit = ConstructDetectorUnit();
 
-    G4double R_ls_center = fDetectorDistance;
-    G4double theta = fMovablePMTAngle;
-    G4double offset = kAssemblyCenterOffset;
-    G4double R_placement = R_ls_center + offset;
-
-    G4ThreeVector pos_fixed(R_placement, 0, 0);
-    auto rot_fixed = new G4RotationMatrix();
-    rot_fixed->rotateY(90. * deg);
-    new G4PVPlacement(rot_fixed, pos_fixed, logicDetectorUnit, "PhysDetectorUnit_Fixed", logicWorld, false, 0, true);
-
-    G4ThreeVector pos_movable(R_placement * std::cos(theta), 0., R_placement * std::sin(theta));
-    G4double orientation_angle = 90.*deg + theta;
-    auto rot_movable = new G4RotationMatrix();
-    rot_movable->rotateY(orientation_angle);
-    new G4PVPlacement(rot_movable, pos_movable, logicDetectorUnit, "PhysDetectorUnit_Movable", logicWorld, false, 1, true);
+    // 유닛 placement와 회전 행렬은 PlaceDetectorUnits()가 만들고, 이후 각도/거리 변경 시 제자리에서 갱신한다.
+    fLogicWorld = logicWorld;
+    fLogicDetectorUnit = logicDetectorUnit;
+    PlaceDetectorUnits();
+    for (auto unit : fPhysUnits) unit->CheckOverlaps();
 
+    fPhysWorld = physWorld;
     return physWorld;
 }
 
@@ -404,14 +543,23 @@ G4LogicalVolume* DetectorConstruction::ConstructPMT()
 // === Sensitive Detector 및 Field 설정 ===
 void DetectorConstruction::ConstructSDandField()
 {
+    // 지오메트리를 다시 만들 때도 SD는 스레드별로 하나만 유지합니다.
+    // (EventAction 등이 SD 포인터를 보관하므로, 같은 이름의 SD를 새로 만들지 않습니다.)
+    auto sdManager = G4SDManager::GetSDMpointer();
     if (logicLS) {
-        auto lsSD = new LSSD("LSSD");
-        G4SDManager::GetSDMpointer()->AddNewDetector(lsSD);
+        auto lsSD = sdManager->FindSensitiveDetector("LSSD", false);
+        if (!lsSD) {
+            lsSD = new LSSD("LSSD");
+            sdManager->AddNewDetector(lsSD);
+        }
         SetSensitiveDetector(logicLS, lsSD);
     }
     if (logicPhotocathode) {
-        auto pmtSD = new PMTSD("PMTSD");
-        G4SDManager::GetSDMpointer()->AddNewDetector(pmtSD);
+        auto pmtSD = sdManager->FindSensitiveDetector("PMTSD", false);
+        if (!pmtSD) {
+            pmtSD = new PMTSD("PMTSD");
+            sdManager->AddNewDetector(pmtSD);
+        }
         SetSensitiveDetector(logicPhotocathode, pmtSD);
     }
 }
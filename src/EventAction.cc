@@ -4,90 +4,332 @@
 #include "G4HCofThisEvent.hh"
 #include "G4SDManager.hh"
 #include "G4SystemOfUnits.hh"
+#include "G4GenericMessenger.hh"
+#include "G4RunManager.hh"
 
-// 데이터 저장을 위해 Hit 클래스 헤더들을 포함합니다.
-#include "LSHit.hh"
+#include "LSSD.hh"
 #include "PMTHit.hh"
+#include "RunAction.hh"
+#include "OutputWriter.hh"
+#include "Run.hh"
+#include "EventWeightInfo.hh"
 
-// std::set을 사용하여 중복된 트랙을 효율적으로 제거하기 위해 헤더를 포함합니다.
-#include <set>
+#include <algorithm>
 
-EventAction::EventAction() : G4UserEventAction() {}
-EventAction::~EventAction() {}
+EventAction::EventAction(RunAction* runAction)
+: G4UserEventAction(), fRunAction(runAction),
+  fWriteSteps(true), fWritePMTHits(true), fWritePMTSummary(false),
+  fPMTTimeBins(0), fPMTTimeBinWidth(1.*ns),
+  fTriggerEnabled(false), fTriggerPEThreshold(1.), fTriggerWindow(10.*ns), fTriggerMajority(2),
+  fLSSD(nullptr), fPMTHcID(-1), fMessenger(nullptr), fTriggerMessenger(nullptr)
+{
+  DefineCommands();
+}
+
+EventAction::~EventAction()
+{
+  delete fMessenger;
+  delete fTriggerMessenger;
+}
+
+void EventAction::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/myApp/output/", "Output content control.");
+
+  auto& stepsCmd = fMessenger->DeclareProperty("writeSteps", fWriteSteps,
+                                               "Write the per-step Hits tree (EventSummary is always written).");
+  stepsCmd.SetParameterName("Flag", false);
+  stepsCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+  auto& pmtCmd = fMessenger->DeclareMethod("pmtOutput", &EventAction::SetPMTOutput,
+                                           "PMT output: hits (one row per photoelectron), summary (one row per PMT), both, or none.");
+  pmtCmd.SetParameterName("Mode", false);
+  pmtCmd.SetCandidates("hits summary both none");
+  pmtCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+  auto& binsCmd = fMessenger->DeclareProperty("pmtTimeBins", fPMTTimeBins,
+                                              "Number of arrival-time histogram bins in PMTSummary (0 = no histogram).");
+  binsCmd.SetParameterName("NBins", false);
+  binsCmd.SetRange("NBins>=0");
+  binsCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+  auto& widthCmd = fMessenger->DeclarePropertyWithUnit("pmtTimeBinWidth", "ns", fPMTTimeBinWidth,
+                                                       "Bin width of the PMTSummary arrival-time histogram.");
+  widthCmd.SetParameterName("Width", false);
+  widthCmd.SetRange("Width>0.");
+  widthCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+  fTriggerMessenger = new G4GenericMessenger(this, "/myApp/trigger/", "Write trigger: only events passing it are written.");
+
+  auto& enableCmd = fTriggerMessenger->DeclareProperty("enable", fTriggerEnabled,
+                                                       "Write only events that pass the PMT majority trigger.");
+  enableCmd.SetParameterName("Flag", false);
+  enableCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+  auto& thresholdCmd = fTriggerMessenger->DeclareProperty("peThreshold", fTriggerPEThreshold,
+                                                          "Weighted photoelectron count at which a PMT triggers.");
+  thresholdCmd.SetParameterName("NPE", false);
+  thresholdCmd.SetRange("NPE>0.");
+  thresholdCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+  auto& windowCmd = fTriggerMessenger->DeclarePropertyWithUnit("window", "ns", fTriggerWindow,
+                                                               "Time window in which the triggered PMTs are counted.");
+  windowCmd.SetParameterName("Window", false);
+  windowCmd.SetRange("Window>0.");
+  windowCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+  auto& majorityCmd = fTriggerMessenger->DeclareProperty("majority", fTriggerMajority,
+                                                         "Number of triggered PMTs required within the window.");
+  majorityCmd.SetParameterName("N", false);
+  majorityCmd.SetRange("N>=1");
+  majorityCmd.SetStates(G4State_PreInit, G4State_Idle);
+}
+
+void EventAction::SetPMTOutput(const G4String& mode)
+{
+  fWritePMTHits = (mode == "hits" || mode == "both");
+  fWritePMTSummary = (mode == "summary" || mode == "both");
+}
 
 /**
  * @brief 각 이벤트가 끝날 때마다 호출되는 함수입니다.
  * @param event 현재 이벤트에 대한 정보를 담고 있는 G4Event 객체 포인터
  *
- * 이 함수는 LSSD와 PMTSD에서 수집된 HitsCollection을 분석하여,
- * 1) 이벤트 요약 정보(LS 입자 수)를 계산하여 'EventSummary' TTree에 저장하고,
- * 2) 상세 Hit 정보(에너지 증착)를 'Hits' TTree에 저장하며,
- * 3) PMT에서 검출된 광자 정보를 'PMTHits' TTree에 저장하는 역할을 수행합니다.
+ * 이 함수는 LSSD의 Hit 버퍼와 PMTSD의 HitsCollection을 분석하여 EventRecord를 만든 뒤,
+ * 1) 유닛별 요약 정보(입자 수, 에너지, 가시 에너지, 중심, 첫 증착 시간)를 'EventSummary' TTree에 저장하고,
+ * 2) 상세 Hit 정보(에너지 증착)를 'Hits' TTree에 저장하며 (/myApp/output/writeSteps),
+ * 3) PMT에서 검출된 광자 정보를 'PMTHits' TTree 및/또는 PMT별 요약을 'PMTSummary' TTree에 저장하는 역할을 수행합니다.
+ * 비동기 출력(/myApp/writer/setAsync)이 켜져 있으면 레코드를 OutputWriter의 큐에 넘기고 바로 반환합니다.
+ * 기록 트리거를 통과하지 못한 이벤트는 레코드를 만들지 않습니다.
  */
 void EventAction::EndOfEventAction(const G4Event* event)
 {
-  auto analysisManager = G4AnalysisManager::Instance();
-  G4int eventID = event->GetEventID();
-
-  // --- LS 데이터 처리 (LSHitsCollection) ---
-  G4int lsHcID = G4SDManager::GetSDMpointer()->GetCollectionID("LSHitsCollection");
-  if (lsHcID >= 0) {
-    auto lsHitsCollection = static_cast<LSHitsCollection*>(event->GetHCofThisEvent()->GetHC(lsHcID));
-    if (lsHitsCollection && lsHitsCollection->entries() > 0) {
-      // 1-1. 이벤트 요약 정보 계산
+  // SD 포인터와 컬렉션 ID는 런 도중 바뀌지 않으므로 처음 한 번만 조회합니다.
+  if (!fLSSD) {
+    fLSSD = static_cast<LSSD*>(G4SDManager::GetSDMpointer()->FindSensitiveDetector("LSSD", false));
+    fPMTHcID = G4SDManager::GetSDMpointer()->GetCollectionID("PMTHitsCollection");
+  }
+
+  if (!PassesTrigger(event)) return;
+
+  auto writer = OutputWriter::Instance();
+  if (writer->IsRunning()) {
+    EventRecord* record = writer->Acquire();
+    BuildRecord(event, *record);
+    writer->Push(record);
+  }
+  else {
+    fRecord.Clear();
+    BuildRecord(event, fRecord);
+    FillNtuples(fRecord);
+  }
+}
+
+/**
+ * @brief 시간 창 안에서 트리거된 PMT 수가 majority 이상인지 판정하고, 결과를 Run 카운터에 더합니다.
+ */
+G4bool EventAction::PassesTrigger(const G4Event* event)
+{
+  // 중요도 편향에서는 분할 사본의 광전자가 한 이벤트에 더해지므로 트리거를 적용하지 않습니다. (RunAction의 경고)
+  if (!fTriggerEnabled || fRunAction->IsImportanceBiasing()) return true;
+
+  // 트리거 판별기는 Run과 공유하므로, 뒤이은 Run::RecordEvent는 정렬된 광전자(와 같은 문턱이면 트리거 목록)를 다시 씁니다.
+  auto run = static_cast<Run*>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+  if (!run) return true;
+  auto hce = event->GetHCofThisEvent();
+  PMTTrigger& trigger = run->GetTrigger();
+  trigger.Load((hce && fPMTHcID >= 0) ? static_cast<PMTHitsCollection*>(hce->GetHC(fPMTHcID)) : nullptr,
+               event->GetEventID());
+  trigger.Evaluate(fTriggerPEThreshold);
+  G4bool accepted = trigger.GetMultiplicity(fTriggerWindow) >= fTriggerMajority;
+
+  run->CountTrigger(accepted);
+  return accepted;
+}
+
+void EventAction::BuildRecord(const G4Event* event, EventRecord& record)
+{
+  // 체크포인트로 나눈 런에서는 앞 구간의 이벤트 수만큼 더해 전역 이벤트 번호를 기록합니다.
+  record.eventID = OutputWriter::Instance()->GetEventIDOffset() + event->GetEventID();
+
+  // --- LS 데이터 처리 (LSSD의 유닛별 요약과 열 단위 Hit 버퍼) ---
+  if (fLSSD && fLSSD->GetHitBuffer().Size() > 0) {
+    const LSHitBuffer& hits = fLSSD->GetHitBuffer();
+    const size_t nHits = hits.Size();
+    const auto& detectorID = hits.GetDetectorID();
+    const auto& trackID = hits.GetTrackID();
+    const auto& parentID = hits.GetParentID();
+
+    // 1-1. 유닛별 고유 트랙 수 계산
+    // 트랙 ID(양수)의 부호로 1차/2차를 표시한 (유닛, 트랙) 쌍을 정렬+중복 제거합니다.
+    // 작업 버퍼를 재사용하므로 std::set과 달리 노드 할당이 없습니다.
+    fTrackKeys.clear();
+    for (size_t i = 0; i < nHits; ++i) {
+      fTrackKeys.emplace_back(detectorID[i], parentID[i] == 0 ? -trackID[i] : trackID[i]);
+    }
+    std::sort(fTrackKeys.begin(), fTrackKeys.end());
+    auto last = std::unique(fTrackKeys.begin(), fTrackKeys.end());
+
+    // 1-2. EventSummary: 증착이 있는 유닛마다 한 행
+    // weight x edep가 가중 증착 합이 되도록, 이벤트 가중치(방향 강제)에 트랙 가중치의 에너지 가중 평균을 곱합니다.
+    // 중요도 편향에서는 유닛 합이 분할 사본들의 증착을 더한 값이라 이벤트의 에너지가 아니므로 에너지 열을 -1로 둡니다.
+    const G4double eventWeight = EventWeightInfo::EventWeight(event);
+    const G4bool energyValid = !fRunAction->IsImportanceBiasing();
+    const auto& summaries = fLSSD->GetUnitSummaries();
+    auto key = fTrackKeys.begin();
+    for (size_t unit = 0; unit < summaries.size(); ++unit) {
+      const LSSD::UnitSummary& summary = summaries[unit];
+      if (summary.edep <= 0.) continue;
+
       G4int primaryCount = 0;
       G4int secondaryCount = 0;
-      std::set<G4int> countedTracks;
-
-      for (size_t i = 0; i < lsHitsCollection->entries(); ++i) {
-        auto hit = (*lsHitsCollection)[i];
-        G4int trackID = hit->GetTrackID();
-        if (countedTracks.find(trackID) == countedTracks.end()) {
-          countedTracks.insert(trackID);
-          if (hit->GetParentID() == 0) primaryCount++;
-          else secondaryCount++;
-        }
-      }
-      
-      // 1-2. EventSummary TTree (Ntuple ID=1)에 저장
-      analysisManager->FillNtupleIColumn(1, 0, eventID);
-      analysisManager->FillNtupleIColumn(1, 1, primaryCount);
-      analysisManager->FillNtupleIColumn(1, 2, secondaryCount);
-      analysisManager->AddNtupleRow(1);
-
-      // 1-3. Hits TTree (Ntuple ID=0)에 상세 정보 저장
-      for (size_t i = 0; i < lsHitsCollection->entries(); ++i) {
-        auto hit = (*lsHitsCollection)[i];
-        analysisManager->FillNtupleIColumn(0, 0, eventID);
-        analysisManager->FillNtupleIColumn(0, 1, hit->GetTrackID());
-        analysisManager->FillNtupleIColumn(0, 2, hit->GetParentID());
-        analysisManager->FillNtupleSColumn(0, 3, hit->GetParticleName());
-        analysisManager->FillNtupleSColumn(0, 4, hit->GetProcessName());
-        analysisManager->FillNtupleSColumn(0, 5, hit->GetVolumeName());
-        analysisManager->FillNtupleDColumn(0, 6, hit->GetPosition().x() / mm);
-        analysisManager->FillNtupleDColumn(0, 7, hit->GetPosition().y() / mm);
-        analysisManager->FillNtupleDColumn(0, 8, hit->GetPosition().z() / mm);
-        analysisManager->FillNtupleDColumn(0, 9, hit->GetTime());
-        analysisManager->FillNtupleDColumn(0, 10, hit->GetKineticEnergy());
-        analysisManager->FillNtupleDColumn(0, 11, hit->GetEnergyDeposit());
-        analysisManager->AddNtupleRow(0);
+      while (key != last && key->first < static_cast<G4int>(unit)) ++key;
+      for (; key != last && key->first == static_cast<G4int>(unit); ++key) {
+        if (key->second < 0) primaryCount++;
+        else secondaryCount++;
       }
+
+      G4ThreeVector centroid = summary.weightedPosition / summary.edep;
+      record.units.push_back({static_cast<G4int>(unit), primaryCount, secondaryCount,
+                              energyValid ? summary.edep / MeV : -1., energyValid ? summary.visibleEdep / MeV : -1.,
+                              centroid.x() / mm, centroid.y() / mm, centroid.z() / mm,
+                              summary.firstTime / ns,
+                              energyValid ? eventWeight * summary.weightedEdep / summary.edep : eventWeight});
     }
+
+    // 1-3. Hits: 스텝별 상세 정보 (선택, 버퍼는 이미 mm, ns, MeV 단위이며 복사는 레코드의 용량을 재사용)
+    if (fWriteSteps) record.steps = hits;
   }
-  
+
   // --- PMT 데이터 처리 (PMTHitsCollection) ---
-  G4int pmtHcID = G4SDManager::GetSDMpointer()->GetCollectionID("PMTHitsCollection");
-  if (pmtHcID >= 0) {
-    auto pmtHitsCollection = static_cast<PMTHitsCollection*>(event->GetHCofThisEvent()->GetHC(pmtHcID));
+  if (fPMTHcID >= 0) {
+    auto pmtHitsCollection = static_cast<PMTHitsCollection*>(event->GetHCofThisEvent()->GetHC(fPMTHcID));
     if (pmtHitsCollection && pmtHitsCollection->entries() > 0) {
-      // 모든 PMT Hit을 순회하며 TTree에 직접 저장
-      for (size_t i = 0; i < pmtHitsCollection->entries(); ++i) {
-        auto pmtHit = (*pmtHitsCollection)[i];
-        analysisManager->FillNtupleIColumn(2, 0, eventID);
-        analysisManager->FillNtupleIColumn(2, 1, pmtHit->GetPMTID());
-        analysisManager->FillNtupleDColumn(2, 2, pmtHit->GetTime());
-        analysisManager->AddNtupleRow(2);
+      // 요약은 컬렉션을 제자리 정렬하므로, 광자별 행도 (PMT, 시간) 순으로 기록됩니다.
+      if (fWritePMTSummary) BuildPMTSummary(*pmtHitsCollection->GetVector(), record);
+
+      if (fWritePMTHits) {
+        for (size_t i = 0; i < pmtHitsCollection->entries(); ++i) {
+          auto pmtHit = (*pmtHitsCollection)[i];
+          record.pmtHits.push_back({pmtHit->GetPMTID(), pmtHit->GetTime(), pmtHit->GetWeight()});
+        }
       }
     }
   }
 }
+
+/**
+ * @brief PMT별 광전자 요약을 레코드에 추가합니다.
+ *
+ * Hit 포인터 벡터를 (PMT 번호, 시간) 순으로 제자리 정렬하므로 추가 메모리가 필요 없고,
+ * 정렬 후에는 같은 PMT의 Hit이 시간 순으로 연속되어 첫/중앙/마지막 시간을 바로 읽을 수 있습니다.
+ * 히스토그램은 각 PMT의 첫 광전자 시간을 기준으로 합니다. (방사성 붕괴 시각이 이벤트마다 크게 다르므로)
+ */
+void EventAction::BuildPMTSummary(std::vector<PMTHit*>& hits, EventRecord& record)
+{
+  std::sort(hits.begin(), hits.end(), [](const PMTHit* a, const PMTHit* b) {
+    if (a->GetPMTID() != b->GetPMTID()) return a->GetPMTID() < b->GetPMTID();
+    return a->GetTime() < b->GetTime();
+  });
+
+  const G4double binWidth = fPMTTimeBinWidth / ns;
+  record.pmtTimeBins = fPMTTimeBins;
+
+  auto first = hits.begin();
+  while (first != hits.end()) {
+    G4int pmtID = (*first)->GetPMTID();
+    auto last = first;
+    G4double weightSum = 0.;
+    while (last != hits.end() && (*last)->GetPMTID() == pmtID) {
+      weightSum += (*last)->GetWeight();
+      ++last;
+    }
+
+    const size_t nPE = last - first;
+    G4double firstTime = (*first)->GetTime();
+    G4double lastTime = (*(last - 1))->GetTime();
+    G4double medianTime = (nPE % 2 == 1) ? first[nPE / 2]->GetTime()
+                        : 0.5 * (first[nPE / 2 - 1]->GetTime() + first[nPE / 2]->GetTime());
+    record.pmtSummaries.push_back({pmtID, static_cast<G4int>(nPE), weightSum, firstTime, medianTime, lastTime});
+
+    size_t offset = record.pmtTimeHist.size();
+    record.pmtTimeHist.resize(offset + fPMTTimeBins, 0.);
+    for (auto it = first; fPMTTimeBins > 0 && it != last; ++it) {
+      G4int bin = static_cast<G4int>(((*it)->GetTime() - firstTime) / binWidth);
+      if (bin < fPMTTimeBins) record.pmtTimeHist[offset + bin] += (*it)->GetWeight(); // 범위 밖의 늦은 광전자는 버립니다.
+    }
+
+    first = last;
+  }
+}
+
+/**
+ * @brief 동기 모드: 레코드를 이 스레드의 G4 Ntuple에 기록합니다. (Run 종료 시 Master로 병합)
+ */
+void EventAction::FillNtuples(const EventRecord& record)
+{
+  auto analysisManager = G4AnalysisManager::Instance();
+  const G4int eventID = record.eventID;
+
+  // EventSummary TTree (Ntuple ID=1)
+  for (const auto& unit : record.units) {
+    analysisManager->FillNtupleIColumn(1, 0, eventID);
+    analysisManager->FillNtupleIColumn(1, 1, unit.detectorID);
+    analysisManager->FillNtupleIColumn(1, 2, unit.nPrimaries);
+    analysisManager->FillNtupleIColumn(1, 3, unit.nSecondaries);
+    analysisManager->FillNtupleDColumn(1, 4, unit.edep);
+    analysisManager->FillNtupleDColumn(1, 5, unit.visibleEnergy);
+    analysisManager->FillNtupleDColumn(1, 6, unit.centroidX);
+    analysisManager->FillNtupleDColumn(1, 7, unit.centroidY);
+    analysisManager->FillNtupleDColumn(1, 8, unit.centroidZ);
+    analysisManager->FillNtupleDColumn(1, 9, unit.firstTime);
+    analysisManager->FillNtupleDColumn(1, 10, unit.weight);
+    analysisManager->AddNtupleRow(1);
+  }
+
+  // Hits TTree (Ntuple ID=0)
+  const LSHitBuffer& steps = record.steps;
+  for (size_t i = 0; i < steps.Size(); ++i) {
+    analysisManager->FillNtupleIColumn(0, 0, eventID);
+    analysisManager->FillNtupleIColumn(0, 1, steps.GetDetectorID()[i]);
+    analysisManager->FillNtupleIColumn(0, 2, steps.GetTrackID()[i]);
+    analysisManager->FillNtupleIColumn(0, 3, steps.GetParentID()[i]);
+    analysisManager->FillNtupleIColumn(0, 4, steps.GetParticleCode()[i]);
+    analysisManager->FillNtupleIColumn(0, 5, steps.GetProcessCode()[i]);
+    analysisManager->FillNtupleIColumn(0, 6, steps.GetVolumeCode()[i]);
+    analysisManager->FillNtupleDColumn(0, 7, steps.GetX()[i]);
+    analysisManager->FillNtupleDColumn(0, 8, steps.GetY()[i]);
+    analysisManager->FillNtupleDColumn(0, 9, steps.GetZ()[i]);
+    analysisManager->FillNtupleDColumn(0, 10, steps.GetTime()[i]);
+    analysisManager->FillNtupleDColumn(0, 11, steps.GetKineticEnergy()[i]);
+    analysisManager->FillNtupleDColumn(0, 12, steps.GetEnergyDeposit()[i]);
+    analysisManager->FillNtupleDColumn(0, 13, steps.GetWeight()[i]);
+    analysisManager->AddNtupleRow(0);
+  }
+
+  // PMTSummary TTree (Ntuple ID=4), 히스토그램 열은 RunAction이 소유한 벡터에 연결되어 있습니다.
+  std::vector<G4double>& timeHist = fRunAction->GetPMTTimeHistogram();
+  for (size_t row = 0; row < record.pmtSummaries.size(); ++row) {
+    const auto& summary = record.pmtSummaries[row];
+    auto first = record.pmtTimeHist.begin() + row * record.pmtTimeBins;
+    timeHist.assign(first, first + record.pmtTimeBins);
+
+    analysisManager->FillNtupleIColumn(4, 0, eventID);
+    analysisManager->FillNtupleIColumn(4, 1, summary.pmtID);
+    analysisManager->FillNtupleIColumn(4, 2, summary.nPE);
+    analysisManager->FillNtupleDColumn(4, 3, summary.weightedPE);
+    analysisManager->FillNtupleDColumn(4, 4, summary.firstTime);
+    analysisManager->FillNtupleDColumn(4, 5, summary.medianTime);
+    analysisManager->FillNtupleDColumn(4, 6, summary.lastTime);
+    analysisManager->AddNtupleRow(4);
+  }
+
+  // PMTHits TTree (Ntuple ID=2)
+  for (const auto& hit : record.pmtHits) {
+    analysisManager->FillNtupleIColumn(2, 0, eventID);
+    analysisManager->FillNtupleIColumn(2, 1, hit.pmtID);
+    analysisManager->FillNtupleDColumn(2, 2, hit.time);
+    analysisManager->FillNtupleDColumn(2, 3, hit.weight);
+    analysisManager->AddNtupleRow(2);
+  }
+}
@@ -0,0 +1,22 @@
+#include "EventWeightInfo.hh"
+
+#include "G4Event.hh"
+#include "G4ios.hh"
+
+EventWeightInfo::EventWeightInfo(G4double weight)
+: G4VUserEventInformation(), fWeight(weight)
+{}
+
+EventWeightInfo::~EventWeightInfo()
+{}
+
+void EventWeightInfo::Print() const
+{
+  G4cout << "EventWeightInfo: weight " << fWeight << G4endl;
+}
+
+G4double EventWeightInfo::EventWeight(const G4Event* event)
+{
+  auto info = event ? dynamic_cast<const EventWeightInfo*>(event->GetUserInformation()) : nullptr;
+  return info ? info->GetWeight() : 1.;
+}
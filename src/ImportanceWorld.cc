@@ -0,0 +1,127 @@
+#include "ImportanceWorld.hh"
+#include "DetectorConstruction.hh"
+
+#include "G4GeometryCell.hh"
+#include "G4GeometryManager.hh"
+#include "G4IStore.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Orb.hh"
+#include "G4PVPlacement.hh"
+#include "G4VPhysicalVolume.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+  // 가장 안쪽 껍질이 감싸야 하는 LS 병의 외접구 반지름 (LS 중심 기준) + 여유 1 mm
+  const G4double kInnerRadius = std::sqrt(DetectorConstruction::kBottleOuterRadius * DetectorConstruction::kBottleOuterRadius
+                                          + DetectorConstruction::kLSHalfZ * DetectorConstruction::kLSHalfZ) + 1.*mm;
+}
+
+ImportanceWorld::ImportanceWorld(const DetectorConstruction* detector, const Settings& settings)
+: G4VUserParallelWorld(kWorldName), fDetector(detector), fSettings(settings),
+  fGhostWorld(nullptr), fOuterShell(nullptr), fActiveCells(0)
+{}
+
+ImportanceWorld::~ImportanceWorld()
+{}
+
+/**
+ * @brief 껍질 논리 볼륨을 바깥부터 안쪽으로 포개어 만들고, 유닛마다 바깥 껍질을 배치합니다. (Master에서 한 번)
+ * 껍질 반지름은 바깥 반지름에서 LS 외접구 반지름까지 등비로 줄어듭니다.
+ */
+void ImportanceWorld::Construct()
+{
+  fGhostWorld = GetWorld();
+
+  const G4int nShells = std::max(1, fSettings.shells);
+  G4double outerRadius = fSettings.outerRadius;
+  if (outerRadius <= kInnerRadius) {
+    G4Exception("ImportanceWorld::Construct()", "Importance_Radius", JustWarning,
+                "중요도 껍질의 바깥 반지름이 LS 외접구보다 작아, LS를 감싸는 껍질 하나만 만듭니다.");
+    outerRadius = kInnerRadius;
+  }
+
+  G4LogicalVolume* mother = nullptr;
+  for (G4int k = 0; k < nShells; ++k) {
+    const G4double radius = (nShells == 1) ? outerRadius
+                          : outerRadius * std::pow(kInnerRadius / outerRadius, static_cast<G4double>(k) / (nShells - 1));
+    const G4String name = "ImportanceShell" + std::to_string(k);
+    auto logical = new G4LogicalVolume(new G4Orb("Solid" + name, radius), nullptr, "Logic" + name);
+    if (!mother) fOuterShell = logical;
+    else fInnerShells.push_back(new G4PVPlacement(nullptr, G4ThreeVector(), logical, "Phys" + name, mother, false, 0, false));
+    mother = logical;
+  }
+
+  PlaceCells();
+}
+
+/**
+ * @brief Worker 스레드 초기화 시 호출됩니다. 스레드별 중요도 저장소에도 같은 셀이 있도록 확인합니다.
+ * (이미 등록된 셀은 건너뛰므로 공유 저장소에서는 아무것도 쓰지 않습니다.)
+ */
+void ImportanceWorld::ConstructSD()
+{
+  RegisterImportances();
+}
+
+void ImportanceWorld::PlaceCells()
+{
+  if (!fGhostWorld || !fOuterShell) return;
+
+  const std::vector<G4double> angles = fDetector->GetUnitAngles();
+  const G4double distance = fDetector->GetDetectorDistance();
+  G4LogicalVolume* ghostLogical = fGhostWorld->GetLogicalVolume();
+
+  auto geometryManager = G4GeometryManager::GetInstance();
+  const G4bool closed = geometryManager->IsGeometryClosed() && !fCells.empty();
+  if (closed) geometryManager->OpenGeometry(fCells.front());
+
+  // 필요한 유닛 수만큼 바깥 껍질을 World에 붙이거나(새로 만들거나) 뗍니다.
+  while (fActiveCells > angles.size()) ghostLogical->RemoveDaughter(fCells[--fActiveCells]);
+  while (fActiveCells < angles.size()) {
+    if (fActiveCells < fCells.size()) ghostLogical->AddDaughter(fCells[fActiveCells]);
+    else fCells.push_back(new G4PVPlacement(nullptr, G4ThreeVector(), fOuterShell, "ImportanceCell", ghostLogical,
+                                            false, static_cast<G4int>(fActiveCells), false));
+    ++fActiveCells;
+  }
+
+  // 껍질 중심 = LS 중심 (선원에서 거리 distance, XZ 평면의 유닛 각도)
+  for (size_t i = 0; i < fActiveCells; ++i) {
+    fCells[i]->SetTranslation(G4ThreeVector(distance * std::cos(angles[i]), 0., distance * std::sin(angles[i])));
+  }
+
+  if (closed) geometryManager->CloseGeometry(true, false, fCells.front());
+  RegisterImportances();
+
+  // 병렬 세계의 셀이 서로 겹치면 내비게이션이 정의되지 않으므로 알립니다.
+  G4double outerRadius = std::max(fSettings.outerRadius, kInnerRadius);
+  for (size_t a = 0; a < angles.size(); ++a) {
+    for (size_t b = a + 1; b < angles.size(); ++b) {
+      const G4double separation = 2. * distance * std::sin(0.5 * fDetector->GetOpeningAngle(static_cast<G4int>(a), static_cast<G4int>(b)));
+      if (separation < 2. * outerRadius) {
+        G4Exception("ImportanceWorld::PlaceCells()", "Importance_Overlap", JustWarning,
+                    "두 유닛의 중요도 껍질이 겹칩니다. /myApp/physics/importanceRadius를 줄이십시오.");
+        return;
+      }
+    }
+  }
+}
+
+void ImportanceWorld::RegisterImportances()
+{
+  if (!fGhostWorld) return;
+  G4IStore* store = G4IStore::GetInstance(kWorldName);
+
+  auto add = [store](G4double importance, const G4VPhysicalVolume& volume, G4int copyNo) {
+    if (!store->IsKnown(G4GeometryCell(volume, copyNo))) store->AddImportanceGeometryCell(importance, volume, copyNo);
+  };
+
+  add(1., *fGhostWorld, 0);
+  G4double importance = fSettings.ratio;
+  for (size_t i = 0; i < fCells.size(); ++i) add(importance, *fCells[i], static_cast<G4int>(i));
+  for (auto shell : fInnerShells) {
+    importance *= fSettings.ratio;
+    add(importance, *shell, 0);
+  }
+}
@@ -0,0 +1,43 @@
+#include "LSHitBuffer.hh"
+
+LSHitBuffer::LSHitBuffer()
+{
+  // 일반적인 Co-60 이벤트의 LS 스텝 수보다 넉넉하게 잡아, 초기 재할당을 줄입니다.
+  Reserve(1024);
+}
+
+LSHitBuffer::~LSHitBuffer()
+{}
+
+/**
+ * @brief 모든 열의 길이를 0으로 되돌립니다. std::vector::clear()는 용량을 유지하므로 메모리를 해제하지 않습니다.
+ */
+void LSHitBuffer::Clear()
+{
+  fDetectorID.clear();
+  fTrackID.clear();
+  fParentID.clear();
+  fParticleCode.clear();
+  fProcessCode.clear();
+  fVolumeCode.clear();
+  fX.clear(); fY.clear(); fZ.clear();
+  fTime.clear();
+  fKineticEnergy.clear();
+  fEnergyDeposit.clear();
+  fWeight.clear();
+}
+
+void LSHitBuffer::Reserve(size_t n)
+{
+  fDetectorID.reserve(n);
+  fTrackID.reserve(n);
+  fParentID.reserve(n);
+  fParticleCode.reserve(n);
+  fProcessCode.reserve(n);
+  fVolumeCode.reserve(n);
+  fX.reserve(n); fY.reserve(n); fZ.reserve(n);
+  fTime.reserve(n);
+  fKineticEnergy.reserve(n);
+  fEnergyDeposit.reserve(n);
+  fWeight.reserve(n);
+}
@@ -1,52 +1,191 @@
 #include "LSSD.hh"
+#include "PMTSD.hh"
 #include "G4HCofThisEvent.hh"
 #include "G4Step.hh"
 #include "G4Track.hh"
 #include "G4VProcess.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4SDManager.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4Material.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4NavigationHistory.hh"
+#include "G4LossTableManager.hh"
+#include "G4EmSaturation.hh"
+#include "G4Poisson.hh"
+#include "G4Log.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+
+#include "OpticalMapManager.hh"
+#include "NameDictionary.hh"
 
 LSSD::LSSD(const G4String& name)
-: G4VSensitiveDetector(name), fHitsCollection(nullptr)
+: G4VSensitiveDetector(name),
+  fConstantsCached(false), fBirksConstant(nullptr),
+  fPMTSD(nullptr), fScintYield(0.), fScintTimeConstant(0.)
 {
-  collectionName.insert("LSHitsCollection");
+  fPrimaryProcessCode = NameDictionary::Instance()->Intern("primary");
 }
 
 LSSD::~LSSD()
 {}
 
-void LSSD::Initialize(G4HCofThisEvent* hce)
+/**
+ * @brief 이벤트 시작 시 버퍼를 비웁니다. 용량은 유지되므로 새 메모리를 할당하지 않습니다.
+ */
+void LSSD::Initialize(G4HCofThisEvent* /*hce*/)
 {
-  fHitsCollection = new LSHitsCollection(SensitiveDetectorName, collectionName[0]);
-  G4int hcID = GetCollectionID(0);
-  hce->AddHitsCollection(hcID, fHitsCollection);
+  fHitBuffer.Clear();
+  fUnitSummary.assign(fUnitSummary.size(), UnitSummary());
 }
 
 G4bool LSSD::ProcessHits(G4Step* aStep, G4TouchableHistory* /*ROhist*/)
 {
   if (aStep->GetTotalEnergyDeposit() == 0.) return false;
 
-  LSHit* newHit = new LSHit();
-  G4Track* track = aStep->GetTrack();
-  
-  newHit->SetTrackID(track->GetTrackID());
-  newHit->SetParentID(track->GetParentID());
-  newHit->SetParticleName(track->GetDefinition()->GetParticleName());
-  newHit->SetVolumeName(track->GetVolume()->GetLogicalVolume()->GetName());
+  const G4Track* track = aStep->GetTrack();
+  const G4StepPoint* preStep = aStep->GetPreStepPoint();
+  if (!fConstantsCached) CacheLSConstants(preStep->GetMaterial());
+
+  // 깊이 0 = PhysLS, 깊이 1 = PhysDetectorUnit (copy number = 유닛 번호)
+  G4int unit = preStep->GetTouchable()->GetCopyNumber(1);
+  G4double edep = aStep->GetTotalEnergyDeposit();
 
+  const G4ParticleDefinition* particle = track->GetDefinition();
+  const G4LogicalVolume* volume = track->GetVolume()->GetLogicalVolume();
   const G4VProcess* creatorProcess = track->GetCreatorProcess();
-  if (creatorProcess) {
-    newHit->SetProcessName(creatorProcess->GetProcessName());
-  } else {
-    newHit->SetProcessName("primary");
-  }
+  G4int processCode = creatorProcess
+                    ? GetNameCode(creatorProcess, creatorProcess->GetProcessName())
+                    : fPrimaryProcessCode;
 
-  newHit->SetPosition(aStep->GetPreStepPoint()->GetPosition());
-  newHit->SetTime(aStep->GetPreStepPoint()->GetGlobalTime() / ns);
-  newHit->SetKineticEnergy(aStep->GetPreStepPoint()->GetKineticEnergy() / MeV);
-  newHit->SetEnergyDeposit(aStep->GetTotalEnergyDeposit() / MeV);
+  fHitBuffer.Add(unit, track->GetTrackID(), track->GetParentID(),
+                 GetNameCode(particle, particle->GetParticleName()),
+                 processCode,
+                 GetNameCode(volume, volume->GetName()),
+                 preStep->GetPosition() / mm,
+                 preStep->GetGlobalTime() / ns,
+                 preStep->GetKineticEnergy() / MeV,
+                 edep / MeV,
+                 track->GetWeight());
 
-  fHitsCollection->insert(newHit);
+  if (unit >= static_cast<G4int>(fUnitSummary.size())) fUnitSummary.resize(unit + 1);
+  UnitSummary& summary = fUnitSummary[unit];
+  summary.edep += edep;
+  summary.weightedEdep += track->GetWeight() * edep;
+  summary.visibleEdep += GetQuenchedEnergy(aStep);
+  summary.weightedPosition += edep * 0.5 * (preStep->GetPosition() + aStep->GetPostStepPoint()->GetPosition());
+  summary.firstTime = std::min(summary.firstTime, preStep->GetGlobalTime());
+
+  if (OpticalMapManager::Instance()->IsFastMode() && track->GetDefinition() != G4OpticalPhoton::Definition()) {
+    GenerateFastPMTHits(aStep);
+  }
 
   return true;
 }
+
+/**
+ * @brief 이름 코드를 반환합니다. 같은 객체는 스레드별 캐시에서 바로 찾으므로,
+ * 공유 사전의 뮤텍스는 처음 보는 입자/프로세스/볼륨에서만 잡습니다.
+ */
+G4int LSSD::GetNameCode(const void* key, const G4String& name)
+{
+  auto it = fNameCodeCache.find(key);
+  if (it != fNameCodeCache.end()) return it->second;
+
+  G4int code = NameDictionary::Instance()->Intern(name);
+  fNameCodeCache.emplace(key, code);
+  return code;
+}
+
+/**
+ * @brief LS 물질의 상수를 스레드별로 한 번만 읽어 둡니다.
+ */
+void LSSD::CacheLSConstants(const G4Material* material)
+{
+  G4MaterialPropertiesTable* lsMPT = material->GetMaterialPropertiesTable();
+  if (lsMPT) {
+    fBirksConstant = lsMPT->GetProperty("BIRKSCONSTANT");
+    if (lsMPT->ConstPropertyExists("SCINTILLATIONYIELD"))
+      fScintYield = lsMPT->GetConstProperty("SCINTILLATIONYIELD");
+    if (lsMPT->ConstPropertyExists("SCINTILLATIONTIMECONSTANT1"))
+      fScintTimeConstant = lsMPT->GetConstProperty("SCINTILLATIONTIMECONSTANT1");
+  }
+  fConstantsCached = true;
+}
+
+/**
+ * @brief Birks 법칙으로 보정한 가시 에너지를 반환합니다.
+ * 저지능 dE/dx는 스텝 평균(edep/스텝 길이)으로 근사하며, kB는 스텝 시작 운동에너지에서 읽습니다.
+ * 중성 입자나 길이가 0인 스텝(국소 증착)은 보정하지 않습니다.
+ */
+G4double LSSD::GetQuenchedEnergy(const G4Step* aStep) const
+{
+  G4double edep = aStep->GetTotalEnergyDeposit();
+  G4double stepLength = aStep->GetStepLength();
+  if (!fBirksConstant || stepLength <= 0. || aStep->GetTrack()->GetDefinition()->GetPDGCharge() == 0.) return edep;
+
+  G4double kB = fBirksConstant->Value(aStep->GetPreStepPoint()->GetKineticEnergy());
+  return edep / (1. + kB * edep / stepLength);
+}
+
+G4double LSSD::GetUnitEnergyDeposit(G4int unit) const
+{
+  if (unit < 0 || unit >= static_cast<G4int>(fUnitSummary.size())) return 0.;
+  return fUnitSummary[unit].edep;
+}
+
+G4int LSSD::GetNumberOfUnitsAbove(G4double threshold) const
+{
+  G4int nUnits = 0;
+  for (const auto& summary : fUnitSummary) {
+    if (summary.edep > threshold) ++nUnits;
+  }
+  return nUnits;
+}
+
+/**
+ * @brief fast 광학 모드: 광학 광자를 추적하지 않고, 룩업 맵으로 이 스텝의 PMT Hit을 샘플링합니다.
+ *
+ * 평균 섬광 광자 수(SCINTILLATIONYIELD x 가시 에너지)에 복셀의 검출 확률을 곱한 값으로
+ * 광전자 수를 Poisson 샘플링하고, 각 광전자의 시간은 섬광 감쇠 시간과 맵의 이동 시간 분포에서 뽑습니다.
+ */
+void LSSD::GenerateFastPMTHits(const G4Step* aStep)
+{
+  const G4StepPoint* preStep = aStep->GetPreStepPoint();
+
+  if (!fPMTSD) {
+    fPMTSD = static_cast<PMTSD*>(G4SDManager::GetSDMpointer()->FindSensitiveDetector("PMTSD", false));
+    if (!fPMTSD) return;
+  }
+
+  // G4Scintillation과 동일하게 Birks 포화(quenching)를 반영한 가시 에너지를 사용합니다.
+  G4double visibleEdep = G4LossTableManager::Instance()->EmSaturation()->VisibleEnergyDepositionAtAStep(aStep);
+  G4double meanPhotons = fScintYield * visibleEdep;
+  if (meanPhotons <= 0.) return;
+
+  // 섬광 광자는 스텝 전체에 걸쳐 생성되므로, 스텝 중점을 대표 위치로 사용합니다.
+  const G4VTouchable* touchable = preStep->GetTouchable();
+  G4ThreeVector midPoint = 0.5 * (preStep->GetPosition() + aStep->GetPostStepPoint()->GetPosition());
+  G4ThreeVector localPos = touchable->GetHistory()->GetTopTransform().TransformPoint(midPoint);
+
+  const OpticalLookupMap& map = OpticalMapManager::Instance()->GetMap();
+  G4int voxel = map.FindVoxel(localPos);
+  G4double pDetect = map.GetDetectionProbability(voxel);
+  if (pDetect <= 0.) return;
+
+  G4long nPE = G4Poisson(meanPhotons * pDetect);
+  if (nPE <= 0) return;
+
+  // 깊이 0 = PhysLS, 깊이 1 = PhysDetectorUnit. 맵은 같은 유닛의 PMT에 대한 값이므로 PMT 번호 = 유닛 번호.
+  G4int pmtID = touchable->GetCopyNumber(1);
+  G4double depositTime = preStep->GetGlobalTime();
+  // 광학 추적 경로의 광자처럼, 광전자는 증착한 트랙의 가중치(중요도 편향)를 물려받습니다.
+  G4double weight = aStep->GetTrack()->GetWeight();
+  for (G4long i = 0; i < nPE; ++i) {
+    G4double emissionDelay = (fScintTimeConstant > 0.) ? -fScintTimeConstant * G4Log(G4UniformRand()) : 0.;
+    G4double time = depositTime + emissionDelay + map.SampleTransitTime(voxel);
+    fPMTSD->RecordHit(pmtID, time / ns, weight);
+  }
+}
@@ -0,0 +1,69 @@
+#include "NameDictionary.hh"
+#include "G4AutoLock.hh"
+#include "G4LogicalVolume.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4ParticleTable.hh"
+#include "G4ProcessTable.hh"
+
+#include <set>
+
+namespace {
+  // 싱글톤 생성 자체를 보호하는 뮤텍스
+  G4Mutex instanceMutex = G4MUTEX_INITIALIZER;
+}
+
+NameDictionary* NameDictionary::fgInstance = nullptr;
+
+NameDictionary* NameDictionary::Instance()
+{
+  G4AutoLock lock(&instanceMutex);
+  if (!fgInstance) fgInstance = new NameDictionary();
+  return fgInstance;
+}
+
+NameDictionary::NameDictionary()
+{
+  // 생성 과정이 없는 1차 입자의 프로세스 이름 (LSSD)
+  Intern("primary");
+}
+
+G4int NameDictionary::Intern(const G4String& name)
+{
+  G4AutoLock lock(&fMutex);
+  auto it = fCodes.find(name);
+  if (it != fCodes.end()) return it->second;
+
+  G4int code = static_cast<G4int>(fNames.size());
+  fCodes.emplace(name, code);
+  fNames.push_back(name);
+  return code;
+}
+
+std::vector<G4String> NameDictionary::GetNames() const
+{
+  G4AutoLock lock(&fMutex);
+  return fNames;
+}
+
+/**
+ * @brief 테이블 순서나 처음 본 순서 대신 이름순으로 등록하므로, 코드는 물리 목록과 지오메트리만으로 정해집니다.
+ * 이미 등록된 이름은 코드를 유지하므로 같은 프로세스의 다음 Run에서 다시 불러도 됩니다.
+ */
+void NameDictionary::RegisterKnownNames()
+{
+  std::set<G4String> particles;
+  auto iterator = G4ParticleTable::GetParticleTable()->GetIterator();
+  iterator->reset();
+  while ((*iterator)()) particles.insert(iterator->value()->GetParticleName());
+
+  std::set<G4String> processes;
+  if (auto names = G4ProcessTable::GetProcessTable()->GetNameList()) processes.insert(names->begin(), names->end());
+
+  std::set<G4String> volumes;
+  for (auto volume : *G4LogicalVolumeStore::GetInstance()) volumes.insert(volume->GetName());
+
+  for (const auto& group : {particles, processes, volumes}) {
+    for (const auto& name : group) Intern(name);
+  }
+}
@@ -0,0 +1,201 @@
+#include "OpticalLookupMap.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ios.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace {
+  // 맵 파일 식별자. 형식이 바뀌면 버전 숫자를 올립니다.
+  const char kMapMagic[8] = {'C', 'P', 'N', 'R', 'O', 'L', 'M', '1'};
+}
+
+OpticalLookupMap::OpticalLookupMap()
+: fNR(0), fNZ(0), fNE(0), fNT(0),
+  fRMax(0.), fZHalf(0.), fEMin(0.), fEMax(0.), fTMax(0.),
+  fForeign(0.)
+{}
+
+OpticalLookupMap::~OpticalLookupMap()
+{}
+
+void OpticalLookupMap::Configure(G4int nR, G4int nZ, G4int nE, G4int nT,
+                                 G4double rMax, G4double zHalf,
+                                 G4double eMin, G4double eMax, G4double tMax)
+{
+  fNR = nR; fNZ = nZ; fNE = nE; fNT = nT;
+  fRMax = rMax; fZHalf = zHalf; fEMin = eMin; fEMax = eMax; fTMax = tMax;
+  Reset();
+}
+
+void OpticalLookupMap::Reset()
+{
+  const size_t nVoxel = static_cast<size_t>(fNR) * fNZ;
+  fEmitted.assign(nVoxel * fNE, 0.);
+  fDetected.assign(nVoxel * fNE, 0.);
+  fTimeHist.assign(nVoxel * fNT, 0.);
+  fForeign = 0.;
+  fVoxelProb.clear();
+  fTimeCDF.clear();
+}
+
+G4int OpticalLookupMap::FindVoxel(const G4ThreeVector& localPos) const
+{
+  // r^2 기준 등분: 각 링의 부피가 같아 통계가 고르게 쌓입니다.
+  G4double r2 = localPos.perp2() / (fRMax * fRMax);
+  G4double z = (localPos.z() + fZHalf) / (2. * fZHalf);
+  if (r2 >= 1. || z < 0. || z >= 1.) return -1;
+
+  G4int iR = static_cast<G4int>(r2 * fNR);
+  G4int iZ = static_cast<G4int>(z * fNZ);
+  return iR * fNZ + iZ;
+}
+
+G4int OpticalLookupMap::FindBin(const G4ThreeVector& localPos, G4double photonEnergy) const
+{
+  G4int voxel = FindVoxel(localPos);
+  if (voxel < 0) return -1;
+
+  G4double e = (photonEnergy - fEMin) / (fEMax - fEMin);
+  // 방출 스펙트럼의 양 끝점(정확히 eMax)도 마지막 bin에 포함시킵니다.
+  G4int iE = std::min(std::max(static_cast<G4int>(e * fNE), 0), fNE - 1);
+  return voxel * fNE + iE;
+}
+
+void OpticalLookupMap::FillDetected(G4int bin, G4double transitTime, G4double weight)
+{
+  if (bin < 0) return;
+  fDetected[bin] += weight;
+
+  G4int voxel = bin / fNE;
+  G4int iT = static_cast<G4int>(transitTime / fTMax * fNT);
+  iT = std::min(std::max(iT, 0), fNT - 1); // 범위를 넘는 늦은 광자는 마지막 bin에 쌓습니다.
+  fTimeHist[static_cast<size_t>(voxel) * fNT + iT] += weight;
+}
+
+void OpticalLookupMap::Merge(const OpticalLookupMap& other)
+{
+  if (other.fEmitted.size() != fEmitted.size() || other.fTimeHist.size() != fTimeHist.size()) {
+    G4Exception("OpticalLookupMap::Merge()", "OpticalMap_BinningMismatch", FatalException,
+                "병합하려는 두 광학 맵의 격자 정의가 다릅니다.");
+    return;
+  }
+  for (size_t i = 0; i < fEmitted.size(); ++i) {
+    fEmitted[i] += other.fEmitted[i];
+    fDetected[i] += other.fDetected[i];
+  }
+  for (size_t i = 0; i < fTimeHist.size(); ++i) fTimeHist[i] += other.fTimeHist[i];
+  fForeign += other.fForeign;
+}
+
+void OpticalLookupMap::Write(const G4String& fileName) const
+{
+  std::ofstream out(fileName, std::ios::binary);
+  if (!out) {
+    G4Exception("OpticalLookupMap::Write()", "OpticalMap_FileError", JustWarning,
+                ("광학 맵 파일을 쓸 수 없습니다: " + fileName).c_str());
+    return;
+  }
+
+  const G4int ints[4] = {fNR, fNZ, fNE, fNT};
+  // 단위가 섞이지 않도록 길이는 mm, 에너지는 eV, 시간은 ns로 저장합니다.
+  const G4double doubles[6] = {fRMax / mm, fZHalf / mm, fEMin / eV, fEMax / eV, fTMax / ns, fForeign};
+
+  out.write(kMapMagic, sizeof(kMapMagic));
+  out.write(reinterpret_cast<const char*>(ints), sizeof(ints));
+  out.write(reinterpret_cast<const char*>(doubles), sizeof(doubles));
+  out.write(reinterpret_cast<const char*>(fEmitted.data()), fEmitted.size() * sizeof(G4double));
+  out.write(reinterpret_cast<const char*>(fDetected.data()), fDetected.size() * sizeof(G4double));
+  out.write(reinterpret_cast<const char*>(fTimeHist.data()), fTimeHist.size() * sizeof(G4double));
+
+  G4cout << "--> Optical lookup map written to " << fileName
+         << " (emitted " << GetTotalEmitted() << ", detected " << GetTotalDetected()
+         << ", foreign " << fForeign << ")" << G4endl;
+}
+
+G4bool OpticalLookupMap::Read(const G4String& fileName)
+{
+  std::ifstream in(fileName, std::ios::binary);
+  if (!in) return false;
+
+  char magic[sizeof(kMapMagic)];
+  G4int ints[4];
+  G4double doubles[6];
+  in.read(magic, sizeof(magic));
+  in.read(reinterpret_cast<char*>(ints), sizeof(ints));
+  in.read(reinterpret_cast<char*>(doubles), sizeof(doubles));
+  if (!in || std::memcmp(magic, kMapMagic, sizeof(kMapMagic)) != 0) return false;
+
+  Configure(ints[0], ints[1], ints[2], ints[3],
+            doubles[0] * mm, doubles[1] * mm, doubles[2] * eV, doubles[3] * eV, doubles[4] * ns);
+  fForeign = doubles[5];
+
+  in.read(reinterpret_cast<char*>(fEmitted.data()), fEmitted.size() * sizeof(G4double));
+  in.read(reinterpret_cast<char*>(fDetected.data()), fDetected.size() * sizeof(G4double));
+  in.read(reinterpret_cast<char*>(fTimeHist.data()), fTimeHist.size() * sizeof(G4double));
+  if (!in) return false;
+
+  Finalize();
+  return true;
+}
+
+void OpticalLookupMap::Finalize()
+{
+  const G4int nVoxel = fNR * fNZ;
+  fVoxelProb.assign(nVoxel, 0.);
+  fTimeCDF.assign(static_cast<size_t>(nVoxel) * fNT, 0.);
+
+  for (G4int v = 0; v < nVoxel; ++v) {
+    // 맵 생성 시의 방출 스펙트럼으로 가중된 에너지 적분 검출 확률
+    G4double emitted = 0., detected = 0.;
+    for (G4int e = 0; e < fNE; ++e) {
+      emitted += fEmitted[v * fNE + e];
+      detected += fDetected[v * fNE + e];
+    }
+    fVoxelProb[v] = (emitted > 0.) ? detected / emitted : 0.;
+
+    G4double sum = 0.;
+    for (G4int t = 0; t < fNT; ++t) {
+      sum += fTimeHist[static_cast<size_t>(v) * fNT + t];
+      fTimeCDF[static_cast<size_t>(v) * fNT + t] = sum;
+    }
+    if (sum > 0.) {
+      for (G4int t = 0; t < fNT; ++t) fTimeCDF[static_cast<size_t>(v) * fNT + t] /= sum;
+    }
+  }
+}
+
+G4double OpticalLookupMap::GetDetectionProbability(G4int voxel) const
+{
+  if (voxel < 0 || voxel >= static_cast<G4int>(fVoxelProb.size())) return 0.;
+  return fVoxelProb[voxel];
+}
+
+G4double OpticalLookupMap::SampleTransitTime(G4int voxel) const
+{
+  auto first = fTimeCDF.begin() + static_cast<size_t>(voxel) * fNT;
+  auto last = first + fNT;
+  auto it = std::lower_bound(first, last, G4UniformRand());
+  G4int iT = std::min(static_cast<G4int>(it - first), fNT - 1);
+
+  // bin 내부에서는 균일 분포로 근사합니다.
+  G4double binWidth = fTMax / fNT;
+  return (iT + G4UniformRand()) * binWidth;
+}
+
+G4double OpticalLookupMap::GetTotalEmitted() const
+{
+  G4double sum = 0.;
+  for (auto value : fEmitted) sum += value;
+  return sum;
+}
+
+G4double OpticalLookupMap::GetTotalDetected() const
+{
+  G4double sum = 0.;
+  for (auto value : fDetected) sum += value;
+  return sum;
+}
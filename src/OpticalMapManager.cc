@@ -0,0 +1,186 @@
+#include "OpticalMapManager.hh"
+#include "DetectorConstruction.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4AutoLock.hh"
+#include "G4Threading.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4LogicalSkinSurface.hh"
+#include "G4OpticalSurface.hh"
+#include "G4MaterialPropertiesTable.hh"
+
+#include <algorithm>
+
+namespace {
+  // Worker 스레드의 맵을 마스터 맵으로 병합할 때 사용하는 뮤텍스
+  G4Mutex mergeMutex = G4MUTEX_INITIALIZER;
+}
+
+OpticalMapManager* OpticalMapManager::fgInstance = nullptr;
+G4ThreadLocal OpticalLookupMap* OpticalMapManager::fgWorkerMap = nullptr;
+
+/**
+ * @brief 싱글톤 인스턴스를 반환합니다.
+ * 메신저 명령어가 Master 스레드에 등록되도록, main()에서 RunManager 초기화 전에 한 번 호출해야 합니다.
+ */
+OpticalMapManager* OpticalMapManager::Instance()
+{
+  if (!fgInstance) fgInstance = new OpticalMapManager();
+  return fgInstance;
+}
+
+OpticalMapManager::OpticalMapManager()
+: fMode(Mode::kFull), fMapFile("optical_map.bin"), fLoadedFile(""),
+  fNBinsR(10), fNBinsZ(20), fNBinsE(12), fNBinsT(200),
+  fTimeMax(20.*ns),
+  fThinningScale(0.), fThinningFraction(1.),
+  fMessenger(nullptr)
+{
+  DefineCommands();
+}
+
+OpticalMapManager::~OpticalMapManager()
+{
+  delete fMessenger;
+}
+
+void OpticalMapManager::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/myApp/optics/", "Optical simulation mode and lookup map control.");
+
+  // 설정은 Master의 싱글톤 하나가 보관하므로 Worker로 명령어를 전파(broadcast)하지 않습니다.
+  auto& modeCmd = fMessenger->DeclareMethod("setMode", &OpticalMapManager::SetMode,
+                                            "Optical mode: full (track all photons), build (fill lookup map), fast (sample hits from map).");
+  modeCmd.SetParameterName("Mode", false);
+  modeCmd.SetCandidates("full build fast");
+  modeCmd.SetStates(G4State_PreInit, G4State_Idle);
+  modeCmd.SetToBeBroadcasted(false);
+
+  auto& fileCmd = fMessenger->DeclareProperty("setMapFile", fMapFile,
+                                              "File name of the optical lookup map (written in build mode, read in fast mode).");
+  fileCmd.SetParameterName("FileName", false);
+  fileCmd.SetStates(G4State_PreInit, G4State_Idle);
+  fileCmd.SetToBeBroadcasted(false);
+
+  auto& binsRCmd = fMessenger->DeclareProperty("setMapBinsR", fNBinsR, "Number of equal-volume radial bins of the map.");
+  binsRCmd.SetParameterName("NBins", false);
+  binsRCmd.SetRange("NBins>0");
+  binsRCmd.SetToBeBroadcasted(false);
+
+  auto& binsZCmd = fMessenger->DeclareProperty("setMapBinsZ", fNBinsZ, "Number of axial bins of the map.");
+  binsZCmd.SetParameterName("NBins", false);
+  binsZCmd.SetRange("NBins>0");
+  binsZCmd.SetToBeBroadcasted(false);
+
+  auto& binsECmd = fMessenger->DeclareProperty("setMapBinsE", fNBinsE, "Number of photon-energy bins of the map.");
+  binsECmd.SetParameterName("NBins", false);
+  binsECmd.SetRange("NBins>0");
+  binsECmd.SetToBeBroadcasted(false);
+
+  auto& binsTCmd = fMessenger->DeclareProperty("setMapBinsT", fNBinsT, "Number of transit-time bins of the map.");
+  binsTCmd.SetParameterName("NBins", false);
+  binsTCmd.SetRange("NBins>0");
+  binsTCmd.SetToBeBroadcasted(false);
+
+  auto& tMaxCmd = fMessenger->DeclarePropertyWithUnit("setMapTimeMax", "ns", fTimeMax, "Upper edge of the transit-time histogram.");
+  tMaxCmd.SetParameterName("Time", false);
+  tMaxCmd.SetToBeBroadcasted(false);
+
+  auto& thinCmd = fMessenger->DeclareProperty("setThinningScale", fThinningScale,
+                                              "Keep optical photons with probability min(1, scale x peak QE) and weight them (0 = off).");
+  thinCmd.SetParameterName("Scale", false);
+  thinCmd.SetRange("Scale>=0.");
+  thinCmd.SetStates(G4State_PreInit, G4State_Idle);
+  thinCmd.SetToBeBroadcasted(false);
+}
+
+void OpticalMapManager::SetMode(const G4String& mode)
+{
+  if (mode == "build") fMode = Mode::kBuild;
+  else if (mode == "fast") fMode = Mode::kFast;
+  else fMode = Mode::kFull;
+
+  G4cout << "--> Optical mode has been set to: " << mode << G4endl;
+}
+
+void OpticalMapManager::ConfigureMap(OpticalLookupMap& map) const
+{
+  // 맵은 LS 로컬 좌표계 전체와 LS 방출 스펙트럼 범위를 덮습니다.
+  map.Configure(fNBinsR, fNBinsZ, fNBinsE, fNBinsT,
+                DetectorConstruction::kBottleInnerRadius, DetectorConstruction::kLSHalfZ,
+                DetectorConstruction::kPhotonEnergyMin, DetectorConstruction::kPhotonEnergyMax,
+                fTimeMax);
+}
+
+/**
+ * @brief 광음극 표면의 EFFICIENCY 테이블에서 최대 QE를 읽어 생존 확률 f를 계산합니다.
+ * Master의 BeginOfRunAction은 Worker의 이벤트 처리보다 먼저 호출되므로, Worker는 계산된 값을 읽기만 합니다.
+ */
+void OpticalMapManager::UpdateThinningFraction()
+{
+  fThinningFraction = 1.;
+  if (fThinningScale <= 0.) return;
+
+  G4double peakQE = 1.;
+  G4LogicalVolume* photocathode = G4LogicalVolumeStore::GetInstance()->GetVolume("LogicPhotocathode", false);
+  G4LogicalSkinSurface* skin = photocathode ? G4LogicalSkinSurface::GetSurface(photocathode) : nullptr;
+  auto surface = skin ? dynamic_cast<G4OpticalSurface*>(skin->GetSurfaceProperty()) : nullptr;
+  G4MaterialPropertiesTable* mpt = surface ? surface->GetMaterialPropertiesTable() : nullptr;
+  G4MaterialPropertyVector* qeVector = mpt ? mpt->GetProperty("EFFICIENCY") : nullptr;
+  if (qeVector) peakQE = qeVector->GetMaxValue();
+
+  fThinningFraction = std::min(1., fThinningScale * peakQE);
+  G4cout << "--> Optical photon thinning: peak QE = " << peakQE
+         << ", survival fraction = " << fThinningFraction << G4endl;
+}
+
+void OpticalMapManager::BeginOfRun(G4bool isMaster)
+{
+  if (isMaster) {
+    UpdateThinningFraction();
+
+    if (fMode == Mode::kBuild) {
+      ConfigureMap(fMasterMap);
+    }
+    else if (fMode == Mode::kFast && fLoadedFile != fMapFile) {
+      // 같은 맵을 스캔 포인트마다 다시 읽지 않도록, 파일 이름이 바뀐 경우에만 읽습니다.
+      if (!fMasterMap.Read(fMapFile)) {
+        G4Exception("OpticalMapManager::BeginOfRun()", "OpticalMap_ReadError", FatalException,
+                    ("광학 맵 파일을 읽을 수 없습니다: " + fMapFile
+                     + "\n먼저 /myApp/optics/setMode build 로 맵을 생성하십시오.").c_str());
+      }
+      fLoadedFile = fMapFile;
+      G4cout << "--> Optical lookup map loaded from " << fMapFile << G4endl;
+    }
+  }
+  else if (fMode == Mode::kBuild) {
+    if (!fgWorkerMap) fgWorkerMap = new OpticalLookupMap();
+    ConfigureMap(*fgWorkerMap);
+  }
+
+  // build 모드에서는 마스터 맵의 내용이 바뀌므로, 다음 fast 런에서 다시 읽도록 합니다.
+  if (isMaster && fMode == Mode::kBuild) fLoadedFile = "";
+}
+
+void OpticalMapManager::EndOfRun(G4bool isMaster)
+{
+  if (fMode != Mode::kBuild) return;
+
+  if (!isMaster) {
+    if (fgWorkerMap) {
+      G4AutoLock lock(&mergeMutex);
+      fMasterMap.Merge(*fgWorkerMap);
+    }
+    return;
+  }
+
+  // Master의 EndOfRunAction은 모든 Worker가 끝난 뒤 호출되므로, 병합이 완료된 상태입니다.
+  fMasterMap.Write(fMapFile);
+}
+
+OpticalLookupMap* OpticalMapManager::GetFillMap()
+{
+  if (G4Threading::IsWorkerThread()) return fgWorkerMap;
+  return &fMasterMap;
+}
@@ -0,0 +1,9 @@
+#include "OpticalPhotonInfo.hh"
+
+OpticalPhotonInfo::OpticalPhotonInfo(G4int sourceUnit, G4int mapBin)
+: G4VUserTrackInformation("OpticalPhotonInfo"),
+  fSourceUnit(sourceUnit), fMapBin(mapBin)
+{}
+
+OpticalPhotonInfo::~OpticalPhotonInfo()
+{}
@@ -0,0 +1,245 @@
+#include "OutputWriter.hh"
+#include "EventRecord.hh"
+#include "RootEventSink.hh"
+#include "ColumnarEventSink.hh"
+#include "NameDictionary.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4ios.hh"
+
+#include <chrono>
+#include <iomanip>
+#include <vector>
+
+OutputWriter* OutputWriter::fgInstance = nullptr;
+
+OutputWriter* OutputWriter::Instance()
+{
+  if (!fgInstance) fgInstance = new OutputWriter();
+  return fgInstance;
+}
+
+OutputWriter::OutputWriter()
+: fEnabled(false), fPerThreadFiles(false), fColumnar(false), fQueueSize(256), fBatchSize(32), fFileName("output"), fEventIDOffset(0),
+  fQueue(nullptr), fFreeRecords(nullptr), fSink(nullptr),
+  fRunning(false), fStopRequested(false),
+  fRecordsAllocated(0), fStalledPushes(0), fStallNanoseconds(0),
+  fRecordsWritten(0), fBatches(0), fMaxDepth(0), fDepthSum(0.), fWriteSeconds(0.),
+  fMessenger(nullptr)
+{
+  DefineCommands();
+}
+
+OutputWriter::~OutputWriter()
+{
+  if (IsRunning()) Stop();
+  delete fMessenger;
+}
+
+void OutputWriter::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/myApp/writer/", "Asynchronous output writer control.");
+
+  // 설정은 Master의 싱글톤 하나가 보관하므로 Worker로 명령어를 전파(broadcast)하지 않습니다.
+  auto& asyncCmd = fMessenger->DeclareProperty("setAsync", fEnabled,
+                                               "Write events from a dedicated writer thread instead of merged G4 ntuples.");
+  asyncCmd.SetParameterName("Flag", false);
+  asyncCmd.SetStates(G4State_PreInit, G4State_Idle);
+  asyncCmd.SetToBeBroadcasted(false);
+
+  auto& formatCmd = fMessenger->DeclareMethod("setFormat", &OutputWriter::SetFormat,
+                                              "Output format of the writer thread: root (.root) or columnar (memory-mappable .col).");
+  formatCmd.SetParameterName("Format", false);
+  formatCmd.SetCandidates("root columnar");
+  formatCmd.SetStates(G4State_PreInit, G4State_Idle);
+  formatCmd.SetToBeBroadcasted(false);
+
+  auto& perThreadCmd = fMessenger->DeclareProperty("setPerThreadFiles", fPerThreadFiles,
+                                                   "Synchronous mode: write one file per worker thread instead of merging ntuples in the master.");
+  perThreadCmd.SetParameterName("Flag", false);
+  perThreadCmd.SetStates(G4State_PreInit, G4State_Idle);
+  perThreadCmd.SetToBeBroadcasted(false);
+
+  auto& queueCmd = fMessenger->DeclareProperty("setQueueSize", fQueueSize,
+                                               "Capacity of the event queue (rounded up to a power of two).");
+  queueCmd.SetParameterName("NEvents", false);
+  queueCmd.SetRange("NEvents>=2");
+  queueCmd.SetStates(G4State_PreInit, G4State_Idle);
+  queueCmd.SetToBeBroadcasted(false);
+
+  auto& batchCmd = fMessenger->DeclareProperty("setBatchSize", fBatchSize,
+                                               "Maximum number of events the writer takes from the queue per batch.");
+  batchCmd.SetParameterName("NEvents", false);
+  batchCmd.SetRange("NEvents>=1");
+  batchCmd.SetStates(G4State_PreInit, G4State_Idle);
+  batchCmd.SetToBeBroadcasted(false);
+
+  auto& fileCmd = fMessenger->DeclareProperty("setFileName", fFileName,
+                                              "Output file name without extension (per-thread files append _t<N>).");
+  fileCmd.SetParameterName("FileName", false);
+  fileCmd.SetStates(G4State_PreInit, G4State_Idle);
+  fileCmd.SetToBeBroadcasted(false);
+}
+
+void OutputWriter::SetFormat(const G4String& format)
+{
+  fColumnar = (format == "columnar");
+  // 열 단위 형식은 쓰기 스레드의 EventSink로만 기록되므로 비동기 모드를 함께 켭니다.
+  if (fColumnar && !fEnabled) {
+    fEnabled = true;
+    G4cout << "--> Columnar output is written by the asynchronous writer; /myApp/writer/setAsync enabled." << G4endl;
+  }
+}
+
+/**
+ * @brief 출력 파일을 열고 쓰기 스레드를 시작합니다.
+ * Master의 BeginOfRunAction은 Worker의 이벤트 처리보다 먼저 호출되므로, 첫 이벤트 전에 큐가 준비됩니다.
+ */
+void OutputWriter::Start(const G4String& baseName)
+{
+  if (IsRunning()) return;
+
+  // 큐 크기가 바뀌었을 수 있으므로 Run마다 새로 만듭니다. 풀에는 처리 중인 레코드까지 들어갈 수 있도록 두 배를 잡습니다.
+  delete fQueue;
+  fQueue = new BoundedQueue<EventRecord*>(fQueueSize);
+  if (!fFreeRecords || fFreeRecords->Capacity() < 2 * fQueue->Capacity()) {
+    EventRecord* record = nullptr;
+    while (fFreeRecords && fFreeRecords->TryPop(record)) delete record;
+    delete fFreeRecords;
+    fFreeRecords = new BoundedQueue<EventRecord*>(2 * fQueue->Capacity());
+  }
+
+  G4String fileName = baseName + GetFileExtension();
+  if (fColumnar) fSink = new ColumnarEventSink();
+  else fSink = new RootEventSink();
+  if (!fSink->Open(fileName)) {
+    G4Exception("OutputWriter::Start()", "Writer_FileError", FatalException,
+                ("출력 파일을 열 수 없습니다: " + fileName).c_str());
+    return;
+  }
+
+  fStalledPushes = 0;
+  fStallNanoseconds = 0;
+  fRecordsWritten = 0;
+  fBatches = 0;
+  fMaxDepth = 0;
+  fDepthSum = 0.;
+  fWriteSeconds = 0.;
+
+  fStopRequested.store(false, std::memory_order_release);
+  fRunning.store(true, std::memory_order_release);
+  fThread = std::thread(&OutputWriter::WriterLoop, this);
+
+  G4cout << "--> Asynchronous output writer started: " << fileName
+         << " (queue " << fQueue->Capacity() << ", batch " << fBatchSize << ")" << G4endl;
+}
+
+/**
+ * @brief 남은 레코드를 모두 기록한 뒤 쓰기 스레드를 종료하고 파일을 닫습니다.
+ * Master의 EndOfRunAction은 모든 Worker가 끝난 뒤 호출되므로, 이후 새 레코드는 들어오지 않습니다.
+ */
+void OutputWriter::Stop()
+{
+  if (!IsRunning()) return;
+
+  fStopRequested.store(true, std::memory_order_release);
+  fThread.join();
+  fRunning.store(false, std::memory_order_release);
+
+  fSink->Close(NameDictionary::Instance()->GetNames());
+  delete fSink;
+  fSink = nullptr;
+
+  PrintStatistics();
+}
+
+EventRecord* OutputWriter::Acquire()
+{
+  EventRecord* record = nullptr;
+  if (fFreeRecords->TryPop(record)) return record;
+
+  // 풀이 비어 있을 때만 새로 할당합니다. (정상 상태에서는 처리 중인 레코드 수가 일정하므로 곧 멈춥니다.)
+  fRecordsAllocated.fetch_add(1, std::memory_order_relaxed);
+  return new EventRecord();
+}
+
+void OutputWriter::Push(EventRecord* record)
+{
+  // 대부분의 이벤트는 어느 LS에도 에너지를 남기지 않으므로, 빈 레코드는 큐를 거치지 않습니다.
+  if (record->IsEmpty()) {
+    Recycle(record);
+    return;
+  }
+
+  if (!fQueue->TryPush(record)) {
+    // backpressure: 쓰기 스레드가 자리를 만들 때까지 양보하며 기다리고, 그 시간을 집계합니다.
+    auto start = std::chrono::steady_clock::now();
+    while (!fQueue->TryPush(record)) std::this_thread::yield();
+    auto stall = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    fStalledPushes.fetch_add(1, std::memory_order_relaxed);
+    fStallNanoseconds.fetch_add(stall.count(), std::memory_order_relaxed);
+  }
+}
+
+void OutputWriter::Recycle(EventRecord* record)
+{
+  record->Clear();
+  if (!fFreeRecords->TryPush(record)) delete record;
+}
+
+void OutputWriter::WriterLoop()
+{
+  std::vector<EventRecord*> batch;
+  batch.reserve(fBatchSize);
+
+  for (;;) {
+    // 종료 요청을 먼저 읽은 뒤 큐를 비워야, 요청 직전에 들어온 레코드를 놓치지 않습니다.
+    G4bool stopRequested = fStopRequested.load(std::memory_order_acquire);
+
+    size_t depth = fQueue->SizeApprox();
+    EventRecord* record = nullptr;
+    batch.clear();
+    while (static_cast<G4int>(batch.size()) < fBatchSize && fQueue->TryPop(record)) batch.push_back(record);
+
+    if (batch.empty()) {
+      if (stopRequested) break;
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+      continue;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (EventRecord* item : batch) {
+      fSink->Write(*item);
+      Recycle(item);
+    }
+    fSink->EndBatch();
+    fWriteSeconds += std::chrono::duration<G4double>(std::chrono::steady_clock::now() - start).count();
+
+    fRecordsWritten += batch.size();
+    ++fBatches;
+    fDepthSum += depth;
+    if (depth > fMaxDepth) fMaxDepth = depth;
+  }
+}
+
+void OutputWriter::PrintStatistics() const
+{
+  G4long stalledPushes = fStalledPushes.load();
+  std::ios::fmtflags flags = G4cout.flags();
+  std::streamsize precision = G4cout.precision();
+
+  G4cout << G4endl << "--------------------- Asynchronous output writer ---------------------" << G4endl;
+  G4cout << std::fixed << std::setprecision(3)
+         << " Events written      : " << fRecordsWritten << " in " << fBatches << " batches ("
+         << (fBatches > 0 ? static_cast<G4double>(fRecordsWritten) / fBatches : 0.) << " events/batch)" << G4endl
+         << " Queue depth         : max " << fMaxDepth << ", mean "
+         << (fBatches > 0 ? fDepthSum / fBatches : 0.) << " of capacity " << fQueue->Capacity() << G4endl
+         << " Producer stalls     : " << stalledPushes << " pushes, "
+         << fStallNanoseconds.load() * 1.e-9 << " s total" << G4endl
+         << " Writer busy time    : " << fWriteSeconds << " s" << G4endl
+         << " Records allocated   : " << fRecordsAllocated.load() << G4endl;
+  G4cout << "----------------------------------------------------------------------" << G4endl;
+
+  G4cout.flags(flags);
+  G4cout.precision(precision);
+}
@@ -9,6 +9,11 @@
 #include "G4ios.hh"
 #include "Randomize.hh"
 
+#include <algorithm>
+
+#include "OpticalMapManager.hh"
+#include "OpticalPhotonInfo.hh"
+
 PMTSD::PMTSD(const G4String& name)
 : G4VSensitiveDetector(name), fHitsCollection(nullptr)
 {
@@ -40,16 +45,46 @@ G4bool PMTSD::ProcessHits(G4Step* aStep, G4TouchableHistory* /*ROhist*/)
   G4double photonEnergy = track->GetKineticEnergy();
   G4double quantumEfficiency = qeVector->Value(photonEnergy);
 
-  if (G4UniformRand() > quantumEfficiency) {
+  // 솎아내기 보정: 생성 시 확률 f로 남은 광자는 QE/f로 수용합니다.
+  // QE/f <= 1이면 가중치는 부모 입자의 가중치 그대로이고, 1을 넘는 경우에만 초과분을 가중치로 넘깁니다.
+  auto mapManager = OpticalMapManager::Instance();
+  G4double fraction = mapManager->GetThinningFraction();
+  G4double acceptance = quantumEfficiency / fraction;
+  G4double hitWeight = track->GetWeight() * fraction * std::max(acceptance, 1.);
+
+  if (G4UniformRand() > acceptance) {
     track->SetTrackStatus(fStopAndKill);
     return false;
   }
 
-  PMTHit* newHit = new PMTHit();
-  newHit->SetPMTID(aStep->GetPreStepPoint()->GetTouchable()->GetCopyNumber());
-  newHit->SetTime(aStep->GetPostStepPoint()->GetGlobalTime() / ns);
-  fHitsCollection->insert(newHit);
+  // 깊이 0 = PhysPhotocathode, 1 = PhysPMT, 2 = PhysDetectorUnit.
+  // 광음극 자체의 copy number는 항상 0이므로, 유닛의 copy number를 PMT 번호로 사용합니다.
+  G4int pmtID = aStep->GetPreStepPoint()->GetTouchable()->GetCopyNumber(2);
+  RecordHit(pmtID, aStep->GetPostStepPoint()->GetGlobalTime() / ns, hitWeight);
   track->SetTrackStatus(fStopAndKill);
 
+  // 맵 생성(build) 모드: 생성 위치 bin에 검출과 이동 시간(트랙 생성 후 경과 시간)을 기록합니다.
+  if (mapManager->IsBuildMode()) {
+    auto info = dynamic_cast<OpticalPhotonInfo*>(track->GetUserInformation());
+    if (info) {
+      OpticalLookupMap* map = mapManager->GetFillMap();
+      if (info->GetSourceUnit() == pmtID) map->FillDetected(info->GetMapBin(), track->GetLocalTime(), hitWeight);
+      else map->FillForeign(hitWeight);
+    }
+  }
+
   return true;
 }
+
+/**
+ * @brief PMT Hit 하나를 현재 이벤트의 컬렉션에 추가합니다.
+ * 광학 추적 경로와 fast 모드(LSSD의 맵 샘플링) 양쪽에서 공통으로 사용합니다.
+ */
+void PMTSD::RecordHit(G4int pmtID, G4double time, G4double weight)
+{
+  PMTHit* newHit = new PMTHit();
+  newHit->SetPMTID(pmtID);
+  newHit->SetTime(time);
+  newHit->SetWeight(weight);
+  fHitsCollection->insert(newHit);
+}
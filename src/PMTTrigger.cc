@@ -0,0 +1,63 @@
+#include "PMTTrigger.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+
+void PMTTrigger::Load(const PMTHitsCollection* hits, G4int eventID)
+{
+  if (eventID == fEventID) return;
+  fEventID = eventID;
+  fThreshold = -1.;
+
+  fPhotoElectrons.clear();
+  if (!hits) return;
+  for (size_t i = 0; i < hits->entries(); ++i) {
+    auto hit = (*hits)[i];
+    fPhotoElectrons.push_back({hit->GetPMTID(), hit->GetTime(), hit->GetWeight()});
+  }
+  std::sort(fPhotoElectrons.begin(), fPhotoElectrons.end(), [](const PhotoElectron& a, const PhotoElectron& b) {
+    if (a.pmtID != b.pmtID) return a.pmtID < b.pmtID;
+    return a.time < b.time;
+  });
+}
+
+void PMTTrigger::Evaluate(G4double peThreshold)
+{
+  if (peThreshold == fThreshold) return;
+  fThreshold = peThreshold;
+
+  fTriggers.clear();
+  auto first = fPhotoElectrons.begin();
+  while (first != fPhotoElectrons.end()) {
+    const G4int pmtID = first->pmtID;
+    G4double weightSum = 0.;
+    G4bool triggered = false;
+    for (; first != fPhotoElectrons.end() && first->pmtID == pmtID; ++first) {
+      weightSum += first->weight;
+      if (!triggered && weightSum >= peThreshold) {
+        fTriggers.emplace_back(pmtID, first->time);
+        triggered = true;
+      }
+    }
+  }
+}
+
+/**
+ * @brief 트리거 시각을 정렬한 뒤 두 포인터로 훑어, 폭 window 안에 들어가는 트리거 수의 최댓값을 구합니다.
+ */
+G4int PMTTrigger::GetMultiplicity(G4double window)
+{
+  if (fTriggers.size() <= 1) return static_cast<G4int>(fTriggers.size());
+
+  fTimes.clear();
+  for (const auto& trigger : fTriggers) fTimes.push_back(trigger.second * ns);
+  std::sort(fTimes.begin(), fTimes.end());
+
+  size_t best = 1;
+  size_t begin = 0;
+  for (size_t end = 0; end < fTimes.size(); ++end) {
+    while (fTimes[end] - fTimes[begin] > window) ++begin;
+    best = std::max(best, end - begin + 1);
+  }
+  return static_cast<G4int>(best);
+}
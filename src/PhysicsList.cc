@@ -10,18 +10,135 @@
 #include "G4StoppingPhysics.hh"
 #include "G4OpticalPhysics.hh"
 #include "G4StepLimiterPhysics.hh"
+#include "G4ImportanceBiasing.hh"
+#include "G4ParallelWorldPhysics.hh"
+#include "G4GeometrySampler.hh"
 #include "G4SystemOfUnits.hh"
 
+#include "G4GenericMessenger.hh"
+#include "G4ProductionCutsTable.hh"
+#include "G4Version.hh"
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace {
+  // 테이블 저장이 끝까지 성공한 캐시 디렉터리에만 만드는 표시 파일
+  const char* const kCacheCompleteMarker = "cache.complete";
+}
+
 /**
- * @brief 생성자: 필요한 물리 프로세스 모듈들을 등록합니다.
+ * @brief 생성자: 프리셋 이름과 캐시 설정만 정합니다.
  *
  * G4VModularPhysicsList를 상속받아, 필요한 물리 모듈을 '부품'처럼 조립합니다.
  * 이 방식은 Geant4에서 권장하는 현대적인 방식으로, 특정 표준 물리 리스트(예: Shielding)에
  * 종속될 때 발생하는 UI 명령어 비활성화와 같은 예기치 않은 문제를 해결합니다.
+ * 실제 모듈 등록은 --preinit 매크로로 프리셋을 바꿀 수 있도록 ConstructPreset()에서 합니다.
+ */
+PhysicsList::PhysicsList(const G4String& preset)
+: G4VModularPhysicsList(),
+  fPreset(preset), fCacheRoot("physics_cache"), fCacheEnabled(true),
+  fConstructed(false), fRetrievedFrom(""),
+  fImportanceEnabled(false), fGeometrySampler(nullptr), fMessenger(nullptr)
+{
+  // 2차 입자 생성을 위한 기준 거리(Production Cut)를 1mm로 설정합니다.
+  // 이 거리보다 짧은 거리를 날아가는 2차 입자는 생성되지 않고 에너지가 즉시 흡수됩니다.
+  SetDefaultCutValue(1.0*mm);
+
+  DefineCommands();
+}
+
+/**
+ * @brief 소멸자
+ */
+PhysicsList::~PhysicsList()
+{
+  delete fMessenger;
+  delete fGeometrySampler;
+}
+
+void PhysicsList::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/myApp/physics/", "Physics preset and physics table cache control.");
+
+  // 물리 모듈은 RunManager에 등록되기 전(PreInit)에만 바꿀 수 있으므로, --preinit 매크로에서 사용합니다.
+  auto& presetCmd = fMessenger->DeclareMethod("preset", &PhysicsList::SetPreset,
+                                              "Physics preset: full (with hadronic HP), minimal (EM + RDM + optical), nooptical (EM + RDM).");
+  presetCmd.SetParameterName("Preset", false);
+  presetCmd.SetCandidates("full minimal nooptical");
+  presetCmd.SetStates(G4State_PreInit);
+  presetCmd.SetToBeBroadcasted(false);
+
+  auto& dirCmd = fMessenger->DeclareMethod("cacheDir", &PhysicsList::SetCacheDirectory,
+                                           "Root directory of the physics table cache.");
+  dirCmd.SetParameterName("Directory", false);
+  dirCmd.SetStates(G4State_PreInit);
+  dirCmd.SetToBeBroadcasted(false);
+
+  auto& cacheCmd = fMessenger->DeclareMethod("useCache", &PhysicsList::SetCacheEnabled,
+                                             "Store built physics tables on disk and retrieve them on later runs.");
+  cacheCmd.SetParameterName("Enable", false);
+  cacheCmd.SetStates(G4State_PreInit);
+  cacheCmd.SetToBeBroadcasted(false);
+
+  // 중요도 편향은 병렬 세계와 물리 모듈을 함께 등록해야 하므로 역시 PreInit 전용입니다.
+  auto& importanceCmd = fMessenger->DeclareProperty("importance", fImportanceEnabled,
+                                                    "Gamma importance biasing (splitting/roulette) on nested shells around each detector unit.");
+  importanceCmd.SetParameterName("Enable", false);
+  importanceCmd.SetStates(G4State_PreInit);
+  importanceCmd.SetToBeBroadcasted(false);
+
+  auto& shellsCmd = fMessenger->DeclareProperty("importanceShells", fImportance.shells,
+                                                "Number of nested importance shells per detector unit.");
+  shellsCmd.SetParameterName("NShells", false);
+  shellsCmd.SetRange("NShells>=1");
+  shellsCmd.SetStates(G4State_PreInit);
+  shellsCmd.SetToBeBroadcasted(false);
+
+  auto& ratioCmd = fMessenger->DeclareProperty("importanceRatio", fImportance.ratio,
+                                               "Importance ratio between neighbouring shells (split factor on the way in).");
+  ratioCmd.SetParameterName("Ratio", false);
+  ratioCmd.SetRange("Ratio>=1.");
+  ratioCmd.SetStates(G4State_PreInit);
+  ratioCmd.SetToBeBroadcasted(false);
+
+  auto& radiusCmd = fMessenger->DeclarePropertyWithUnit("importanceRadius", "cm", fImportance.outerRadius,
+                                                        "Radius of the outermost importance shell around the LS centre.");
+  radiusCmd.SetParameterName("Radius", false);
+  radiusCmd.SetRange("Radius>0.");
+  radiusCmd.SetStates(G4State_PreInit);
+  radiusCmd.SetToBeBroadcasted(false);
+}
+
+void PhysicsList::SetPreset(const G4String& preset)
+{
+  if (fConstructed) {
+    G4Exception("PhysicsList::SetPreset()", "Physics_AlreadyConstructed", JustWarning,
+                "물리 모듈이 이미 등록되어 프리셋을 바꿀 수 없습니다. --physics 옵션이나 --preinit 매크로를 사용하십시오.");
+    return;
+  }
+  fPreset = preset;
+}
+
+/**
+ * @brief 현재 프리셋의 물리 모듈을 등록합니다.
  * 각 RegisterPhysics 호출은 시뮬레이션에 새로운 물리적 능력을 부여합니다.
  */
-PhysicsList::PhysicsList() : G4VModularPhysicsList()
+void PhysicsList::ConstructPreset()
 {
+  if (fConstructed) return;
+
+  const G4bool withHadronic = (fPreset == "full");
+  const G4bool withOptical = (fPreset != "nooptical");
+  if (!withHadronic && fPreset != "minimal" && fPreset != "nooptical") {
+    G4Exception("PhysicsList::ConstructPreset()", "Physics_UnknownPreset", FatalException,
+                ("알 수 없는 물리 프리셋입니다 (full, minimal, nooptical 중 하나): " + fPreset).c_str());
+    return;
+  }
+  fConstructed = true;
+
   // 1. 표준 전자기 물리 (Standard Electromagnetic Physics)
   // 감마선의 광전효과, 컴프턴 산란, 쌍생성 및 전자의 이온화, 제동복사, 다중산란 등
   // 모든 기본적인 전자기 상호작용을 처리하는 필수 모듈입니다.
@@ -34,32 +151,102 @@ PhysicsList::PhysicsList() : G4VModularPhysicsList()
   // 이 모듈을 등록해야 /process/had/rdm/ 과 같은 UI 명령어를 사용할 수 있습니다.
   RegisterPhysics(new G4RadioactiveDecayPhysics());
 
-  // 3. 강입자, 이온, 정지 관련 물리 (Hadronic, Ion, Stopping Physics)
-  // FTFP_BERT 모델과 고정밀 중성자 모델(HP)을 결합한 강입자 상호작용을 등록합니다.
-  RegisterPhysics(new G4HadronPhysicsFTFP_BERT_HP());
-  // 고정밀 중성자 탄성 산란을 처리합니다.
-  RegisterPhysics(new G4HadronElasticPhysicsHP());
-  // 이온(alpha, 중이온 등)의 물리적 상호작용을 처리합니다.
-  RegisterPhysics(new G4IonPhysics());
-  // 입자가 정지할 때 일어나는 현상(예: 반양성자 소멸)을 처리합니다.
-  RegisterPhysics(new G4StoppingPhysics());
-  
+  // 3. 강입자, 이온, 정지 관련 물리 (Hadronic, Ion, Stopping Physics) - full 프리셋만
+  // 밀봉 Co-60 감마 선원에는 영향이 없지만, HP 데이터 로딩과 테이블 생성이 시작 시간의 대부분을 차지합니다.
+  if (withHadronic) {
+    // FTFP_BERT 모델과 고정밀 중성자 모델(HP)을 결합한 강입자 상호작용을 등록합니다.
+    RegisterPhysics(new G4HadronPhysicsFTFP_BERT_HP());
+    // 고정밀 중성자 탄성 산란을 처리합니다.
+    RegisterPhysics(new G4HadronElasticPhysicsHP());
+    // 이온(alpha, 중이온 등)의 물리적 상호작용을 처리합니다.
+    RegisterPhysics(new G4IonPhysics());
+    // 입자가 정지할 때 일어나는 현상(예: 반양성자 소멸)을 처리합니다.
+    RegisterPhysics(new G4StoppingPhysics());
+  }
+
   // 4. 광학 물리 및 스텝 제한자 (Optical & Step Limiter Physics)
   // 섬광(Scintillation), 체렌코프(Cerenkov), 흡수(Absorption),
   // 경계면에서의 반사/굴절 등 모든 광학 관련 프로세스를 등록합니다.
-  RegisterPhysics(new G4OpticalPhysics());
-  
+  if (withOptical) {
+    RegisterPhysics(new G4OpticalPhysics());
+  }
+
   // 매크로에서 /process/eLoss/stepMax 명령어를 통해 입자의 최대 스텝 길이를
   // 제한할 수 있게 해줍니다. 광자 추적 시 유용하게 사용될 수 있습니다.
   RegisterPhysics(new G4StepLimiterPhysics());
-  
-  // 2차 입자 생성을 위한 기준 거리(Production Cut)를 1mm로 설정합니다.
-  // 이 거리보다 짧은 거리를 날아가는 2차 입자는 생성되지 않고 에너지가 즉시 흡수됩니다.
-  SetDefaultCutValue(1.0*mm);
+
+  // 5. 감마 중요도 편향 (선택)
+  // ImportanceWorld 병렬 세계의 셀 경계에서 감마 트랙을 나누거나 줄이고, 가중치를 조정합니다.
+  // 2차 입자와 광학 광자는 부모의 가중치를 물려받으므로 LSSD/PMTSD Hit의 weight에 그대로 반영됩니다.
+  if (fImportanceEnabled) {
+    fGeometrySampler = new G4GeometrySampler(ImportanceWorld::kWorldName, "gamma");
+    fGeometrySampler->SetParallel(true);
+    RegisterPhysics(new G4ImportanceBiasing(fGeometrySampler, ImportanceWorld::kWorldName));
+    RegisterPhysics(new G4ParallelWorldPhysics(ImportanceWorld::kWorldName));
+    G4cout << "--> Gamma importance biasing: " << fImportance.shells << " shells per unit, ratio "
+           << fImportance.ratio << ", outer radius " << fImportance.outerRadius / cm << " cm" << G4endl;
+  }
+
+  G4cout << "--> Physics preset: " << fPreset << G4endl;
+
+  // 6. 물리 테이블 캐시
+  // 같은 키의 캐시가 완성되어 있으면 첫 Run에서 테이블을 계산하지 않고 파일에서 읽습니다.
+  if (!fCacheEnabled) return;
+  G4String directory = GetCacheKeyDirectory();
+  if (IsCacheComplete(directory)) {
+    SetPhysicsTableRetrieved(directory);
+    fRetrievedFrom = directory;
+    G4cout << "--> Physics tables will be retrieved from cache: " << directory << G4endl;
+  }
+  else {
+    G4cout << "--> No physics table cache yet; tables built in this job will be stored in: " << directory << G4endl;
+  }
+}
+
+G4String PhysicsList::GetCacheKeyDirectory() const
+{
+  std::ostringstream key;
+  key << fCacheRoot << "/" << fPreset << "_g4" << G4VERSION_NUMBER << "_cut";
+  const char* particles[] = {"gamma", "e-", "e+", "proton"};
+  for (std::size_t i = 0; i < 4; ++i) {
+    if (i > 0) key << "-";
+    key << std::lround(GetCutValue(particles[i]) / um);
+  }
+  key << "um";
+  return key.str();
+}
+
+G4bool PhysicsList::IsCacheComplete(const G4String& directory) const
+{
+  std::error_code error;
+  return std::filesystem::exists(std::string(directory) + "/" + kCacheCompleteMarker, error);
 }
 
 /**
- * @brief 소멸자
+ * @brief 첫 Run에서 계산한 물리 테이블을 캐시에 저장합니다.
+ * 캐시에서 읽은 경우나, 아직 Run이 없어 테이블이 만들어지지 않은 경우에는 아무것도 하지 않습니다.
+ * Run 사이에 /run/setCut으로 컷을 바꿨다면 키가 달라지므로 바뀐 컷의 디렉터리에 저장됩니다.
  */
-PhysicsList::~PhysicsList()
-{}
+void PhysicsList::StorePhysicsTableCache()
+{
+  if (!fCacheEnabled || !fConstructed) return;
+  // 재료-컷 쌍(couple) 테이블은 첫 Run 초기화에서 만들어집니다.
+  if (G4ProductionCutsTable::GetProductionCutsTable()->GetTableSize() == 0) return;
+
+  G4String directory = GetCacheKeyDirectory();
+  if (IsPhysicsTableRetrieved() && directory == fRetrievedFrom) return;
+  if (IsCacheComplete(directory)) return;
+
+  std::error_code error;
+  std::filesystem::create_directories(std::string(directory), error);
+  if (error || !StorePhysicsTable(directory)) {
+    G4Exception("PhysicsList::StorePhysicsTableCache()", "Physics_CacheError", JustWarning,
+                ("물리 테이블 캐시를 저장하지 못했습니다: " + directory).c_str());
+    return;
+  }
+
+  // 표시 파일은 모든 테이블 파일을 쓴 다음에 만들어, 중단된 저장을 다음 실행이 읽지 않게 합니다.
+  std::ofstream marker(std::string(directory) + "/" + kCacheCompleteMarker);
+  marker << fPreset << "\n";
+  G4cout << "--> Physics tables stored in cache: " << directory << G4endl;
+}
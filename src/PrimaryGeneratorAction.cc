@@ -1,7 +1,53 @@
 #include "PrimaryGeneratorAction.hh"
+#include "DetectorConstruction.hh"
+#include "EventWeightInfo.hh"
+#include "OutputWriter.hh"
+#include "ShardManager.hh"
 
 #include "G4Event.hh"
 #include "G4GeneralParticleSource.hh" // GPS 헤더 파일 포함
+#include "G4GenericMessenger.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4Gamma.hh"
+#include "G4Electron.hh"
+#include "G4RotationMatrix.hh"
+#include "G4RunManager.hh"
+#include "G4Run.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+  // ⁶⁰Co → ⁶⁰Ni: 베타 붕괴(99.88%)가 2505 keV 4⁺ 준위를 채우고, 두 감마가 연달아 방출됩니다.
+  // (1332 keV 준위로 가는 0.12% 베타 갈래는 무시합니다.)
+  constexpr G4double kGamma1Energy = 1173.228*keV;   // 4⁺ → 2⁺
+  constexpr G4double kGamma2Energy = 1332.492*keV;   // 2⁺ → 0⁺
+  constexpr G4double kBetaEndpoint = 317.88*keV;
+  constexpr G4double kDaughterZ = 28.;
+
+  // 4(2)2(2)0 캐스케이드의 각도 상관 계수
+  constexpr G4double kA2 = 1./8.;
+  constexpr G4double kA4 = 1./24.;
+  constexpr G4double kCorrelationMax = 1. + kA2 + kA4;  // W(0) = W(180°)
+  constexpr G4double kCorrelationNorm = 1. + kA2/3. + kA4/5.;  // 구면 평균 <W>
+
+  // 꼭짓점이 있을 수 있는 선원 원기둥의 외접구 반지름
+  const G4double kSourceBoundingRadius = std::sqrt(DetectorConstruction::kSourceRadius * DetectorConstruction::kSourceRadius
+                                                   + DetectorConstruction::kSourceHalfZ * DetectorConstruction::kSourceHalfZ);
+  // LS 병의 외접구 반지름 (LS 중심 기준)
+  const G4double kLSBoundingRadius = std::sqrt(DetectorConstruction::kBottleOuterRadius * DetectorConstruction::kBottleOuterRadius
+                                               + DetectorConstruction::kLSHalfZ * DetectorConstruction::kLSHalfZ);
+
+  G4double AngularCorrelation(G4double cosTheta)
+  {
+    const G4double c2 = cosTheta*cosTheta;
+    return 1. + kA2*c2 + kA4*c2*c2;
+  }
+}
 
 /**
  * @brief 생성자 (Constructor)
@@ -9,11 +55,25 @@
  * PrimaryGeneratorAction 객체가 생성될 때 호출됩니다.
  * G4GeneralParticleSource(GPS) 객체를 생성하여 멤버 변수에 할당합니다.
  * GPS는 Geant4에서 제공하는 가장 강력하고 유연한 입자 생성기입니다.
+ * cascade 모드에서도 /gps/ 명령어가 있는 매크로를 그대로 쓸 수 있도록 GPS는 항상 만듭니다.
  */
 PrimaryGeneratorAction::PrimaryGeneratorAction()
-: G4VUserPrimaryGeneratorAction(), fGPS(nullptr)
+: G4VUserPrimaryGeneratorAction(), fGPS(nullptr),
+  fUseCascade(false), fEmitBeta(false), fCorrelation(true),
+  fBetaSpectrumMax(0.), fForceDirection(false), fForcedGammas(2), fConeMargin(2.*mm), fIsotropicFraction(0.1),
+  fConeRunID(-1),
+  fMessenger(nullptr)
 {
   fGPS = new G4GeneralParticleSource();
+
+  // 베타 스펙트럼의 최댓값을 격자에서 찾아 기각 샘플링의 상한으로 씁니다. (여유 5%)
+  const G4int nSteps = 1000;
+  for (G4int i = 1; i < nSteps; ++i) {
+    fBetaSpectrumMax = std::max(fBetaSpectrumMax, BetaSpectrum(kBetaEndpoint*i/nSteps));
+  }
+  fBetaSpectrumMax *= 1.05;
+
+  DefineCommands();
 }
 
 /**
@@ -25,6 +85,56 @@ PrimaryGeneratorAction::PrimaryGeneratorAction()
 PrimaryGeneratorAction::~PrimaryGeneratorAction()
 {
   delete fGPS;
+  delete fMessenger;
+}
+
+void PrimaryGeneratorAction::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/myApp/generator/", "Primary generator control.");
+
+  auto& modeCmd = fMessenger->DeclareMethod("mode", &PrimaryGeneratorAction::SetMode,
+                                            "Primary mode: gps (Co-60 ion + radioactive decay) or cascade (direct 1173/1332 keV gamma cascade).");
+  modeCmd.SetParameterName("Mode", false);
+  modeCmd.SetCandidates("gps cascade");
+  modeCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+  auto& betaCmd = fMessenger->DeclareProperty("emitBeta", fEmitBeta,
+                                              "cascade mode: also emit the beta electron (318 keV endpoint).");
+  betaCmd.SetParameterName("Flag", false);
+  betaCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+  auto& correlationCmd = fMessenger->DeclareProperty("angularCorrelation", fCorrelation,
+                                                     "cascade mode: apply the 4-2-0 gamma-gamma angular correlation (false = independent isotropic gammas).");
+  correlationCmd.SetParameterName("Flag", false);
+  correlationCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+  auto& forceCmd = fMessenger->DeclareProperty("forceDirection", fForceDirection,
+                                               "cascade mode: emit gammas only into cones around the detector units and weight the event.");
+  forceCmd.SetParameterName("Flag", false);
+  forceCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+  auto& forcedCmd = fMessenger->DeclareProperty("forcedGammas", fForcedGammas,
+                                                "Number of cascade gammas forced into the cones (1 = 1173 keV only, 2 = both).");
+  forcedCmd.SetParameterName("N", false);
+  forcedCmd.SetRange("N>=1 && N<=2");
+  forcedCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+  auto& marginCmd = fMessenger->DeclarePropertyWithUnit("coneMargin", "mm", fConeMargin,
+                                                        "Margin added to the LS bounding radius when building the forced-direction cones.");
+  marginCmd.SetParameterName("Margin", false);
+  marginCmd.SetRange("Margin>=0.");
+  marginCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+  auto& isotropicCmd = fMessenger->DeclareProperty("isotropicFraction", fIsotropicFraction,
+                                                   "Fraction of forced gammas drawn isotropically instead of into the cones (keeps every direction sampled).");
+  isotropicCmd.SetParameterName("Fraction", false);
+  isotropicCmd.SetRange("Fraction>0. && Fraction<=1.");
+  isotropicCmd.SetStates(G4State_PreInit, G4State_Idle);
+}
+
+void PrimaryGeneratorAction::SetMode(const G4String& mode)
+{
+  fUseCascade = (mode == "cascade");
 }
 
 /**
@@ -32,12 +142,192 @@ PrimaryGeneratorAction::~PrimaryGeneratorAction()
  * @param anEvent 현재 이벤트에 대한 정보를 담고 있는 객체 포인터
  *
  * 매 이벤트 시작 시 Geant4 커널에 의해 호출됩니다.
- * GPS의 GeneratePrimaryVertex() 함수를 호출하여, 매크로 파일(.mac)에 정의된
+ * gps 모드에서는 GPS의 GeneratePrimaryVertex() 함수를 호출하여, 매크로 파일(.mac)에 정의된
  * 설정에 따라 초기 입자를 생성하고 현재 이벤트(anEvent)에 주입합니다.
  * 이 방식은 C++ 코드를 재컴파일하지 않고도 소스의 종류, 위치, 에너지, 방출 각도 등
  * 복잡한 설정을 자유롭게 변경할 수 있게 해주는 장점이 있습니다.
  */
 void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
 {
+  // shard 모드: 이벤트의 첫 난수를 쓰기 전에 (런 시드, 전역 이벤트 번호)로 스레드 엔진을 다시 초기화합니다.
+  auto shard = ShardManager::Instance();
+  if (shard->IsPerEventSeeding()) {
+    shard->SeedEvent(OutputWriter::Instance()->GetEventIDOffset() + anEvent->GetEventID());
+  }
+
+  if (fUseCascade) {
+    GenerateCascade(anEvent);
+    return;
+  }
   fGPS->GeneratePrimaryVertex(anEvent);
 }
+
+/**
+ * @brief 한 꼭짓점에서 감마 두 개(와 선택적으로 베타 전자)를 방출합니다.
+ * 2⁺ 준위의 수명(약 0.7 ps)은 무시하므로 모든 입자는 같은 위치, 시간 0에서 출발합니다.
+ */
+void PrimaryGeneratorAction::GenerateCascade(G4Event* anEvent)
+{
+  auto vertex = new G4PrimaryVertex(SampleSourceVertex(), 0.);
+
+  if (fForceDirection) UpdateCones();
+  const G4bool forced = fForceDirection && !fCones.empty();
+
+  // 방향 강제: 가중치 = 실제 밀도 / 편향된 밀도. 첫 감마의 실제 밀도는 1/4π,
+  // 두 번째 감마의 실제 밀도는 첫 감마에 대한 조건부 밀도 W(θ)/(4π<W>)입니다.
+  // 편향된 밀도는 등방 성분을 섞은 방어적 혼합이므로 모든 방향에서 0보다 크고, 감마당 가중치는 약 1/isotropicFraction 이하입니다.
+  G4double weight = 1.;
+  G4ThreeVector direction1 = forced ? SampleForcedDirection() : SampleIsotropicDirection();
+  if (forced) weight /= 4.*pi * ForcedDirectionDensity(direction1);
+
+  G4ThreeVector direction2;
+  if (forced && fForcedGammas == 2) {
+    direction2 = SampleForcedDirection();
+    const G4double density = fCorrelation ? AngularCorrelation(direction1.dot(direction2)) / kCorrelationNorm : 1.;
+    weight *= density / (4.*pi * ForcedDirectionDensity(direction2));
+  }
+  else {
+    direction2 = fCorrelation ? SampleCorrelatedDirection(direction1) : SampleIsotropicDirection();
+  }
+
+  auto gamma1 = new G4PrimaryParticle(G4Gamma::Definition());
+  gamma1->SetKineticEnergy(kGamma1Energy);
+  gamma1->SetMomentumDirection(direction1);
+  vertex->SetPrimary(gamma1);
+
+  auto gamma2 = new G4PrimaryParticle(G4Gamma::Definition());
+  gamma2->SetKineticEnergy(kGamma2Energy);
+  gamma2->SetMomentumDirection(direction2);
+  vertex->SetPrimary(gamma2);
+
+  if (fEmitBeta) {
+    auto beta = new G4PrimaryParticle(G4Electron::Definition());
+    beta->SetKineticEnergy(SampleBetaEnergy());
+    beta->SetMomentumDirection(SampleIsotropicDirection());
+    vertex->SetPrimary(beta);
+  }
+
+  anEvent->AddPrimaryVertex(vertex);
+  if (forced) anEvent->SetUserInformation(new EventWeightInfo(weight));
+}
+
+/**
+ * @brief 검출기 배치(거리, 유닛 각도)로부터 유닛별 원뿔을 계산합니다. 배치는 런 사이에만 바뀌므로 런마다 한 번.
+ *
+ * 선원 안의 꼭짓점 v(|v| <= s)에서 출발해 LS 외접구(중심 c, 반지름 R)에 닿는 방향 u는
+ * 원점을 지나는 직선과 c 사이의 거리가 R + s 이하이므로, 축 c/|c|, sinα = (R + s + 여유)/|c|인 원뿔 안에 있습니다.
+ */
+void PrimaryGeneratorAction::UpdateCones()
+{
+  const G4Run* run = G4RunManager::GetRunManager()->GetCurrentRun();
+  const G4int runID = run ? run->GetRunID() : -1;
+  if (runID == fConeRunID && !fCones.empty()) return;
+  fConeRunID = runID;
+
+  fCones.clear();
+  auto detector = static_cast<const DetectorConstruction*>(G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  if (!detector) return;
+
+  const G4double distance = detector->GetDetectorDistance();
+  const G4double sinHalfAngle = std::min(1., (kLSBoundingRadius + kSourceBoundingRadius + fConeMargin) / distance);
+  const G4double cosHalfAngle = std::sqrt(1. - sinHalfAngle*sinHalfAngle);
+  for (G4double angle : detector->GetUnitAngles()) {
+    fCones.push_back({G4ThreeVector(std::cos(angle), 0., std::sin(angle)), cosHalfAngle, twopi * (1. - cosHalfAngle)});
+  }
+}
+
+/**
+ * @brief 방어적 혼합 q = ε/4π + (1 - ε)·(원뿔 밀도)에서 방향을 뽑습니다. (ε = isotropicFraction)
+ * 원뿔 성분은 원뿔 하나를 균등하게 고른 뒤 그 안에서 균일한 방향을 뽑습니다.
+ */
+G4ThreeVector PrimaryGeneratorAction::SampleForcedDirection() const
+{
+  if (G4UniformRand() < fIsotropicFraction) return SampleIsotropicDirection();
+
+  const size_t index = std::min(fCones.size() - 1, static_cast<size_t>(G4UniformRand() * fCones.size()));
+  const Cone& cone = fCones[index];
+
+  const G4double cosTheta = 1. - G4UniformRand() * (1. - cone.cosHalfAngle);
+  const G4double sinTheta = std::sqrt(std::max(0., 1. - cosTheta*cosTheta));
+  const G4double phi = twopi * G4UniformRand();
+  G4ThreeVector direction(sinTheta*std::cos(phi), sinTheta*std::sin(phi), cosTheta);
+  direction.rotateUz(cone.axis);
+  return direction;
+}
+
+G4double PrimaryGeneratorAction::ForcedDirectionDensity(const G4ThreeVector& direction) const
+{
+  G4double coneDensity = 0.;
+  for (const auto& cone : fCones) {
+    if (direction.dot(cone.axis) >= cone.cosHalfAngle) coneDensity += 1. / cone.solidAngle;
+  }
+  return fIsotropicFraction / (4.*pi) + (1. - fIsotropicFraction) * coneDensity / fCones.size();
+}
+
+/**
+ * @brief 선원 원기둥 안에서 균일한 꼭짓점을 뽑습니다. (기각 없음)
+ * 선원은 에폭시 안에 회전 없이, 에폭시는 World에 Y축으로 90도 회전해 배치되어 있으므로
+ * 같은 회전을 적용해 World 좌표로 옮깁니다.
+ */
+G4ThreeVector PrimaryGeneratorAction::SampleSourceVertex() const
+{
+  const G4double r = DetectorConstruction::kSourceRadius * std::sqrt(G4UniformRand());
+  const G4double phi = twopi * G4UniformRand();
+  const G4double z = DetectorConstruction::kSourceHalfZ * (2.*G4UniformRand() - 1.);
+
+  G4RotationMatrix sourceRotation;
+  sourceRotation.rotateY(90.*deg);
+  return sourceRotation.inverse() * G4ThreeVector(r*std::cos(phi), r*std::sin(phi), z);
+}
+
+G4ThreeVector PrimaryGeneratorAction::SampleIsotropicDirection() const
+{
+  const G4double cosTheta = 2.*G4UniformRand() - 1.;
+  const G4double sinTheta = std::sqrt(std::max(0., 1. - cosTheta*cosTheta));
+  const G4double phi = twopi * G4UniformRand();
+  return G4ThreeVector(sinTheta*std::cos(phi), sinTheta*std::sin(phi), cosTheta);
+}
+
+/**
+ * @brief 첫 번째 감마에 대한 사잇각 θ를 W(cosθ)에서 기각 샘플링하고, 방위각은 균일하게 뽑습니다.
+ * 받아들일 확률의 평균이 (1 + a₂/3 + a₄/5)/W_max ≈ 0.9이므로 반복은 거의 없습니다.
+ */
+G4ThreeVector PrimaryGeneratorAction::SampleCorrelatedDirection(const G4ThreeVector& first) const
+{
+  G4double cosTheta = 0.;
+  do {
+    cosTheta = 2.*G4UniformRand() - 1.;
+  } while (G4UniformRand() * kCorrelationMax > AngularCorrelation(cosTheta));
+
+  const G4double sinTheta = std::sqrt(std::max(0., 1. - cosTheta*cosTheta));
+  const G4double phi = twopi * G4UniformRand();
+  G4ThreeVector direction(sinTheta*std::cos(phi), sinTheta*std::sin(phi), cosTheta);
+  // 첫 번째 감마 방향을 z축으로 하는 좌표계에서 World 좌표계로 돌립니다.
+  direction.rotateUz(first);
+  return direction;
+}
+
+/**
+ * @brief 허용 전이 베타 스펙트럼 N(T) ∝ F(Z, E) p E (T₀ - T)²
+ * 페르미 함수는 비상대론적 근사 F = 2πη / (1 - exp(-2πη)), η = Zα E / p 를 씁니다.
+ */
+G4double PrimaryGeneratorAction::BetaSpectrum(G4double kineticEnergy) const
+{
+  if (kineticEnergy <= 0. || kineticEnergy >= kBetaEndpoint) return 0.;
+
+  const G4double totalEnergy = kineticEnergy + electron_mass_c2;
+  const G4double momentum = std::sqrt(totalEnergy*totalEnergy - electron_mass_c2*electron_mass_c2);
+  const G4double eta = kDaughterZ * fine_structure_const * totalEnergy / momentum;
+  const G4double fermi = twopi*eta / (1. - std::exp(-twopi*eta));
+  const G4double remaining = kBetaEndpoint - kineticEnergy;
+  return fermi * momentum * totalEnergy * remaining * remaining;
+}
+
+G4double PrimaryGeneratorAction::SampleBetaEnergy() const
+{
+  G4double kineticEnergy = 0.;
+  do {
+    kineticEnergy = kBetaEndpoint * G4UniformRand();
+  } while (G4UniformRand() * fBetaSpectrumMax > BetaSpectrum(kineticEnergy));
+  return kineticEnergy;
+}
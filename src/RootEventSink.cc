@@ -0,0 +1,168 @@
+#include "RootEventSink.hh"
+#include "EventRecord.hh"
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TROOT.h"
+
+#include <cstdio>
+
+RootEventSink::RootEventSink()
+: fFile(nullptr), fHitsTree(nullptr), fSummaryTree(nullptr),
+  fPMTHitsTree(nullptr), fPMTSummaryTree(nullptr), fDictionaryTree(nullptr),
+  fEventID(0), fDetectorID(0), fTrackID(0), fParentID(0),
+  fParticleCode(0), fProcessCode(0), fVolumeCode(0),
+  fX(0.), fY(0.), fZ(0.), fTime(0.), fKineticEnergy(0.), fEnergyDeposit(0.), fStepWeight(0.),
+  fNPrimaries(0), fNSecondaries(0),
+  fEdep(0.), fVisibleEnergy(0.), fCentroidX(0.), fCentroidY(0.), fCentroidZ(0.), fFirstTime(0.), fUnitWeight(0.),
+  fPMTID(0), fNPE(0),
+  fPMTTime(0.), fWeight(0.), fWeightedPE(0.), fPMTFirstTime(0.), fMedianTime(0.), fLastTime(0.),
+  fCode(0), fName()
+{}
+
+RootEventSink::~RootEventSink()
+{
+  // Close()가 호출되지 않은 경우(비정상 종료)에도 파일 핸들을 정리합니다.
+  delete fFile;
+}
+
+G4bool RootEventSink::Open(const G4String& fileName)
+{
+  // 파일은 Master 스레드에서 열고 쓰기 스레드에서 채우므로, ROOT의 전역 상태를 스레드별로 둡니다.
+  ROOT::EnableThreadSafety();
+
+  fFile = TFile::Open(fileName.c_str(), "RECREATE");
+  if (!fFile || fFile->IsZombie()) {
+    delete fFile;
+    fFile = nullptr;
+    return false;
+  }
+
+  fHitsTree = new TTree("Hits", "Hit-by-hit energy deposition data");
+  fHitsTree->Branch("eventID", &fEventID);
+  fHitsTree->Branch("detectorID", &fDetectorID);
+  fHitsTree->Branch("trackID", &fTrackID);
+  fHitsTree->Branch("parentID", &fParentID);
+  fHitsTree->Branch("particleCode", &fParticleCode);
+  fHitsTree->Branch("processCode", &fProcessCode);
+  fHitsTree->Branch("volumeCode", &fVolumeCode);
+  fHitsTree->Branch("x_mm", &fX);
+  fHitsTree->Branch("y_mm", &fY);
+  fHitsTree->Branch("z_mm", &fZ);
+  fHitsTree->Branch("time_ns", &fTime);
+  fHitsTree->Branch("kineticEnergy_MeV", &fKineticEnergy);
+  fHitsTree->Branch("energyDeposit_MeV", &fEnergyDeposit);
+  fHitsTree->Branch("weight", &fStepWeight);
+
+  fSummaryTree = new TTree("EventSummary", "Per-event, per-detector summary for LS hits");
+  fSummaryTree->Branch("eventID", &fEventID);
+  fSummaryTree->Branch("detectorID", &fDetectorID);
+  fSummaryTree->Branch("nPrimaries_LS", &fNPrimaries);
+  fSummaryTree->Branch("nSecondaries_LS", &fNSecondaries);
+  fSummaryTree->Branch("edep_MeV", &fEdep);
+  fSummaryTree->Branch("visibleEnergy_MeV", &fVisibleEnergy);
+  fSummaryTree->Branch("centroidX_mm", &fCentroidX);
+  fSummaryTree->Branch("centroidY_mm", &fCentroidY);
+  fSummaryTree->Branch("centroidZ_mm", &fCentroidZ);
+  fSummaryTree->Branch("firstTime_ns", &fFirstTime);
+  fSummaryTree->Branch("weight", &fUnitWeight);
+
+  fPMTHitsTree = new TTree("PMTHits", "Individual photon hits in PMTs");
+  fPMTHitsTree->Branch("eventID", &fEventID);
+  fPMTHitsTree->Branch("pmtID", &fPMTID);
+  fPMTHitsTree->Branch("time_ns", &fPMTTime);
+  fPMTHitsTree->Branch("weight", &fWeight);
+
+  fPMTSummaryTree = new TTree("PMTSummary", "Per-event, per-PMT photoelectron summary");
+  fPMTSummaryTree->Branch("eventID", &fEventID);
+  fPMTSummaryTree->Branch("pmtID", &fPMTID);
+  fPMTSummaryTree->Branch("nPE", &fNPE);
+  fPMTSummaryTree->Branch("weightedPE", &fWeightedPE);
+  fPMTSummaryTree->Branch("firstTime_ns", &fPMTFirstTime);
+  fPMTSummaryTree->Branch("medianTime_ns", &fMedianTime);
+  fPMTSummaryTree->Branch("lastTime_ns", &fLastTime);
+  fPMTSummaryTree->Branch("timeHist", &fTimeHist);
+
+  fDictionaryTree = new TTree("Dictionary", "Name codes used in the Hits tree");
+  fDictionaryTree->Branch("code", &fCode);
+  fDictionaryTree->Branch("name", fName, "name/C");
+
+  // 트리는 생성 시점의 gDirectory에 붙으므로, 쓰기 스레드에서도 이 파일에 기록되도록 명시합니다.
+  for (TTree* tree : {fHitsTree, fSummaryTree, fPMTHitsTree, fPMTSummaryTree, fDictionaryTree}) {
+    tree->SetDirectory(fFile);
+  }
+  return true;
+}
+
+void RootEventSink::Write(const EventRecord& record)
+{
+  fEventID = record.eventID;
+
+  const LSHitBuffer& steps = record.steps;
+  for (size_t i = 0; i < steps.Size(); ++i) {
+    fDetectorID = steps.GetDetectorID()[i];
+    fTrackID = steps.GetTrackID()[i];
+    fParentID = steps.GetParentID()[i];
+    fParticleCode = steps.GetParticleCode()[i];
+    fProcessCode = steps.GetProcessCode()[i];
+    fVolumeCode = steps.GetVolumeCode()[i];
+    fX = steps.GetX()[i];
+    fY = steps.GetY()[i];
+    fZ = steps.GetZ()[i];
+    fTime = steps.GetTime()[i];
+    fKineticEnergy = steps.GetKineticEnergy()[i];
+    fEnergyDeposit = steps.GetEnergyDeposit()[i];
+    fStepWeight = steps.GetWeight()[i];
+    fHitsTree->Fill();
+  }
+
+  for (const auto& unit : record.units) {
+    fDetectorID = unit.detectorID;
+    fNPrimaries = unit.nPrimaries;
+    fNSecondaries = unit.nSecondaries;
+    fEdep = unit.edep;
+    fVisibleEnergy = unit.visibleEnergy;
+    fCentroidX = unit.centroidX;
+    fCentroidY = unit.centroidY;
+    fCentroidZ = unit.centroidZ;
+    fFirstTime = unit.firstTime;
+    fUnitWeight = unit.weight;
+    fSummaryTree->Fill();
+  }
+
+  for (const auto& hit : record.pmtHits) {
+    fPMTID = hit.pmtID;
+    fPMTTime = hit.time;
+    fWeight = hit.weight;
+    fPMTHitsTree->Fill();
+  }
+
+  for (size_t row = 0; row < record.pmtSummaries.size(); ++row) {
+    const auto& summary = record.pmtSummaries[row];
+    fPMTID = summary.pmtID;
+    fNPE = summary.nPE;
+    fWeightedPE = summary.weightedPE;
+    fPMTFirstTime = summary.firstTime;
+    fMedianTime = summary.medianTime;
+    fLastTime = summary.lastTime;
+    auto first = record.pmtTimeHist.begin() + row * record.pmtTimeBins;
+    fTimeHist.assign(first, first + record.pmtTimeBins);
+    fPMTSummaryTree->Fill();
+  }
+}
+
+void RootEventSink::Close(const std::vector<G4String>& dictionary)
+{
+  if (!fFile) return;
+
+  for (size_t code = 0; code < dictionary.size(); ++code) {
+    fCode = static_cast<G4int>(code);
+    std::snprintf(fName, sizeof(fName), "%s", dictionary[code].c_str());
+    fDictionaryTree->Fill();
+  }
+
+  fFile->Write();
+  fFile->Close();
+  delete fFile; // 파일이 소유한 트리들도 함께 해제됩니다.
+  fFile = nullptr;
+}
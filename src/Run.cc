@@ -0,0 +1,431 @@
+#include "Run.hh"
+#include "DetectorConstruction.hh"
+#include "EventWeightInfo.hh"
+#include "LSSD.hh"
+#include "PMTHit.hh"
+
+#include "G4Event.hh"
+#include "G4HCofThisEvent.hh"
+#include "G4RunManager.hh"
+#include "G4SDManager.hh"
+#include "G4ios.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+namespace {
+  const char* kPhotonKillRuleNames[Run::kNumPhotonKillRules] = {
+    "outsideAssembly", "deadVolume", "timeWindow", "maxReflections"
+  };
+
+  void AddWeights(std::vector<Run::WeightSum>& sums, const std::vector<Run::WeightSum>& other)
+  {
+    if (sums.size() < other.size()) sums.resize(other.size());
+    for (size_t i = 0; i < other.size(); ++i) sums[i].Add(other[i]);
+  }
+
+  // W = N·C/(S_a·S_b)의 상대 분산. C ⊂ S_a ∩ S_b이므로 이벤트 단위 공분산
+  // Cov(X, Y) = Σw²(X∩Y) - X·Y/N 을 모두 넣으면 Var(W)/W² = C2/C² + A2/A² + B2/B² - 2·C2/(C·A) - 2·C2/(C·B) + 2·O2/(A·B) - 1/N
+  // 입니다. (O = 두 PMT가 모두 트리거된 이벤트, 가중치 1이고 A = B = C이면 이항 분포의 1/C - 1/N)
+  G4double WRelativeVariance(const Run::WeightSum& c, const Run::WeightSum& a, const Run::WeightSum& b,
+                             const Run::WeightSum& overlap, G4int nEvents)
+  {
+    const G4double variance = c.sum2 / (c.sum * c.sum) + a.sum2 / (a.sum * a.sum) + b.sum2 / (b.sum * b.sum)
+                            - 2. * c.sum2 / (c.sum * a.sum) - 2. * c.sum2 / (c.sum * b.sum)
+                            + 2. * overlap.sum2 / (a.sum * b.sum) - 1. / nEvents;
+    return std::max(0., variance);
+  }
+}
+
+G4double Run::WeightSum::RateError(G4int nEvents) const
+{
+  if (nEvents <= 0) return 0.;
+  return std::sqrt(std::max(0., sum2 - sum*sum / nEvents)) / nEvents;
+}
+
+Run::Run(const CoincidenceSettings& settings, G4bool coincidenceEnabled)
+: G4Run(), fOpticalSteps(0), fTriggerAccepted(0), fTriggerRejected(0), fStackingAccepted(0), fStackingRejected(0),
+  fSettings(settings),
+  fCoincidenceEnabled(coincidenceEnabled), fLSSD(nullptr), fPMTHcID(-1)
+{
+  fPhotonKills.fill(0);
+  fPhotonKillSteps.fill(0);
+}
+
+Run::~Run()
+{}
+
+/**
+ * @brief 이벤트마다 (Worker에서) 호출되어 단일 계수와 동시계수를 누적합니다.
+ *
+ * PMT별 트리거 시각은 광전자를 시간 순으로 더해 가중치 합이 문턱에 도달한 시각입니다. (PMTTrigger)
+ * 같은 PMT 번호는 같은 검출기 유닛 번호이므로(둘 다 유닛의 복사 번호), 에너지 조건은 PMT 번호로 유닛을 찾습니다.
+ */
+void Run::RecordEvent(const G4Event* event)
+{
+  G4Run::RecordEvent(event);
+  if (!fCoincidenceEnabled) return;
+
+  // SD 포인터와 컬렉션 ID는 런 도중 바뀌지 않으므로 처음 한 번만 조회합니다.
+  if (fPMTHcID < 0) {
+    auto sdManager = G4SDManager::GetSDMpointer();
+    fLSSD = static_cast<LSSD*>(sdManager->FindSensitiveDetector("LSSD", false));
+    fPMTHcID = sdManager->GetCollectionID("PMTHitsCollection");
+    if (fPMTHcID < 0) return;
+  }
+
+  // 방향 강제 생성기의 이벤트 가중치 (없으면 1)
+  const G4double weight = EventWeightInfo::EventWeight(event);
+
+  // --- PMT 트리거 ---
+  auto hce = event->GetHCofThisEvent();
+  // 기록 트리거(EventAction)가 같은 이벤트를 먼저 읽었으면 정렬을 다시 하지 않습니다.
+  fTrigger.Load(hce ? static_cast<PMTHitsCollection*>(hce->GetHC(fPMTHcID)) : nullptr, event->GetEventID());
+  fTrigger.Evaluate(fSettings.peThreshold);
+  const auto& triggers = fTrigger.GetTriggers();
+  for (const auto& trigger : triggers) {
+    if (trigger.first >= static_cast<G4int>(fSingles.size())) {
+      fSingles.resize(trigger.first + 1, 0);
+      fSinglesWeight.resize(trigger.first + 1);
+    }
+    ++fSingles[trigger.first];
+    fSinglesWeight[trigger.first].Add(weight);
+  }
+
+  // --- 유닛별 에너지 조건 ---
+  fUnitGated.clear();
+  if (IsGateEnabled() && fLSSD) {
+    const auto& summaries = fLSSD->GetUnitSummaries();
+    fUnitGated.resize(summaries.size(), 0);
+    if (fGatedSingles.size() < summaries.size()) {
+      fGatedSingles.resize(summaries.size(), 0);
+      fGatedSinglesWeight.resize(summaries.size());
+    }
+    for (size_t unit = 0; unit < summaries.size(); ++unit) {
+      const G4double visible = summaries[unit].visibleEdep;
+      if (visible >= fSettings.gateMin && visible <= fSettings.gateMax) {
+        fUnitGated[unit] = 1;
+        ++fGatedSingles[unit];
+        fGatedSinglesWeight[unit].Add(weight);
+      }
+    }
+  }
+
+  // --- PMT 쌍별 동시계수 (트리거는 PMT 번호 순이므로 쌍의 키는 항상 (작은 번호, 큰 번호)) ---
+  auto isGated = [this](G4int unit) {
+    return unit >= 0 && unit < static_cast<G4int>(fUnitGated.size()) && fUnitGated[unit];
+  };
+  for (size_t a = 0; a < triggers.size(); ++a) {
+    for (size_t b = a + 1; b < triggers.size(); ++b) {
+      PairCounts& counts = fPairCounts[{triggers[a].first, triggers[b].first}];
+      counts.overlapWeight.Add(weight);
+      if (std::abs(triggers[a].second - triggers[b].second) * ns > fSettings.window) continue;
+      ++counts.coincidences;
+      counts.weight.Add(weight);
+      if (isGated(triggers[a].first) && isGated(triggers[b].first)) {
+        ++counts.gatedCoincidences;
+        counts.gatedWeight.Add(weight);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Worker 스레드의 Run 객체를 Master의 Run 객체로 병합합니다.
+ */
+void Run::Merge(const G4Run* run)
+{
+  auto localRun = static_cast<const Run*>(run);
+  for (G4int i = 0; i < kNumPhotonKillRules; ++i) {
+    fPhotonKills[i] += localRun->fPhotonKills[i];
+    fPhotonKillSteps[i] += localRun->fPhotonKillSteps[i];
+  }
+  fOpticalSteps += localRun->fOpticalSteps;
+  fTriggerAccepted += localRun->fTriggerAccepted;
+  fTriggerRejected += localRun->fTriggerRejected;
+  fStackingAccepted += localRun->fStackingAccepted;
+  fStackingRejected += localRun->fStackingRejected;
+
+  if (fSingles.size() < localRun->fSingles.size()) fSingles.resize(localRun->fSingles.size(), 0);
+  for (size_t i = 0; i < localRun->fSingles.size(); ++i) fSingles[i] += localRun->fSingles[i];
+  if (fGatedSingles.size() < localRun->fGatedSingles.size()) fGatedSingles.resize(localRun->fGatedSingles.size(), 0);
+  for (size_t i = 0; i < localRun->fGatedSingles.size(); ++i) fGatedSingles[i] += localRun->fGatedSingles[i];
+  AddWeights(fSinglesWeight, localRun->fSinglesWeight);
+  AddWeights(fGatedSinglesWeight, localRun->fGatedSinglesWeight);
+  for (const auto& entry : localRun->fPairCounts) {
+    PairCounts& counts = fPairCounts[entry.first];
+    counts.coincidences += entry.second.coincidences;
+    counts.gatedCoincidences += entry.second.gatedCoincidences;
+    counts.weight.Add(entry.second.weight);
+    counts.gatedWeight.Add(entry.second.gatedWeight);
+    counts.overlapWeight.Add(entry.second.overlapWeight);
+  }
+  fProfile.Merge(localRun->fProfile);
+
+  G4Run::Merge(run);
+}
+
+/**
+ * @brief 동시계수 조건과 카운터를 '키 값...' 줄들로 기록합니다. 같은 순서로 ReadCounters()가 읽습니다.
+ * 값은 Geant4 내부 단위(ns, MeV) 그대로입니다.
+ */
+void Run::WriteCounters(std::ostream& out) const
+{
+  out << "settings " << fSettings.window << " " << fSettings.peThreshold << " "
+      << fSettings.gateMin << " " << fSettings.gateMax << "\n";
+  out << "events " << GetNumberOfEvent() << "\n";
+  out << "photonKills";
+  for (auto kills : fPhotonKills) out << " " << kills;
+  out << "\nphotonKillSteps";
+  for (auto steps : fPhotonKillSteps) out << " " << steps;
+  out << "\nopticalSteps " << fOpticalSteps << "\n";
+  out << "trigger " << fTriggerAccepted << " " << fTriggerRejected << "\n";
+  out << "stacking " << fStackingAccepted << " " << fStackingRejected << "\n";
+  out << "singles " << fSingles.size();
+  for (auto singles : fSingles) out << " " << singles;
+  out << "\ngatedSingles " << fGatedSingles.size();
+  for (auto singles : fGatedSingles) out << " " << singles;
+  out << "\npairs " << fPairCounts.size() << "\n";
+  for (const auto& entry : fPairCounts) {
+    out << entry.first.first << " " << entry.first.second << " "
+        << entry.second.coincidences << " " << entry.second.gatedCoincidences << "\n";
+  }
+
+  // 가중치 합은 재개/병합 후에도 같은 값이 되도록 전체 정밀도로 씁니다.
+  auto oldPrecision = out.precision(17);
+  auto writeWeights = [&out](const char* key, const std::vector<WeightSum>& sums) {
+    out << key << " " << sums.size();
+    for (const auto& sum : sums) out << " " << sum.sum << " " << sum.sum2;
+    out << "\n";
+  };
+  writeWeights("singlesWeight", fSinglesWeight);
+  writeWeights("gatedSinglesWeight", fGatedSinglesWeight);
+  out << "pairWeights " << fPairCounts.size() << "\n";
+  for (const auto& entry : fPairCounts) {
+    out << entry.first.first << " " << entry.first.second << " "
+        << entry.second.weight.sum << " " << entry.second.weight.sum2 << " "
+        << entry.second.gatedWeight.sum << " " << entry.second.gatedWeight.sum2 << " "
+        << entry.second.overlapWeight.sum << " " << entry.second.overlapWeight.sum2 << "\n";
+  }
+  out.precision(oldPrecision);
+}
+
+G4bool Run::ReadCounters(std::istream& in)
+{
+  auto expect = [&in](const char* key) {
+    std::string word;
+    return static_cast<bool>(in >> word) && word == key;
+  };
+
+  if (!expect("settings")
+      || !(in >> fSettings.window >> fSettings.peThreshold >> fSettings.gateMin >> fSettings.gateMax)) return false;
+  if (!expect("events") || !(in >> numberOfEvent)) return false;
+  if (!expect("photonKills")) return false;
+  for (auto& kills : fPhotonKills) in >> kills;
+  if (!expect("photonKillSteps")) return false;
+  for (auto& steps : fPhotonKillSteps) in >> steps;
+  if (!expect("opticalSteps") || !(in >> fOpticalSteps)) return false;
+  if (!expect("trigger") || !(in >> fTriggerAccepted >> fTriggerRejected)) return false;
+  // 2단계 스태킹 줄이 없는 이전 형식은 0으로 두고, 읽은 단어를 되돌립니다.
+  const auto stackingPos = in.tellg();
+  if (!expect("stacking") || !(in >> fStackingAccepted >> fStackingRejected)) {
+    fStackingAccepted = fStackingRejected = 0;
+    in.clear();
+    in.seekg(stackingPos);
+  }
+
+  size_t size = 0;
+  if (!expect("singles") || !(in >> size)) return false;
+  fSingles.assign(size, 0);
+  for (auto& singles : fSingles) in >> singles;
+  if (!expect("gatedSingles") || !(in >> size)) return false;
+  fGatedSingles.assign(size, 0);
+  for (auto& singles : fGatedSingles) in >> singles;
+
+  if (!expect("pairs") || !(in >> size)) return false;
+  fPairCounts.clear();
+  for (size_t i = 0; i < size; ++i) {
+    G4int a = 0, b = 0;
+    PairCounts counts;
+    in >> a >> b >> counts.coincidences >> counts.gatedCoincidences;
+    fPairCounts[{a, b}] = counts;
+  }
+
+  auto readWeights = [&in, &expect](const char* key, std::vector<WeightSum>& sums) {
+    size_t n = 0;
+    if (!expect(key) || !(in >> n)) return false;
+    sums.assign(n, WeightSum());
+    for (auto& sum : sums) in >> sum.sum >> sum.sum2;
+    return static_cast<bool>(in);
+  };
+  if (!readWeights("singlesWeight", fSinglesWeight)) return false;
+  if (!readWeights("gatedSinglesWeight", fGatedSinglesWeight)) return false;
+  if (!expect("pairWeights") || !(in >> size)) return false;
+  std::string text;
+  std::getline(in, text);
+  for (size_t i = 0; i < size && std::getline(in, text); ++i) {
+    std::istringstream line(text);
+    G4int a = 0, b = 0;
+    line >> a >> b;
+    PairCounts& counts = fPairCounts[{a, b}];
+    line >> counts.weight.sum >> counts.weight.sum2 >> counts.gatedWeight.sum >> counts.gatedWeight.sum2;
+    // 겹침 가중치가 없는 이전 형식: 창 밖에서 함께 트리거된 이벤트가 없다고 봅니다.
+    if (!(line >> counts.overlapWeight.sum >> counts.overlapWeight.sum2)) counts.overlapWeight = counts.weight;
+  }
+  return static_cast<bool>(in);
+}
+
+void Run::CountPhotonKill(PhotonKillRule rule, G4int stepsTaken)
+{
+  ++fPhotonKills[rule];
+  fPhotonKillSteps[rule] += stepsTaken;
+}
+
+G4long Run::GetSingles(G4int pmtID) const
+{
+  return (pmtID >= 0 && pmtID < static_cast<G4int>(fSingles.size())) ? fSingles[pmtID] : 0;
+}
+
+G4long Run::GetGatedSingles(G4int unit) const
+{
+  return (unit >= 0 && unit < static_cast<G4int>(fGatedSingles.size())) ? fGatedSingles[unit] : 0;
+}
+
+Run::WeightSum Run::GetSinglesWeight(G4int pmtID) const
+{
+  return (pmtID >= 0 && pmtID < static_cast<G4int>(fSinglesWeight.size())) ? fSinglesWeight[pmtID] : WeightSum();
+}
+
+Run::WeightSum Run::GetGatedSinglesWeight(G4int unit) const
+{
+  return (unit >= 0 && unit < static_cast<G4int>(fGatedSinglesWeight.size())) ? fGatedSinglesWeight[unit] : WeightSum();
+}
+
+void Run::PrintSummary() const
+{
+  PrintPhotonKills();
+  PrintTrigger();
+  PrintStacking();
+  PrintAngularCorrelation();
+}
+
+void Run::PrintTrigger() const
+{
+  const G4long total = fTriggerAccepted + fTriggerRejected;
+  if (total == 0) return;
+
+  auto oldPrecision = G4cout.precision(3);
+  G4cout << "--> Write trigger: " << fTriggerAccepted << " of " << total << " events written ("
+         << 100. * fTriggerAccepted / total << " %), " << fTriggerRejected << " rejected" << G4endl;
+  G4cout.precision(oldPrecision);
+}
+
+void Run::PrintStacking() const
+{
+  const G4long total = fStackingAccepted + fStackingRejected;
+  if (total == 0) return;
+
+  auto oldPrecision = G4cout.precision(3);
+  G4cout << "--> Deferred optical tracking: " << fStackingAccepted << " of " << total << " events tracked ("
+         << 100. * fStackingAccepted / total << " %), " << fStackingRejected << " skipped" << G4endl;
+  G4cout.precision(oldPrecision);
+}
+
+void Run::PrintPhotonKills() const
+{
+  G4long totalKills = 0;
+  for (auto kills : fPhotonKills) totalKills += kills;
+  if (totalKills == 0) return;
+
+  auto oldPrecision = G4cout.precision(3);
+  G4cout << "--------------------- Optical photon kill rules ---------------------" << G4endl;
+  G4cout << "  tracked optical steps: " << fOpticalSteps << G4endl;
+  for (G4int i = 0; i < kNumPhotonKillRules; ++i) {
+    if (fPhotonKills[i] == 0) continue;
+    G4cout << "  " << std::setw(16) << std::left << kPhotonKillRuleNames[i] << std::right
+           << " killed " << std::setw(12) << fPhotonKills[i] << " photons"
+           << " (mean " << static_cast<G4double>(fPhotonKillSteps[i]) / fPhotonKills[i]
+           << " steps before kill)" << G4endl;
+  }
+  G4cout << "--------------------------------------------------------------------" << G4endl;
+  G4cout.precision(oldPrecision);
+}
+
+/**
+ * @brief 병합된 단일 계수/동시계수로부터 PMT 쌍별 W(θ) 기록을 출력합니다.
+ *
+ * 동시계수율 r = C/N 의 오차는 이항 분포 sqrt(r(1-r)/N) 입니다.
+ * 정규화된 W = C·N/(S_a·S_b) 는 우연/기하 효율을 나눈 값입니다. C는 S_a, S_b의 부분집합이므로
+ * 오차는 세 계수의 공분산(두 PMT가 함께 트리거된 이벤트)을 넣어 전파합니다. (WRelativeVariance)
+ * 가중 이벤트(방향 강제)에서는 계수를 가중치 합으로, 겹치는 이벤트 수를 가중치 제곱합으로 바꾸어 같은 식을 씁니다.
+ * 'W(theta)'로 시작하는 줄은 스캔 후처리에서 grep으로 모을 수 있도록 한 줄에 key=value 형식으로 씁니다.
+ */
+void Run::PrintAngularCorrelation() const
+{
+  const G4int nEvents = GetNumberOfEvent();
+  if (nEvents == 0) return;
+  if (!fCoincidenceEnabled) {
+    G4cout << "--> W(theta) coincidence counting is off (gamma importance biasing)." << G4endl;
+    return;
+  }
+
+  // 쌍별 사잇각은 유닛 배치 각도로부터 구합니다. (두 유닛 모드에서는 이동형 유닛의 각도, 링 모드에서는 모든 쌍)
+  G4double distance = 0.;
+  G4int nUnits = 0;
+  auto detector = static_cast<const DetectorConstruction*>(G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  if (detector) {
+    distance = detector->GetDetectorDistance();
+    nUnits = static_cast<G4int>(detector->GetUnitAngles().size());
+  }
+
+  auto oldPrecision = G4cout.precision(5);
+  G4cout << "------------------- Angular correlation W(theta) -------------------" << G4endl;
+  G4cout << "  " << nUnits << " detector units, distance " << distance / cm << " cm, " << nEvents << " events" << G4endl;
+  G4cout << "  window " << fSettings.window / ns << " ns, threshold " << fSettings.peThreshold << " PE";
+  if (IsGateEnabled()) G4cout << ", energy gate [" << fSettings.gateMin / MeV << ", " << fSettings.gateMax / MeV << "] MeV";
+  G4cout << G4endl;
+  for (size_t pmt = 0; pmt < fSingles.size(); ++pmt) {
+    const WeightSum singles = GetSinglesWeight(static_cast<G4int>(pmt));
+    G4cout << "  singles PMT " << pmt << ": " << fSingles[pmt] << " (" << singles.Rate(nEvents) << " +- "
+           << singles.RateError(nEvents) << " per event)";
+    if (IsGateEnabled()) G4cout << ", energy-gated unit " << pmt << ": " << GetGatedSingles(pmt);
+    G4cout << G4endl;
+  }
+
+  for (const auto& entry : fPairCounts) {
+    const G4int a = entry.first.first;
+    const G4int b = entry.first.second;
+    const PairCounts& counts = entry.second;
+    if (counts.coincidences == 0) continue;  // 창 밖에서만 함께 트리거된 쌍
+    const G4double angle = detector ? detector->GetOpeningAngle(a, b) : 0.;
+
+    const G4long singlesA = GetSingles(a);
+    const G4long singlesB = GetSingles(b);
+    const WeightSum weightA = GetSinglesWeight(a);
+    const WeightSum weightB = GetSinglesWeight(b);
+    G4double w = 0., wError = 0.;
+    if (counts.weight.sum > 0. && weightA.sum > 0. && weightB.sum > 0.) {
+      w = counts.weight.sum * nEvents / (weightA.sum * weightB.sum);
+      wError = w * std::sqrt(WRelativeVariance(counts.weight, weightA, weightB, counts.overlapWeight, nEvents));
+    }
+
+    G4cout << "W(theta) pair=" << a << "-" << b
+           << " angle_deg=" << angle / deg << " distance_cm=" << distance / cm
+           << " events=" << nEvents << " singlesA=" << singlesA << " singlesB=" << singlesB
+           << " coincidences=" << counts.coincidences << " rate=" << counts.weight.Rate(nEvents)
+           << " rateErr=" << counts.weight.RateError(nEvents)
+           << " W=" << w << " WErr=" << wError;
+    if (IsGateEnabled()) {
+      G4cout << " gatedCoincidences=" << counts.gatedCoincidences
+             << " gatedRate=" << counts.gatedWeight.Rate(nEvents) << " gatedRateErr=" << counts.gatedWeight.RateError(nEvents);
+    }
+    G4cout << G4endl;
+  }
+  G4cout << "--------------------------------------------------------------------" << G4endl;
+  G4cout.precision(oldPrecision);
+}
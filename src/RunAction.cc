@@ -1,9 +1,19 @@
 #include "RunAction.hh"
 #include "G4AnalysisManager.hh"
 #include "G4Run.hh"
+#include "G4GenericMessenger.hh"
 
-RunAction::RunAction() : G4UserRunAction()
+#include "OpticalMapManager.hh"
+#include "OutputWriter.hh"
+#include "Run.hh"
+#include "NameDictionary.hh"
+#include "StepProfiler.hh"
+
+RunAction::RunAction(G4bool importanceBiasing)
+: G4UserRunAction(), fImportanceBiasing(importanceBiasing), fAsyncOutput(false), fNtupleMerging(true), fMessenger(nullptr)
 {
+  DefineCommands();
+
   auto analysisManager = G4AnalysisManager::Instance();
   analysisManager->SetVerboseLevel(1);
   analysisManager->SetNtupleMerging(true);
@@ -11,24 +21,35 @@ RunAction::RunAction() : G4UserRunAction()
   // --- Ntuple ID = 0: Hits TTree (에너지 증착 상세 정보) ---
   analysisManager->CreateNtuple("Hits", "Hit-by-hit energy deposition data");
   analysisManager->CreateNtupleIColumn("eventID");
+  analysisManager->CreateNtupleIColumn("detectorID");
   analysisManager->CreateNtupleIColumn("trackID");
   analysisManager->CreateNtupleIColumn("parentID");
-  analysisManager->CreateNtupleSColumn("particleName");
-  analysisManager->CreateNtupleSColumn("processName");
-  analysisManager->CreateNtupleSColumn("volumeName");
+  // 이름 대신 NameDictionary 코드를 저장합니다. (Dictionary TTree에서 이름으로 변환)
+  analysisManager->CreateNtupleIColumn("particleCode");
+  analysisManager->CreateNtupleIColumn("processCode");
+  analysisManager->CreateNtupleIColumn("volumeCode");
   analysisManager->CreateNtupleDColumn("x_mm");
   analysisManager->CreateNtupleDColumn("y_mm");
   analysisManager->CreateNtupleDColumn("z_mm");
   analysisManager->CreateNtupleDColumn("time_ns");
   analysisManager->CreateNtupleDColumn("kineticEnergy_MeV");
   analysisManager->CreateNtupleDColumn("energyDeposit_MeV");
+  analysisManager->CreateNtupleDColumn("weight");             // 트랙 가중치 (중요도 편향)
   analysisManager->FinishNtuple();
 
-  // --- Ntuple ID = 1: EventSummary TTree (LS 입자 수 요약) ---
-  analysisManager->CreateNtuple("EventSummary", "Event-wise summary for LS hits");
+  // --- Ntuple ID = 1: EventSummary TTree (이벤트 x 유닛별 LS 요약, 증착이 있는 유닛만) ---
+  analysisManager->CreateNtuple("EventSummary", "Per-event, per-detector summary for LS hits");
   analysisManager->CreateNtupleIColumn("eventID");
+  analysisManager->CreateNtupleIColumn("detectorID");
   analysisManager->CreateNtupleIColumn("nPrimaries_LS");
   analysisManager->CreateNtupleIColumn("nSecondaries_LS");
+  analysisManager->CreateNtupleDColumn("edep_MeV");
+  analysisManager->CreateNtupleDColumn("visibleEnergy_MeV");  // Birks 보정
+  analysisManager->CreateNtupleDColumn("centroidX_mm");        // 에너지 가중 중심 (전역 좌표)
+  analysisManager->CreateNtupleDColumn("centroidY_mm");
+  analysisManager->CreateNtupleDColumn("centroidZ_mm");
+  analysisManager->CreateNtupleDColumn("firstTime_ns");
+  analysisManager->CreateNtupleDColumn("weight");             // 통계적 가중치 (방향 강제/중요도 편향, 없으면 1)
   analysisManager->FinishNtuple();
 
   // --- Ntuple ID = 2: PMTHits TTree (개별 광자 검출 정보) ---
@@ -36,21 +57,134 @@ RunAction::RunAction() : G4UserRunAction()
   analysisManager->CreateNtupleIColumn("eventID");
   analysisManager->CreateNtupleIColumn("pmtID");
   analysisManager->CreateNtupleDColumn("time_ns");
+  analysisManager->CreateNtupleDColumn("weight");
+  analysisManager->FinishNtuple();
+
+  // --- Ntuple ID = 3: Dictionary TTree (이름 코드 -> 이름, 파일당 한 번 Master가 기록) ---
+  analysisManager->CreateNtuple("Dictionary", "Name codes used in the Hits tree");
+  analysisManager->CreateNtupleIColumn("code");
+  analysisManager->CreateNtupleSColumn("name");
+  analysisManager->FinishNtuple();
+
+  // --- Ntuple ID = 4: PMTSummary TTree (이벤트 x PMT별 광전자 요약, /myApp/output/pmtOutput) ---
+  analysisManager->CreateNtuple("PMTSummary", "Per-event, per-PMT photoelectron summary");
+  analysisManager->CreateNtupleIColumn("eventID");
+  analysisManager->CreateNtupleIColumn("pmtID");
+  analysisManager->CreateNtupleIColumn("nPE");
+  analysisManager->CreateNtupleDColumn("weightedPE");   // 가중치 합 (솎아내기/편향이 없으면 nPE와 같음)
+  analysisManager->CreateNtupleDColumn("firstTime_ns");
+  analysisManager->CreateNtupleDColumn("medianTime_ns");
+  analysisManager->CreateNtupleDColumn("lastTime_ns");
+  // 첫 광전자 기준 고정 폭 히스토그램 (가중치 합, 히스토그램을 끄면 빈 벡터)
+  analysisManager->CreateNtupleDColumn("timeHist", fPMTTimeHistogram);
   analysisManager->FinishNtuple();
 }
 
-RunAction::~RunAction() {}
+RunAction::~RunAction()
+{
+  delete fMessenger;
+}
+
+void RunAction::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/myApp/coincidence/", "Online coincidence counting for W(theta).");
+
+  auto& windowCmd = fMessenger->DeclarePropertyWithUnit("window", "ns", fCoincidence.window,
+                                                        "Maximum difference of the PMT trigger times in a coincidence.");
+  windowCmd.SetParameterName("Window", false);
+  windowCmd.SetRange("Window>0.");
+  windowCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+  auto& thresholdCmd = fMessenger->DeclareProperty("peThreshold", fCoincidence.peThreshold,
+                                                   "Weighted photoelectron count at which a PMT triggers.");
+  thresholdCmd.SetParameterName("NPE", false);
+  thresholdCmd.SetRange("NPE>0.");
+  thresholdCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+  auto& gateMinCmd = fMessenger->DeclarePropertyWithUnit("gateMin", "MeV", fCoincidence.gateMin,
+                                                         "Lower edge of the visible-energy gate (gate is off while gateMax <= gateMin).");
+  gateMinCmd.SetParameterName("EMin", false);
+  gateMinCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+  auto& gateMaxCmd = fMessenger->DeclarePropertyWithUnit("gateMax", "MeV", fCoincidence.gateMax,
+                                                         "Upper edge of the visible-energy gate applied to both units of a pair.");
+  gateMaxCmd.SetParameterName("EMax", false);
+  gateMaxCmd.SetStates(G4State_PreInit, G4State_Idle);
+}
+
+/**
+ * @brief 런 단위 카운터를 누적할 사용자 정의 Run 객체를 생성합니다.
+ * Master와 각 Worker 스레드에서 각각 호출되며, Worker의 Run은 런 종료 시 Master로 병합됩니다.
+ */
+G4Run* RunAction::GenerateRun()
+{
+  return new Run(fCoincidence, !fImportanceBiasing);
+}
 
 void RunAction::BeginOfRunAction(const G4Run* run)
 {
-  auto analysisManager = G4AnalysisManager::Instance();
-  analysisManager->OpenFile("output.root");
+  // 비동기 출력: Master가 쓰기 스레드를 시작하고, G4 Ntuple 파일은 열지 않습니다.
+  fAsyncOutput = OutputWriter::Instance()->IsEnabled();
+  if (fAsyncOutput) {
+    if (IsMaster()) OutputWriter::Instance()->Start(OutputWriter::Instance()->GetFileName());
+  }
+  else {
+    auto analysisManager = G4AnalysisManager::Instance();
+    // 스레드별 파일: Worker는 <이름>_t<번호>.root에, Master는 <이름>.root(Dictionary)에 기록합니다.
+    // G4는 병합 방식을 첫 파일을 열 때 정하므로, 이 설정은 첫 /run/beamOn 전에 해야 합니다.
+    G4bool merging = !OutputWriter::Instance()->IsPerThreadFiles();
+    if (merging != fNtupleMerging) {
+      analysisManager->SetNtupleMerging(merging);
+      fNtupleMerging = merging;
+    }
+    analysisManager->OpenFile(OutputWriter::Instance()->GetFileName() + ".root");
+  }
   G4cout << "### Run " << run->GetRunID() << " start." << G4endl;
+
+  // 중요도 편향의 분할 사본은 한 이벤트 안에서 트랙 가중치로만 보정되므로, 이벤트 단위 양은 편향됩니다.
+  if (IsMaster() && fImportanceBiasing) {
+    G4Exception("RunAction::BeginOfRunAction()", "Run_ImportanceBiasing", JustWarning,
+                "감마 중요도 편향이 켜져 있어 W(θ) 동시계수 누적과 기록 트리거(/myApp/trigger/)를 끄고, "
+                "EventSummary의 edep_MeV/visibleEnergy_MeV를 -1로 기록합니다. 에너지 증착은 Hits의 energyDeposit_MeV × weight로 구하십시오.");
+  }
+
+  // 이름 코드가 독립 프로세스(shard) 사이에서도 같도록, Worker가 이벤트를 처리하기 전에 알려진 이름을 정렬 순서로 등록합니다.
+  if (IsMaster()) NameDictionary::Instance()->RegisterKnownNames();
+
+  // 광학 룩업 맵: Master는 맵을 읽거나(fast) 초기화하고(build), Worker는 스레드별 맵을 준비합니다.
+  OpticalMapManager::Instance()->BeginOfRun(IsMaster());
 }
 
-void RunAction::EndOfRunAction(const G4Run* /*run*/)
+void RunAction::EndOfRunAction(const G4Run* run)
 {
-  auto analysisManager = G4AnalysisManager::Instance();
-  analysisManager->Write();
-  analysisManager->CloseFile();
+  if (fAsyncOutput) {
+    // 모든 Worker가 끝난 뒤이므로, 남은 레코드를 기록하고 사전과 함께 파일을 닫습니다.
+    if (IsMaster()) OutputWriter::Instance()->Stop();
+  }
+  else {
+    auto analysisManager = G4AnalysisManager::Instance();
+
+    // 모든 Worker가 끝난 뒤이므로 사전에 이번 런의 모든 이름이 등록되어 있습니다.
+    if (IsMaster()) {
+      auto names = NameDictionary::Instance()->GetNames();
+      for (size_t code = 0; code < names.size(); ++code) {
+        analysisManager->FillNtupleIColumn(3, 0, static_cast<G4int>(code));
+        analysisManager->FillNtupleSColumn(3, 1, names[code]);
+        analysisManager->AddNtupleRow(3);
+      }
+    }
+
+    analysisManager->Write();
+    analysisManager->CloseFile();
+  }
+
+  // build 모드: Worker는 스레드별 맵을 병합하고, Master는 병합된 맵을 파일로 저장합니다.
+  OpticalMapManager::Instance()->EndOfRun(IsMaster());
+
+  // 병합된 런 요약 (광자 제거 규칙별 카운터, W(θ) 동시계수 등)은 Master에서 한 번만 출력합니다.
+  if (IsMaster()) {
+    auto localRun = static_cast<const Run*>(run);
+    localRun->PrintSummary();
+    StepProfiler::Instance()->Report(localRun->GetProfile(), run->GetRunID());
+  }
 }
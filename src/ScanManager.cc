@@ -0,0 +1,247 @@
+#include "ScanManager.hh"
+#include "AdaptiveManager.hh"
+#include "OutputWriter.hh"
+#include "Run.hh"
+#include "SplitMix64.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4RunManager.hh"
+#include "G4UImanager.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+  // 공백으로 구분된 숫자 목록을 읽습니다. 숫자가 아닌 토큰이 있으면 false.
+  G4bool ParseValues(const G4String& text, std::vector<G4double>& values)
+  {
+    std::istringstream stream(text);
+    G4double value = 0.;
+    values.clear();
+    while (stream >> value) values.push_back(value);
+    return stream.eof() && !values.empty();
+  }
+}
+
+ScanManager* ScanManager::fgInstance = nullptr;
+
+ScanManager* ScanManager::Instance()
+{
+  if (!fgInstance) fgInstance = new ScanManager();
+  return fgInstance;
+}
+
+ScanManager::ScanManager()
+: fEvents(100000), fBaseSeed(12345), fOutputPrefix("scan"), fManifestFile("scan_manifest.tsv"),
+  fMessenger(nullptr)
+{
+  DefineCommands();
+}
+
+ScanManager::~ScanManager()
+{
+  delete fMessenger;
+}
+
+void ScanManager::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/myApp/scan/", "In-process scan over (distance, angle) points.");
+
+  // 스캔은 Master에서만 실행되므로 모든 명령어를 Worker로 전파하지 않습니다.
+  auto& pointCmd = fMessenger->DeclareMethod("addPoint", &ScanManager::AddPoint,
+                                             "Add one scan point: <distance in cm> <angle in deg>.");
+  pointCmd.SetParameterName("Point", false);
+  pointCmd.SetStates(G4State_PreInit, G4State_Idle);
+  pointCmd.SetToBeBroadcasted(false);
+
+  auto& distCmd = fMessenger->DeclareMethod("distances", &ScanManager::SetDistances,
+                                            "Grid distances in cm (space separated); the grid is distances x angles.");
+  distCmd.SetParameterName("Distances", false);
+  distCmd.SetStates(G4State_PreInit, G4State_Idle);
+  distCmd.SetToBeBroadcasted(false);
+
+  auto& angleCmd = fMessenger->DeclareMethod("angles", &ScanManager::SetAngles,
+                                             "Grid angles in deg (space separated); the grid is distances x angles.");
+  angleCmd.SetParameterName("Angles", false);
+  angleCmd.SetStates(G4State_PreInit, G4State_Idle);
+  angleCmd.SetToBeBroadcasted(false);
+
+  auto& clearCmd = fMessenger->DeclareMethod("clear", &ScanManager::Clear, "Remove all scan points and grid values.");
+  clearCmd.SetToBeBroadcasted(false);
+
+  auto& eventsCmd = fMessenger->DeclareProperty("events", fEvents, "Number of events per scan point.");
+  eventsCmd.SetParameterName("NEvents", false);
+  eventsCmd.SetRange("NEvents>0");
+  eventsCmd.SetToBeBroadcasted(false);
+
+  auto& seedCmd = fMessenger->DeclareProperty("seed", fBaseSeed, "Base seed; each point gets a seed derived from it and its index.");
+  seedCmd.SetParameterName("Seed", false);
+  seedCmd.SetToBeBroadcasted(false);
+
+  auto& prefixCmd = fMessenger->DeclareProperty("outputPrefix", fOutputPrefix,
+                                                "Output file prefix; point files are <prefix>_d<cm>_a<deg>.");
+  prefixCmd.SetParameterName("Prefix", false);
+  prefixCmd.SetToBeBroadcasted(false);
+
+  auto& manifestCmd = fMessenger->DeclareProperty("manifest", fManifestFile, "Tab-separated manifest with per-point timing and results.");
+  manifestCmd.SetParameterName("FileName", false);
+  manifestCmd.SetToBeBroadcasted(false);
+
+  auto& runCmd = fMessenger->DeclareMethod("run", &ScanManager::RunScan, "Run all scan points in this process.");
+  runCmd.SetStates(G4State_Idle);
+  runCmd.SetToBeBroadcasted(false);
+}
+
+void ScanManager::AddPoint(const G4String& values)
+{
+  std::vector<G4double> parsed;
+  if (!ParseValues(values, parsed) || parsed.size() != 2) {
+    G4Exception("ScanManager::AddPoint()", "Scan_BadPoint", JustWarning,
+                ("스캔 점은 '<거리 cm> <각도 deg>' 형식이어야 합니다: " + values).c_str());
+    return;
+  }
+  fPoints.push_back({parsed[0] * cm, parsed[1] * deg});
+}
+
+void ScanManager::SetDistances(const G4String& values)
+{
+  std::vector<G4double> parsed;
+  if (!ParseValues(values, parsed)) {
+    G4Exception("ScanManager::SetDistances()", "Scan_BadList", JustWarning, ("거리 목록을 읽을 수 없습니다: " + values).c_str());
+    return;
+  }
+  fDistances.clear();
+  for (auto value : parsed) fDistances.push_back(value * cm);
+}
+
+void ScanManager::SetAngles(const G4String& values)
+{
+  std::vector<G4double> parsed;
+  if (!ParseValues(values, parsed)) {
+    G4Exception("ScanManager::SetAngles()", "Scan_BadList", JustWarning, ("각도 목록을 읽을 수 없습니다: " + values).c_str());
+    return;
+  }
+  fAngles.clear();
+  for (auto value : parsed) fAngles.push_back(value * deg);
+}
+
+void ScanManager::Clear()
+{
+  fPoints.clear();
+  fDistances.clear();
+  fAngles.clear();
+}
+
+std::vector<ScanManager::ScanPoint> ScanManager::GetPoints() const
+{
+  std::vector<ScanPoint> points = fPoints;
+  for (auto distance : fDistances) {
+    for (auto angle : fAngles) points.push_back({distance, angle});
+  }
+  return points;
+}
+
+long ScanManager::PointSeed(size_t index) const
+{
+  std::uint64_t value = SplitMix64(static_cast<std::uint64_t>(fBaseSeed) ^ SplitMix64(index));
+  // CLHEP 시드는 양의 long으로 제한합니다.
+  return static_cast<long>(value & 0x7fffffffULL);
+}
+
+/**
+ * @brief 모든 스캔 점을 차례로 실행합니다.
+ * @details 점마다 검출기를 옮기고(UI 명령어, 지오메트리는 제자리 갱신), 출력 파일 이름과 시드를 정한 뒤 BeamOn을 호출합니다.
+ *          manifest는 점이 끝날 때마다 한 줄씩 기록하고 flush하므로, 스캔이 중간에 멈춰도 끝난 점의 결과는 남습니다.
+ */
+void ScanManager::RunScan()
+{
+  const std::vector<ScanPoint> points = GetPoints();
+  if (points.empty()) {
+    G4Exception("ScanManager::RunScan()", "Scan_NoPoints", JustWarning, "스캔 점이 없습니다. (/myApp/scan/addPoint 또는 distances/angles)");
+    return;
+  }
+
+  std::ofstream manifest(fManifestFile);
+  if (!manifest) {
+    G4Exception("ScanManager::RunScan()", "Scan_FileError", FatalException, ("manifest 파일을 열 수 없습니다: " + fManifestFile).c_str());
+    return;
+  }
+  manifest << "index\tdistance_cm\tangle_deg\tevents\tseed\toutput\twall_s\tevents_per_s\tcoincidences\trate\trate_err\tbatches\trel_err\n";
+
+  auto runManager = G4RunManager::GetRunManager();
+  auto uiManager = G4UImanager::GetUIpointer();
+  auto writer = OutputWriter::Instance();
+  auto adaptive = AdaptiveManager::Instance();
+  const G4String savedFileName = writer->GetFileName();
+
+  const auto scanStart = std::chrono::steady_clock::now();
+  for (size_t index = 0; index < points.size(); ++index) {
+    const ScanPoint& point = points[index];
+
+    std::ostringstream command;
+    command << "/myApp/detector/setDistance " << point.distance / cm << " cm";
+    uiManager->ApplyCommand(command.str());
+    command.str("");
+    command << "/myApp/detector/setMovableAngle " << point.angle / deg << " deg";
+    uiManager->ApplyCommand(command.str());
+
+    std::ostringstream fileName;
+    fileName << fOutputPrefix << "_d" << point.distance / cm << "_a" << point.angle / deg;
+    writer->SetFileName(fileName.str());
+
+    // Master 엔진의 시드를 정하면 MT RunManager가 이번 런의 Worker 시드를 이 엔진에서 뽑습니다.
+    const long seed = PointSeed(index);
+    G4Random::setTheSeed(seed);
+
+    G4cout << "=== Scan point " << index + 1 << "/" << points.size() << ": distance " << point.distance / cm
+           << " cm, angle " << point.angle / deg << " deg, seed " << seed << " ===" << G4endl;
+
+    const auto start = std::chrono::steady_clock::now();
+    G4long coincidences = 0;
+    Run::WeightSum coincidenceWeight;
+    G4int nEvents = fEvents;
+    G4int batches = 1;
+    G4String output = fileName.str() + writer->GetFileExtension();
+    if (adaptive->IsEnabled()) {
+      // 점마다 목표 상대 오차까지 묶음으로 실행합니다. 출력은 <이름>_part<k> 파일들입니다.
+      const AdaptiveManager::Result result = adaptive->RunPoint(fileName.str());
+      nEvents = result.events;
+      coincidences = result.coincidences;
+      coincidenceWeight.sum = result.coincidenceWeight;
+      coincidenceWeight.sum2 = result.coincidenceWeight2;
+      batches = result.batches;
+      output = fileName.str() + "_part*" + writer->GetFileExtension();
+    } else {
+      runManager->BeamOn(fEvents);
+      // 병합된 Master Run은 다음 BeamOn 전까지 유효합니다.
+      if (auto run = static_cast<const Run*>(runManager->GetCurrentRun())) {
+        nEvents = run->GetNumberOfEvent();
+        for (const auto& entry : run->GetPairCounts()) {
+          coincidences += entry.second.coincidences;
+          coincidenceWeight.Add(entry.second.weight);
+        }
+      }
+    }
+    const G4double seconds = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - start).count();
+
+    // 방향 강제 생성기를 쓰면 동시계수율은 이벤트 가중치 합으로 계산합니다. (가중치 1이면 C/N과 이항 오차)
+    const G4double rate = coincidenceWeight.Rate(nEvents);
+    const G4double rateError = coincidenceWeight.RateError(nEvents);
+
+    manifest << index << '\t' << point.distance / cm << '\t' << point.angle / deg << '\t' << nEvents << '\t'
+             << seed << '\t' << output << '\t'
+             << std::setprecision(6) << seconds << '\t' << (seconds > 0. ? nEvents / seconds : 0.) << '\t'
+             << coincidences << '\t' << rate << '\t' << rateError << '\t'
+             << batches << '\t' << (rate > 0. ? rateError / rate : 0.) << std::endl;
+  }
+  writer->SetFileName(savedFileName);
+
+  const G4double total = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - scanStart).count();
+  G4cout << "=== Scan finished: " << points.size() << " points in " << total << " s, manifest " << fManifestFile << " ===" << G4endl;
+}
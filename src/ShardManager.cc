@@ -0,0 +1,173 @@
+#include "ShardManager.hh"
+#include "DetectorConstruction.hh"
+#include "OutputWriter.hh"
+#include "Run.hh"
+#include "SplitMix64.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4RunManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+ShardManager* ShardManager::fgInstance = nullptr;
+
+ShardManager* ShardManager::Instance()
+{
+  if (!fgInstance) fgInstance = new ShardManager();
+  return fgInstance;
+}
+
+ShardManager::ShardManager()
+: fRunSeed(12345), fTotalEvents(1000000), fShardIndex(0), fShardCount(1), fPerEventSeeding(false),
+  fMessenger(nullptr)
+{
+  DefineCommands();
+}
+
+ShardManager::~ShardManager()
+{
+  delete fMessenger;
+}
+
+void ShardManager::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/myApp/shard/", "Deterministic sharded runs over independent processes.");
+
+  // shard 실행은 Master에서만 이루어지므로 모든 명령어를 Worker로 전파하지 않습니다.
+  auto& seedCmd = fMessenger->DeclareProperty("runSeed", fRunSeed,
+                                              "Run seed shared by all shards; event seeds derive from (run seed, global event ID).");
+  seedCmd.SetParameterName("Seed", false);
+  seedCmd.SetToBeBroadcasted(false);
+
+  auto& eventsCmd = fMessenger->DeclareProperty("events", fTotalEvents, "Total number of events of the logical run (all shards).");
+  eventsCmd.SetParameterName("NEvents", false);
+  eventsCmd.SetRange("NEvents>0");
+  eventsCmd.SetToBeBroadcasted(false);
+
+  auto& indexCmd = fMessenger->DeclareProperty("index", fShardIndex, "Index of this shard (0 ... count-1).");
+  indexCmd.SetParameterName("Index", false);
+  indexCmd.SetRange("Index>=0");
+  indexCmd.SetToBeBroadcasted(false);
+
+  auto& countCmd = fMessenger->DeclareProperty("count", fShardCount, "Number of shards the run is split into.");
+  countCmd.SetParameterName("Count", false);
+  countCmd.SetRange("Count>=1");
+  countCmd.SetToBeBroadcasted(false);
+
+  auto& runCmd = fMessenger->DeclareMethod("run", &ShardManager::RunShard,
+                                           "Process the global events of this shard; writes <file>_shard<i>of<K> and a .counters file.");
+  runCmd.SetStates(G4State_Idle);
+  runCmd.SetToBeBroadcasted(false);
+
+  auto& replayCmd = fMessenger->DeclareMethod("replayEvent", &ShardManager::ReplayEvent,
+                                              "Reproduce one global event of the run (same run seed) into <file>_event<ID>.");
+  replayCmd.SetParameterName("EventID", false);
+  replayCmd.SetRange("EventID>=0");
+  replayCmd.SetStates(G4State_Idle);
+  replayCmd.SetToBeBroadcasted(false);
+}
+
+void ShardManager::SeedEvent(G4long globalEventID) const
+{
+  const std::uint64_t mixed = SplitMix64(static_cast<std::uint64_t>(fRunSeed) ^ SplitMix64(globalEventID));
+  // CLHEP 시드는 양의 long으로 제한하고, 0으로 끝나는 배열로 넘깁니다.
+  long seeds[3] = {static_cast<long>(mixed & 0x7fffffffULL),
+                   static_cast<long>((mixed >> 32) & 0x7fffffffULL), 0};
+  G4Random::setTheSeeds(seeds);
+}
+
+/**
+ * @brief 이 shard의 전역 이벤트 구간을 한 번의 BeamOn으로 처리합니다.
+ * 구간 경계는 정수 나눗셈으로 정하므로, 모든 shard의 구간을 합치면 빠짐이나 겹침 없이 [0, N)이 됩니다.
+ */
+void ShardManager::RunShard()
+{
+  if (fShardIndex >= fShardCount || fTotalEvents < fShardCount) {
+    G4Exception("ShardManager::RunShard()", "Shard_BadConfig", JustWarning,
+                "shard 설정이 잘못되었습니다. (index < count <= events 이어야 합니다)");
+    return;
+  }
+
+  const G4long first = fTotalEvents * fShardIndex / fShardCount;
+  const G4long last = fTotalEvents * (fShardIndex + 1) / fShardCount;
+
+  // 이름순 정렬이 shard 순서가 되도록 번호를 count의 자릿수만큼 0으로 채웁니다.
+  const G4int width = static_cast<G4int>(std::to_string(fShardCount - 1).size());
+  auto writer = OutputWriter::Instance();
+  const G4String savedFileName = writer->GetFileName();
+  std::ostringstream fileName;
+  fileName << savedFileName << "_shard" << std::setw(width) << std::setfill('0') << fShardIndex
+           << "of" << fShardCount;
+
+  G4cout << "=== Shard " << fShardIndex << "/" << fShardCount << ": global events " << first << " - " << last - 1
+         << " of " << fTotalEvents << ", run seed " << fRunSeed << " ===" << G4endl;
+
+  writer->SetFileName(fileName.str());
+  writer->SetEventIDOffset(static_cast<G4int>(first));
+  fPerEventSeeding = true;
+  G4RunManager::GetRunManager()->BeamOn(static_cast<G4int>(last - first));
+  fPerEventSeeding = false;
+  writer->SetEventIDOffset(0);
+  writer->SetFileName(savedFileName);
+
+  const G4String output = fileName.str() + writer->GetFileExtension();
+  if (!WriteCounters(fileName.str() + ".counters", output, first)) {
+    G4Exception("ShardManager::RunShard()", "Shard_FileError", JustWarning,
+                ("shard 카운터 파일을 쓸 수 없습니다: " + fileName.str() + ".counters").c_str());
+  }
+}
+
+void ShardManager::ReplayEvent(G4int globalEventID)
+{
+  auto writer = OutputWriter::Instance();
+  const G4String savedFileName = writer->GetFileName();
+  writer->SetFileName(savedFileName + "_event" + std::to_string(globalEventID));
+  writer->SetEventIDOffset(globalEventID);
+
+  G4cout << "=== Replaying global event " << globalEventID << " (run seed " << fRunSeed << ") ===" << G4endl;
+  fPerEventSeeding = true;
+  G4RunManager::GetRunManager()->BeamOn(1);
+  fPerEventSeeding = false;
+
+  writer->SetEventIDOffset(0);
+  writer->SetFileName(savedFileName);
+}
+
+/**
+ * @brief shard 정보, 검출기 배치, 병합된 Run 카운터를 기록합니다. cpnr_merge가 이 파일들을 읽어 합칩니다.
+ */
+G4bool ShardManager::WriteCounters(const G4String& fileName, const G4String& output, G4long firstEvent) const
+{
+  auto runManager = G4RunManager::GetRunManager();
+  auto run = static_cast<const Run*>(runManager->GetCurrentRun());
+  if (!run) return false;
+
+  std::ofstream out(fileName);
+  if (!out) return false;
+
+  out << "# CPNR shard counters (merge with: cpnr_merge -o merged.root *.counters)\n";
+  out << "runSeed " << fRunSeed << "\n";
+  out << "totalEvents " << fTotalEvents << "\n";
+  out << "shardIndex " << fShardIndex << "\n";
+  out << "shardCount " << fShardCount << "\n";
+  out << "firstEvent " << firstEvent << "\n";
+  out << "output " << output << "\n";
+
+  auto detector = static_cast<const DetectorConstruction*>(runManager->GetUserDetectorConstruction());
+  const std::vector<G4double> angles = detector ? detector->GetUnitAngles() : std::vector<G4double>();
+  out << std::setprecision(10);
+  out << "distance_cm " << (detector ? detector->GetDetectorDistance() / cm : 0.) << "\n";
+  out << "unitAngles_deg " << angles.size();
+  for (auto angle : angles) out << " " << angle / deg;
+  out << "\n";
+
+  run->WriteCounters(out);
+  return static_cast<bool>(out);
+}
@@ -0,0 +1,102 @@
+#include "StackingAction.hh"
+#include "LSSD.hh"
+#include "OpticalMapManager.hh"
+#include "Run.hh"
+
+#include "G4Track.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4StackManager.hh"
+#include "G4SDManager.hh"
+#include "G4GenericMessenger.hh"
+#include "G4RunManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ios.hh"
+#include "Randomize.hh"
+
+StackingAction::StackingAction()
+: G4UserStackingAction(),
+  fEnabled(false), fMinUnits(2), fEdepThreshold(0.),
+  fStage(0),
+  fLSSD(nullptr), fMessenger(nullptr)
+{
+  DefineCommands();
+}
+
+StackingAction::~StackingAction()
+{
+  delete fMessenger;
+}
+
+void StackingAction::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/myApp/stacking/", "Two-stage optical photon stacking control.");
+
+  auto& enableCmd = fMessenger->DeclareProperty("setDelayOptical", fEnabled,
+                                                "Delay optical photons until the LS deposits of the event pass the condition.");
+  enableCmd.SetParameterName("Flag", false);
+  enableCmd.SetStates(G4State_Idle);
+
+  auto& unitsCmd = fMessenger->DeclareProperty("setMinUnits", fMinUnits,
+                                               "Minimum number of LS units with a deposit above threshold (2 = coincidence).");
+  unitsCmd.SetParameterName("NUnits", false);
+  unitsCmd.SetRange("NUnits>=0");
+  unitsCmd.SetStates(G4State_Idle);
+
+  auto& thrCmd = fMessenger->DeclarePropertyWithUnit("setEdepThreshold", "keV", fEdepThreshold,
+                                                     "Per-unit LS energy deposit threshold.");
+  thrCmd.SetParameterName("Energy", false);
+  thrCmd.SetStates(G4State_Idle);
+}
+
+void StackingAction::PrepareNewEvent()
+{
+  fStage = 0;
+}
+
+/**
+ * @brief 새 트랙의 스택을 결정합니다.
+ * fast 모드에서는 PMT Hit을 맵에서 샘플링하므로 광학 광자를 모두 버립니다. (실제 광자와 맵 Hit의 이중 계수 방지)
+ * 그 밖의 광학 광자는 생성 시점(1단계)에 솎아내기를 적용하고, 2단계 스태킹이 켜져 있으면 대기 스택으로 보냅니다.
+ * 나머지 입자와 재분류(2단계)되는 광자는 즉시 추적합니다.
+ */
+G4ClassificationOfNewTrack StackingAction::ClassifyNewTrack(const G4Track* track)
+{
+  if (fStage > 0 || track->GetDefinition() != G4OpticalPhoton::Definition()) return fUrgent;
+
+  auto mapManager = OpticalMapManager::Instance();
+  if (mapManager->IsFastMode()) return fKill;
+
+  // 솎아내기: 확률 f로만 남기고, 남은 광자에는 가중치 1/f를 곱합니다. (부모 입자의 가중치는 유지)
+  if (mapManager->IsThinningEnabled()) {
+    G4double fraction = mapManager->GetThinningFraction();
+    if (G4UniformRand() > fraction) return fKill;
+    const_cast<G4Track*>(track)->SetWeight(track->GetWeight() / fraction);
+  }
+
+  return fEnabled ? fWaiting : fUrgent;
+}
+
+/**
+ * @brief 긴급 스택(urgent stack)이 비면 호출됩니다.
+ * 1단계가 끝난 시점이므로, 이 이벤트의 모든 에너지 증착이 LSSD에 누적되어 있습니다.
+ */
+void StackingAction::NewStage()
+{
+  if (!fEnabled || fStage > 0) return;
+  fStage = 1;
+
+  if (!fLSSD) {
+    fLSSD = static_cast<LSSD*>(G4SDManager::GetSDMpointer()->FindSensitiveDetector("LSSD", false));
+  }
+
+  G4bool accept = fLSSD && fLSSD->GetNumberOfUnitsAbove(fEdepThreshold) >= fMinUnits;
+  // 판정 결과는 Run 요약에 보고합니다. (Worker의 Run이 Master로 병합)
+  auto run = static_cast<Run*>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+  if (run) run->CountStacking(accept);
+  if (accept) {
+    stackManager->ReClassify(); // 대기 중인 광자를 ClassifyNewTrack으로 다시 분류 -> fUrgent
+  }
+  else {
+    stackManager->clear();      // 대기 중인 광자를 모두 버립니다.
+  }
+}
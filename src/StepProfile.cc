@@ -0,0 +1,59 @@
+#include "StepProfile.hh"
+
+#include "G4LogicalVolume.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4VProcess.hh"
+
+StepProfile::Counts& StepProfile::Find(const Key& key)
+{
+  if (fLastCounts && key == fLastKey) return *fLastCounts;
+  fLastKey = key;
+  fLastCounts = &fCounts[key];
+  return *fLastCounts;
+}
+
+StepProfile::Counts& StepProfile::CountStep(const G4LogicalVolume* volume, const G4ParticleDefinition* particle,
+                                            const G4VProcess* process)
+{
+  Counts& counts = Find({volume, particle, process});
+  ++counts.steps;
+  return counts;
+}
+
+void StepProfile::CountTrack(const G4LogicalVolume* volume, const G4ParticleDefinition* particle,
+                             const G4VProcess* creator)
+{
+  ++Find({volume, particle, creator}).tracks;
+}
+
+/**
+ * @brief 포인터 키를 이름 키로 바꿉니다. Worker가 끝나기 전(Merge 시점)에만 호출하므로 프로세스 객체가 살아 있습니다.
+ * 프로세스가 없는 키는 생성 프로세스가 없는 1차 입자의 트랙뿐이므로 "primary"로 씁니다.
+ */
+StepProfile::NameKey StepProfile::ToNames(const Key& key)
+{
+  return NameKey(key.volume ? key.volume->GetName() : G4String("none"),
+                 key.particle ? key.particle->GetParticleName() : G4String("none"),
+                 key.process ? key.process->GetProcessName() : G4String("primary"));
+}
+
+void StepProfile::Add(Counts& sum, const Counts& counts)
+{
+  sum.steps += counts.steps;
+  sum.tracks += counts.tracks;
+  sum.timedSteps += counts.timedSteps;
+  sum.seconds += counts.seconds;
+}
+
+void StepProfile::Merge(const StepProfile& other)
+{
+  for (const auto& entry : other.fCounts) Add(fMerged[ToNames(entry.first)], entry.second);
+  for (const auto& entry : other.fMerged) Add(fMerged[entry.first], entry.second);
+}
+
+std::map<StepProfile::NameKey, StepProfile::Counts> StepProfile::GetTable() const
+{
+  std::map<NameKey, Counts> table = fMerged;
+  for (const auto& entry : fCounts) Add(table[ToNames(entry.first)], entry.second);
+  return table;
+}
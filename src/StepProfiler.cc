@@ -0,0 +1,126 @@
+#include "StepProfiler.hh"
+#include "StepProfile.hh"
+
+#include "G4GenericMessenger.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+
+StepProfiler* StepProfiler::fgInstance = nullptr;
+
+StepProfiler* StepProfiler::Instance()
+{
+  if (!fgInstance) fgInstance = new StepProfiler();
+  return fgInstance;
+}
+
+StepProfiler::StepProfiler()
+: fEnabled(false), fSamplePeriod(100), fTopRows(30), fFileName("step_profile.tsv"), fFileStarted(false),
+  fMessenger(nullptr)
+{
+  DefineCommands();
+}
+
+StepProfiler::~StepProfiler()
+{
+  delete fMessenger;
+}
+
+void StepProfiler::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/myApp/profile/", "Per-volume, per-particle, per-process step profiling.");
+
+  // 설정은 Master에만 두고 Worker가 읽으므로 모든 명령어를 Worker로 전파하지 않습니다.
+  auto& enableCmd = fMessenger->DeclareProperty("enable", fEnabled,
+                                                "Count steps, tracks and sampled time by logical volume x particle x process.");
+  enableCmd.SetParameterName("Flag", false);
+  enableCmd.SetStates(G4State_PreInit, G4State_Idle);
+  enableCmd.SetToBeBroadcasted(false);
+
+  auto& periodCmd = fMessenger->DeclareProperty("samplePeriod", fSamplePeriod,
+                                                "Time one step in every N steps (0 = count only, no clock reads).");
+  periodCmd.SetParameterName("N", false);
+  periodCmd.SetRange("N>=0");
+  periodCmd.SetStates(G4State_PreInit, G4State_Idle);
+  periodCmd.SetToBeBroadcasted(false);
+
+  auto& topCmd = fMessenger->DeclareProperty("topRows", fTopRows, "Number of rows printed in the run summary.");
+  topCmd.SetParameterName("N", false);
+  topCmd.SetRange("N>=0");
+  topCmd.SetStates(G4State_PreInit, G4State_Idle);
+  topCmd.SetToBeBroadcasted(false);
+
+  auto& fileCmd = fMessenger->DeclareProperty("file", fFileName,
+                                              "Tab-separated output file with all rows of every run ('none' = do not write).");
+  fileCmd.SetParameterName("FileName", false);
+  fileCmd.SetStates(G4State_PreInit, G4State_Idle);
+  fileCmd.SetToBeBroadcasted(false);
+}
+
+/**
+ * @brief 병합된 프로파일을 추정 CPU 시간(시간 측정이 없으면 스텝 수) 순으로 출력하고 파일에 씁니다.
+ * 비율은 모든 항목의 합에 대한 값이며, ns/step은 표본 스텝의 평균 CPU 시간입니다.
+ */
+void StepProfiler::Report(const StepProfile& profile, G4int runID)
+{
+  if (!fEnabled || profile.IsEmpty()) return;
+
+  const auto table = profile.GetTable();
+  std::vector<std::pair<StepProfile::NameKey, StepProfile::Counts>> rows(table.begin(), table.end());
+  std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+    if (a.second.seconds != b.second.seconds) return a.second.seconds > b.second.seconds;
+    if (a.second.steps != b.second.steps) return a.second.steps > b.second.steps;
+    return a.first < b.first;
+  });
+
+  StepProfile::Counts total;
+  for (const auto& row : rows) {
+    total.steps += row.second.steps;
+    total.tracks += row.second.tracks;
+    total.timedSteps += row.second.timedSteps;
+    total.seconds += row.second.seconds;
+  }
+  auto percent = [](G4double part, G4double whole) { return whole > 0. ? 100. * part / whole : 0.; };
+  auto nsPerStep = [](const StepProfile::Counts& c) {
+    return c.timedSteps > 0 ? 1.e9 * c.seconds / c.steps : 0.;
+  };
+
+  auto oldPrecision = G4cout.precision(3);
+  G4cout << "------------------------- Step profile (run " << runID << ") -------------------------" << G4endl;
+  G4cout << "  " << total.steps << " steps, " << total.tracks << " tracks, " << total.timedSteps
+         << " timed steps (1 in " << fSamplePeriod << "), estimated stepping CPU time " << total.seconds << " s" << G4endl;
+  G4cout << "  " << std::left << std::setw(20) << "volume" << std::setw(12) << "particle" << std::setw(18) << "process"
+         << std::right << std::setw(14) << "steps" << std::setw(8) << "%" << std::setw(12) << "tracks"
+         << std::setw(10) << "cpu_s" << std::setw(8) << "%" << std::setw(10) << "ns/step" << G4endl;
+  const size_t shown = std::min(rows.size(), static_cast<size_t>(fTopRows));
+  for (size_t i = 0; i < shown; ++i) {
+    const auto& key = rows[i].first;
+    const auto& c = rows[i].second;
+    G4cout << "  " << std::left << std::setw(20) << std::get<0>(key) << std::setw(12) << std::get<1>(key)
+           << std::setw(18) << std::get<2>(key) << std::right
+           << std::setw(14) << c.steps << std::setw(8) << percent(c.steps, total.steps)
+           << std::setw(12) << c.tracks << std::setw(10) << c.seconds << std::setw(8) << percent(c.seconds, total.seconds)
+           << std::setw(10) << nsPerStep(c) << G4endl;
+  }
+  if (shown < rows.size()) G4cout << "  ... " << rows.size() - shown << " more rows in " << fFileName << G4endl;
+  G4cout << "--------------------------------------------------------------------" << G4endl;
+  G4cout.precision(oldPrecision);
+
+  if (fFileName == "none") return;
+  std::ofstream out(fFileName, fFileStarted ? std::ios::app : std::ios::trunc);
+  if (!out) {
+    G4Exception("StepProfiler::Report()", "Profile_FileOpen", JustWarning, ("프로파일 파일을 열 수 없습니다: " + fFileName).c_str());
+    return;
+  }
+  if (!fFileStarted) out << "runID\tvolume\tparticle\tprocess\tsteps\ttracks\ttimedSteps\tcpu_s\n";
+  fFileStarted = true;
+  out.precision(6);
+  for (const auto& row : rows) {
+    const auto& key = row.first;
+    const auto& c = row.second;
+    out << runID << "\t" << std::get<0>(key) << "\t" << std::get<1>(key) << "\t" << std::get<2>(key) << "\t"
+        << c.steps << "\t" << c.tracks << "\t" << c.timedSteps << "\t" << c.seconds << "\n";
+  }
+}
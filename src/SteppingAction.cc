@@ -1,6 +1,182 @@
 #include "SteppingAction.hh"
+#include "Run.hh"
+#include "StepProfiler.hh"
+
 #include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4RunManager.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4OpBoundaryProcess.hh"
+#include "G4ProcessManager.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4GenericMessenger.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <ctime>
+
+namespace {
+  // 이 스레드가 쓴 CPU 시간 [s]. 벽시계와 달리 코어보다 스레드가 많거나 I/O로 멈춘 시간이 섞이지 않습니다.
+  G4double ThreadCPUSeconds()
+  {
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec + 1.e-9 * now.tv_nsec;
+  }
+}
+
+SteppingAction::SteppingAction()
+: G4UserSteppingAction(),
+  fKillOutsideAssembly(false), fKillDeadVolume(false),
+  fTimeWindow(0.), fMaxReflections(0),
+  fReflections(0), fBoundary(nullptr),
+  fStepsToSample(0), fTiming(false), fTimingStart(0.),
+  fMessenger(nullptr)
+{
+  DefineCommands();
+}
+
+SteppingAction::~SteppingAction()
+{
+  delete fMessenger;
+}
+
+void SteppingAction::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/myApp/photonKill/", "Early kill rules for optical photons.");
+
+  auto& outsideCmd = fMessenger->DeclareProperty("outsideAssembly", fKillOutsideAssembly,
+                                                 "Kill photons that leave a detector assembly into the world volume.");
+  outsideCmd.SetParameterName("Flag", false);
+  outsideCmd.SetStates(G4State_Idle);
+
+  auto& deadCmd = fMessenger->DeclareProperty("deadVolume", fKillDeadVolume,
+                                              "Kill photons that enter the PMT body, the source or the epoxy.");
+  deadCmd.SetParameterName("Flag", false);
+  deadCmd.SetStates(G4State_Idle);
+
+  auto& timeCmd = fMessenger->DeclarePropertyWithUnit("timeWindow", "ns", fTimeWindow,
+                                                      "Kill photons whose global time exceeds this value (0 = off).");
+  timeCmd.SetParameterName("Time", false);
+  timeCmd.SetStates(G4State_Idle);
+
+  auto& reflCmd = fMessenger->DeclareProperty("maxReflections", fMaxReflections,
+                                              "Kill photons after this many boundary reflections (0 = off).");
+  reflCmd.SetParameterName("N", false);
+  reflCmd.SetRange("N>=0");
+  reflCmd.SetStates(G4State_Idle);
+}
+
+void SteppingAction::UserSteppingAction(const G4Step* step)
+{
+  if (StepProfiler::Instance()->IsEnabled()) ProfileStep(step);
+
+  if (!fKillOutsideAssembly && !fKillDeadVolume && fTimeWindow <= 0. && fMaxReflections <= 0) return;
+
+  G4Track* track = step->GetTrack();
+  if (track->GetDefinition() != G4OpticalPhoton::Definition()) return;
+  if (track->GetTrackStatus() != fAlive) return; // 이미 흡수/검출된 광자
+
+  auto run = static_cast<Run*>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+  run->CountOpticalStep();
+
+  // 트랙의 첫 스텝에서 반사 횟수를 초기화합니다. (한 트랙은 끝까지 연속으로 추적됩니다)
+  if (track->GetCurrentStepNumber() == 1) fReflections = 0;
+
+  G4int rule = -1;
+  const G4StepPoint* postStep = step->GetPostStepPoint();
+
+  // World 밖으로 나가는 스텝은 fWorldBoundary 상태이므로 여기서는 다음 볼륨이 항상 존재합니다.
+  if (postStep->GetStepStatus() == fGeomBoundary) {
+    // 볼륨이 바뀌는 것은 경계 스텝뿐이므로, 볼륨 규칙은 여기서만 검사합니다.
+    G4VPhysicalVolume* nextVolume = postStep->GetPhysicalVolume();
+    const G4String& nextName = nextVolume->GetLogicalVolume()->GetName();
+
+    if (fKillOutsideAssembly && nextName == "LogicWorld") {
+      rule = Run::kKillOutsideAssembly;
+    }
+    else if (fKillDeadVolume &&
+             (nextName == "LogicPmtBody" || nextName == "LogicEpoxy" || nextName == "LogicSource")) {
+      rule = Run::kKillDeadVolume;
+    }
+    else if (fMaxReflections > 0 && IsReflection() && ++fReflections > fMaxReflections) {
+      rule = Run::kKillMaxReflections;
+    }
+  }
+
+  if (rule < 0 && fTimeWindow > 0. && postStep->GetGlobalTime() > fTimeWindow) {
+    rule = Run::kKillTimeWindow;
+  }
+
+  if (rule >= 0) {
+    track->SetTrackStatus(fStopAndKill);
+    run->CountPhotonKill(static_cast<Run::PhotonKillRule>(rule), track->GetCurrentStepNumber());
+  }
+}
+
+/**
+ * @brief 스텝을 (스텝 시작 볼륨, 입자, 스텝을 정한 프로세스)로 세고, 시간 표본을 처리합니다.
+ *
+ * 표본 스텝에서는 이 함수가 끝날 때 스레드 CPU 시계를 읽고, 다음 호출에서 그 사이의 CPU 시간(다음 스텝의 수송과 물리 처리)에
+ * 표본 주기를 곱해 다음 스텝의 조합에 더합니다. 다음 호출이 새 트랙의 첫 스텝이면 트랙 생성과 스택 처리
+ * 시간이 섞이므로 버리고, 그 스텝에서 다시 잽니다.
+ */
+void SteppingAction::ProfileStep(const G4Step* step)
+{
+  const G4Track* track = step->GetTrack();
+  const G4VPhysicalVolume* volume = step->GetPreStepPoint()->GetPhysicalVolume();
+  auto run = static_cast<Run*>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+  StepProfile::Counts& counts = run->GetProfile().CountStep(volume ? volume->GetLogicalVolume() : nullptr,
+                                                            track->GetDefinition(),
+                                                            step->GetPostStepPoint()->GetProcessDefinedStep());
+
+  const G4int period = StepProfiler::Instance()->GetSamplePeriod();
+  if (period <= 0) return;
+
+  if (fTiming) {
+    fTiming = false;
+    if (track->GetCurrentStepNumber() > 1) {
+      ++counts.timedSteps;
+      counts.seconds += period * (ThreadCPUSeconds() - fTimingStart);
+    }
+    else {
+      fStepsToSample = 0;
+    }
+  }
+  if (--fStepsToSample > 0) return;
+
+  fStepsToSample = period;
+  fTiming = true;
+  fTimingStart = ThreadCPUSeconds();
+}
+
+/**
+ * @brief 이번 스텝의 경계 처리 결과가 반사인지 확인합니다.
+ * G4OpBoundaryProcess는 스레드마다 하나이므로, 처음 호출될 때 광학 광자의 프로세스 목록에서 찾아 둡니다.
+ */
+G4bool SteppingAction::IsReflection()
+{
+  if (!fBoundary) {
+    G4ProcessManager* processManager = G4OpticalPhoton::Definition()->GetProcessManager();
+    G4ProcessVector* processes = processManager->GetProcessList();
+    for (size_t i = 0; i < processes->size(); ++i) {
+      if ((*processes)[i]->GetProcessName() == "OpBoundary") {
+        fBoundary = static_cast<G4OpBoundaryProcess*>((*processes)[i]);
+        break;
+      }
+    }
+    if (!fBoundary) return false;
+  }
 
-SteppingAction::SteppingAction() : G4UserSteppingAction() {}
-SteppingAction::~SteppingAction() {}
-void SteppingAction::UserSteppingAction(const G4Step* /*step*/) {}
+  switch (fBoundary->GetStatus()) {
+    case FresnelReflection:
+    case TotalInternalReflection:
+    case LambertianReflection:
+    case LobeReflection:
+    case SpikeReflection:
+    case BackScattering:
+      return true;
+    default:
+      return false;
+  }
+}
@@ -1,7 +1,56 @@
 #include "TrackingAction.hh"
 #include "G4Track.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4VProcess.hh"
+#include "G4VTouchable.hh"
+#include "G4NavigationHistory.hh"
+#include "G4LogicalVolume.hh"
+
+#include "OpticalMapManager.hh"
+#include "OpticalPhotonInfo.hh"
+#include "Run.hh"
+#include "StepProfiler.hh"
+
+#include "G4RunManager.hh"
 
 TrackingAction::TrackingAction() : G4UserTrackingAction() {}
 TrackingAction::~TrackingAction() {}
-void TrackingAction::PreUserTrackingAction(const G4Track* /*track*/) {}
+
+/**
+ * @brief 트랙 추적 시작 시 호출됩니다.
+ *
+ * 광학 룩업 맵 생성(build) 모드에서는 LS에서 섬광으로 생성된 광자의 위치(LS 로컬 좌표)와
+ * 에너지를 맵에 '생성' 카운트로 기록하고, 검출 시 같은 bin에 채울 수 있도록 트랙 정보를 붙입니다.
+ * 스텝 프로파일을 켜면 트랙을 (생성 볼륨, 입자, 생성 프로세스)로 셉니다.
+ */
+void TrackingAction::PreUserTrackingAction(const G4Track* track)
+{
+  if (StepProfiler::Instance()->IsEnabled()) {
+    auto run = static_cast<Run*>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+    const G4VPhysicalVolume* volume = track->GetVolume();
+    run->GetProfile().CountTrack(volume ? volume->GetLogicalVolume() : nullptr, track->GetDefinition(),
+                                 track->GetCreatorProcess());
+  }
+
+  auto mapManager = OpticalMapManager::Instance();
+  if (!mapManager->IsBuildMode()) return;
+  if (track->GetDefinition() != G4OpticalPhoton::Definition()) return;
+
+  const G4VProcess* creator = track->GetCreatorProcess();
+  if (!creator || creator->GetProcessName() != "Scintillation") return;
+
+  // SetInitialStep 이후 호출되므로 touchable은 광자가 생성된 볼륨(LS)을 가리킵니다.
+  const G4VTouchable* touchable = track->GetTouchable();
+  if (!touchable || touchable->GetVolume()->GetLogicalVolume()->GetName() != "LogicLS") return;
+
+  G4ThreeVector localPos = touchable->GetHistory()->GetTopTransform().TransformPoint(track->GetPosition());
+  OpticalLookupMap* map = mapManager->GetFillMap();
+  G4int bin = map->FindBin(localPos, track->GetKineticEnergy());
+  if (bin < 0) return;
+
+  map->FillEmitted(bin, track->GetWeight());
+  // 깊이 0 = PhysLS, 깊이 1 = PhysDetectorUnit (copy number = 유닛 번호)
+  const_cast<G4Track*>(track)->SetUserInformation(new OpticalPhotonInfo(touchable->GetCopyNumber(1), bin));
+}
+
 void TrackingAction::PostUserTrackingAction(const G4Track* /*track*/) {}
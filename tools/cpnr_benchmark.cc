@@ -0,0 +1,389 @@
+// cpnr_benchmark.cc
+// 시뮬레이션 실행 파일의 처리량을 고정된 헤드리스(배치) 설정들로 재고, 저장된 기준값(baseline)과 비교합니다.
+//
+// 사용법: cpnr_benchmark --exe <실행 파일> [--workdir 디렉터리] [--output benchmark.json]
+//                       [--baseline baseline.json] [--tolerance 0.10] [--update-baseline]
+//                       [--threads N] [--events N] [--events-no-optics N]
+//
+// - 설정: Co-60 GPS 선원, 거리 10/20/30 cm × 광학 켬(minimal)/끔(nooptical) × 스레드 1/N (N = 모든 코어)
+//   두 프리셋은 광학 물리만 다릅니다. (EM + RDM, 강입자 HP는 둘 다 없음)
+// - 설정마다 실행 파일을 두 번(광학 켬이면 세 번) 실행합니다.
+//     startup: /run/beamOn 0 (커널 초기화 + 물리 테이블 계산, 캐시는 끔)
+//     run    : /run/beamOn <events> (스텝 프로파일 끔)
+//     count  : run과 같은 시드/이벤트 수로 스텝 프로파일(/myApp/profile/, 계수만)을 켜고 다시 실행 (광학 켬만)
+//   처리량은 events / (run - startup)이고, 광자 처리량은 count의 opticalphoton 트랙 수 / (run - startup)입니다.
+//   프로파일러 비용은 잰 시간에 들어가지 않습니다. 최대 RSS는 run 프로세스의 rusage, 출력 크기는 run이 남긴 파일들의 합입니다.
+// - 결과는 설정당 한 줄의 JSON으로 쓰고, --baseline 파일이 있으면 같은 이름의 설정끼리 비교합니다.
+//   처리량이 (1 - tolerance)배 아래로 떨어지거나, 시작 시간/RSS/이벤트당 출력이 (1 + tolerance)배를 넘으면
+//   REGRESSION으로 표시하고 종료 코드 2를 돌려줍니다.
+//   --baseline 파일이 없거나 기준값이 없는 설정이 있으면 비교할 수 없으므로 종료 코드 3을 돌려줍니다.
+// - --update-baseline은 이번 결과를 기준값 파일로 저장합니다. 기준값은 같은 기계에서 잰 값끼리만 의미가 있습니다.
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Config {
+  std::string name;
+  int distance = 0;     // cm
+  bool optics = true;
+  int threads = 1;
+  int events = 0;
+};
+
+struct Result {
+  Config config;
+  double startupSeconds = 0.;
+  double runSeconds = 0.;
+  double eventsPerSecond = 0.;
+  double photonsPerSecond = 0.;
+  double peakRssMB = 0.;
+  double outputBytesPerEvent = 0.;
+};
+
+void PrintUsage()
+{
+  std::cerr << "Usage: cpnr_benchmark --exe executable [--workdir dir] [--output benchmark.json]\n"
+            << "                      [--baseline baseline.json] [--tolerance 0.10] [--update-baseline]\n"
+            << "                      [--threads N] [--events N] [--events-no-optics N]" << std::endl;
+}
+
+void WriteMacro(const fs::path& path, const Config& config, int events, const std::string& fileName, bool profile)
+{
+  std::ofstream out(path);
+  out << "/run/verbose 0\n/event/verbose 0\n/tracking/verbose 0\n"
+      << "/process/had/rdm/thresholdForVeryLongDecayTime 1.0e+60 year\n"
+      << "/process/had/rdm/nucleusLimits 60 60 27 27\n"
+      << "/gps/particle ion\n/gps/ion 27 60 0 0\n/gps/energy 0. keV\n"
+      << "/gps/source/confine LogicSource\n/gps/ang/type iso\n"
+      << "/myApp/detector/setDistance " << config.distance << " cm\n"
+      << "/myApp/writer/setFileName " << fileName << "\n";
+  if (profile) {
+    out << "/myApp/profile/enable true\n/myApp/profile/samplePeriod 0\n/myApp/profile/topRows 0\n"
+        << "/myApp/profile/file " << fileName << "_profile.tsv\n";
+  }
+  out << "/random/setSeeds 12345 67890\n"
+      << "/run/beamOn " << events << "\n";
+}
+
+// 실행 파일을 workdir에서 실행하고 벽시계 시간과 최대 RSS(kB)를 잽니다. 표준 출력/오류는 log 파일로 보냅니다.
+bool RunProcess(const std::string& exe, const std::vector<std::string>& args, const fs::path& workdir,
+                const std::string& log, double& seconds, long& maxRssKB)
+{
+  std::vector<char*> argv;
+  argv.push_back(const_cast<char*>(exe.c_str()));
+  for (const auto& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+  argv.push_back(nullptr);
+
+  const auto start = std::chrono::steady_clock::now();
+  const pid_t pid = fork();
+  if (pid < 0) return false;
+  if (pid == 0) {
+    if (chdir(workdir.c_str()) != 0) _exit(127);
+    const int fd = open(log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0) {
+      dup2(fd, STDOUT_FILENO);
+      dup2(fd, STDERR_FILENO);
+      close(fd);
+    }
+    execv(exe.c_str(), argv.data());
+    _exit(127);
+  }
+
+  int status = 0;
+  struct rusage usage {};
+  if (wait4(pid, &status, 0, &usage) != pid) return false;
+  seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  maxRssKB = usage.ru_maxrss;
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// 스텝 프로파일 파일에서 opticalphoton 트랙 수를 더합니다.
+long CountOpticalPhotons(const fs::path& profileFile)
+{
+  std::ifstream in(profileFile);
+  std::string text;
+  std::getline(in, text);  // 머리줄
+  long photons = 0;
+  while (std::getline(in, text)) {
+    std::istringstream line(text);
+    std::string runID, volume, particle, process;
+    long steps = 0, tracks = 0;
+    std::getline(line, runID, '\t');
+    std::getline(line, volume, '\t');
+    std::getline(line, particle, '\t');
+    std::getline(line, process, '\t');
+    line >> steps >> tracks;
+    if (particle == "opticalphoton") photons += tracks;
+  }
+  return photons;
+}
+
+// <prefix>.root, <prefix>_t<n>.root, <prefix>.col 등 run이 남긴 출력 파일의 크기 합
+std::uintmax_t OutputBytes(const fs::path& workdir, const std::string& prefix)
+{
+  std::uintmax_t bytes = 0;
+  for (const auto& entry : fs::directory_iterator(workdir)) {
+    if (!entry.is_regular_file()) continue;
+    const std::string name = entry.path().filename().string();
+    const std::string extension = entry.path().extension().string();
+    if (name.compare(0, prefix.size(), prefix) == 0 && (extension == ".root" || extension == ".col")) {
+      bytes += entry.file_size();
+    }
+  }
+  return bytes;
+}
+
+void RemoveOutputs(const fs::path& workdir, const std::string& prefix)
+{
+  std::vector<fs::path> stale;
+  for (const auto& entry : fs::directory_iterator(workdir)) {
+    if (entry.path().filename().string().compare(0, prefix.size(), prefix) == 0) stale.push_back(entry.path());
+  }
+  for (const auto& path : stale) fs::remove(path);
+}
+
+bool RunConfig(const std::string& exe, const fs::path& workdir, const Config& config, Result& result)
+{
+  const std::string runName = "bench_" + config.name;
+  const std::string startupName = "bench_startup_" + config.name;
+  const std::string countName = "bench_count_" + config.name;
+  RemoveOutputs(workdir, runName);
+  RemoveOutputs(workdir, startupName);
+  RemoveOutputs(workdir, countName);
+  WriteMacro(workdir / (startupName + ".mac"), config, 0, startupName, false);
+  WriteMacro(workdir / (runName + ".mac"), config, config.events, runName, false);
+  if (config.optics) WriteMacro(workdir / (countName + ".mac"), config, config.events, countName, true);
+
+  const std::vector<std::string> common = {"--physics", config.optics ? "minimal" : "nooptical",
+                                           "--physics-cache", "off", "--threads", std::to_string(config.threads)};
+  auto withMacro = [&common](const std::string& macro) {
+    std::vector<std::string> args = common;
+    args.push_back(macro);
+    return args;
+  };
+
+  long startupRss = 0, runRss = 0;
+  if (!RunProcess(exe, withMacro(startupName + ".mac"), workdir, startupName + ".log", result.startupSeconds, startupRss)
+      || !RunProcess(exe, withMacro(runName + ".mac"), workdir, runName + ".log", result.runSeconds, runRss)) {
+    std::cerr << "cpnr_benchmark: " << config.name << " failed, see " << (workdir / (runName + ".log")).string() << std::endl;
+    return false;
+  }
+
+  // 광자 수는 프로파일을 켠 별도 실행에서 셉니다. (시간/RSS는 버림)
+  long photons = 0;
+  if (config.optics) {
+    double countSeconds = 0.;
+    long countRss = 0;
+    if (!RunProcess(exe, withMacro(countName + ".mac"), workdir, countName + ".log", countSeconds, countRss)) {
+      std::cerr << "cpnr_benchmark: " << config.name << " photon count failed, see "
+                << (workdir / (countName + ".log")).string() << std::endl;
+      return false;
+    }
+    photons = CountOpticalPhotons(workdir / (countName + "_profile.tsv"));
+  }
+
+  result.config = config;
+  const double eventSeconds = std::max(result.runSeconds - result.startupSeconds, 1.e-9);
+  result.eventsPerSecond = config.events / eventSeconds;
+  result.photonsPerSecond = photons / eventSeconds;
+  result.peakRssMB = runRss / 1024.;
+  result.outputBytesPerEvent = static_cast<double>(OutputBytes(workdir, runName)) / config.events;
+  return true;
+}
+
+void WriteJson(std::ostream& out, const std::vector<Result>& results)
+{
+  out << "{\n  \"tool\": \"cpnr_benchmark\",\n  \"results\": [\n";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result& r = results[i];
+    char line[512];
+    std::snprintf(line, sizeof(line),
+                  "    {\"name\": \"%s\", \"distance_cm\": %d, \"optics\": %s, \"threads\": %d, \"events\": %d, "
+                  "\"startup_s\": %.3f, \"events_per_s\": %.3f, \"photons_per_s\": %.1f, "
+                  "\"peak_rss_mb\": %.1f, \"output_bytes_per_event\": %.1f}%s\n",
+                  r.config.name.c_str(), r.config.distance, r.config.optics ? "true" : "false", r.config.threads,
+                  r.config.events, r.startupSeconds, r.eventsPerSecond, r.photonsPerSecond, r.peakRssMB,
+                  r.outputBytesPerEvent, i + 1 < results.size() ? "," : "");
+    out << line;
+  }
+  out << "  ]\n}\n";
+}
+
+// WriteJson이 쓴 형식(설정당 한 줄)에서 "key": 값을 읽습니다.
+bool JsonNumber(const std::string& line, const std::string& key, double& value)
+{
+  const std::string pattern = "\"" + key + "\": ";
+  const size_t pos = line.find(pattern);
+  if (pos == std::string::npos) return false;
+  value = std::atof(line.c_str() + pos + pattern.size());
+  return true;
+}
+
+std::map<std::string, std::map<std::string, double>> ReadBaseline(const fs::path& fileName)
+{
+  std::map<std::string, std::map<std::string, double>> baseline;
+  std::ifstream in(fileName);
+  std::string line;
+  while (std::getline(in, line)) {
+    const std::string pattern = "\"name\": \"";
+    const size_t pos = line.find(pattern);
+    if (pos == std::string::npos) continue;
+    const size_t begin = pos + pattern.size();
+    const std::string name = line.substr(begin, line.find('"', begin) - begin);
+    for (const char* key : {"startup_s", "events_per_s", "photons_per_s", "peak_rss_mb", "output_bytes_per_event"}) {
+      double value = 0.;
+      if (JsonNumber(line, key, value)) baseline[name][key] = value;
+    }
+  }
+  return baseline;
+}
+
+// 기준값과 비교한 표를 출력하고, 허용 범위를 넘은 항목 수를 돌려줍니다. 기준값이 없는 설정 수는 missing에 셉니다.
+int CompareBaseline(const std::vector<Result>& results, const fs::path& baselineFile, double tolerance, int& missing)
+{
+  const auto baseline = ReadBaseline(baselineFile);
+  struct Metric { const char* key; bool higherIsBetter; double Result::*value; };
+  const Metric metrics[] = {
+    {"events_per_s", true, &Result::eventsPerSecond},
+    {"photons_per_s", true, &Result::photonsPerSecond},
+    {"startup_s", false, &Result::startupSeconds},
+    {"peak_rss_mb", false, &Result::peakRssMB},
+    {"output_bytes_per_event", false, &Result::outputBytesPerEvent},
+  };
+
+  int regressions = 0;
+  std::printf("===== Comparison with %s (tolerance %.0f %%) =====\n", baselineFile.string().c_str(), 100. * tolerance);
+  for (const auto& result : results) {
+    auto found = baseline.find(result.config.name);
+    if (found == baseline.end()) {
+      std::printf("%-22s no baseline entry\n", result.config.name.c_str());
+      ++missing;
+      continue;
+    }
+    for (const auto& metric : metrics) {
+      auto reference = found->second.find(metric.key);
+      if (reference == found->second.end() || reference->second <= 0.) continue;
+      const double current = result.*metric.value;
+      const double ratio = current / reference->second;
+      const bool regressed = metric.higherIsBetter ? ratio < 1. - tolerance : ratio > 1. + tolerance;
+      if (regressed) ++regressions;
+      std::printf("%-22s %-24s %14.3f -> %14.3f  %+7.1f %%  %s\n", result.config.name.c_str(), metric.key,
+                  reference->second, current, 100. * (ratio - 1.), regressed ? "REGRESSION" : "ok");
+    }
+  }
+  return regressions;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  std::string exe;
+  fs::path workdir = "benchmark_runs";
+  fs::path output = "benchmark.json";
+  fs::path baselineFile;
+  double tolerance = 0.10;
+  bool updateBaseline = false;
+  int maxThreads = static_cast<int>(std::thread::hardware_concurrency());
+  int events = 500;
+  int eventsNoOptics = 20000;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--exe" && i + 1 < argc) exe = argv[++i];
+    else if (arg == "--workdir" && i + 1 < argc) workdir = argv[++i];
+    else if (arg == "--output" && i + 1 < argc) output = argv[++i];
+    else if (arg == "--baseline" && i + 1 < argc) baselineFile = argv[++i];
+    else if (arg == "--tolerance" && i + 1 < argc) tolerance = std::atof(argv[++i]);
+    else if (arg == "--update-baseline") updateBaseline = true;
+    else if (arg == "--threads" && i + 1 < argc) maxThreads = std::atoi(argv[++i]);
+    else if (arg == "--events" && i + 1 < argc) events = std::atoi(argv[++i]);
+    else if (arg == "--events-no-optics" && i + 1 < argc) eventsNoOptics = std::atoi(argv[++i]);
+    else {
+      PrintUsage();
+      return 1;
+    }
+  }
+  if (exe.empty() || events <= 0 || eventsNoOptics <= 0) {
+    PrintUsage();
+    return 1;
+  }
+  exe = fs::absolute(exe).string();
+  fs::create_directories(workdir);
+
+  std::vector<int> threadCounts = {1};
+  if (maxThreads > 1) threadCounts.push_back(maxThreads);
+
+  std::vector<Config> configs;
+  for (int distance : {10, 20, 30}) {
+    for (bool optics : {true, false}) {
+      for (int threads : threadCounts) {
+        Config config;
+        config.name = "d" + std::to_string(distance) + (optics ? "_optics" : "_nooptics") + "_t" + std::to_string(threads);
+        config.distance = distance;
+        config.optics = optics;
+        config.threads = threads;
+        config.events = optics ? events : eventsNoOptics;
+        configs.push_back(config);
+      }
+    }
+  }
+
+  std::vector<Result> results;
+  for (const auto& config : configs) {
+    std::cout << "--> " << config.name << " (" << config.events << " events)" << std::endl;
+    Result result;
+    if (!RunConfig(exe, workdir, config, result)) return 1;
+    std::printf("    startup %.2f s, %.2f events/s, %.3g photons/s, peak RSS %.0f MB, %.0f bytes/event\n",
+                result.startupSeconds, result.eventsPerSecond, result.photonsPerSecond, result.peakRssMB,
+                result.outputBytesPerEvent);
+    results.push_back(result);
+  }
+
+  std::ofstream out(output);
+  WriteJson(out, results);
+  out.close();
+  std::cout << "===== Results written to " << output.string() << " =====" << std::endl;
+
+  if (baselineFile.empty()) return 0;
+  if (updateBaseline) {
+    fs::copy_file(output, baselineFile, fs::copy_options::overwrite_existing);
+    std::cout << "--> Baseline updated: " << baselineFile.string() << std::endl;
+    return 0;
+  }
+  if (!fs::exists(baselineFile)) {
+    std::cerr << "cpnr_benchmark: no baseline at " << baselineFile.string()
+              << "; run with --update-baseline (or the benchmark_baseline target) on this machine to store one." << std::endl;
+    return 3;
+  }
+  int missing = 0;
+  const int regressions = CompareBaseline(results, baselineFile, tolerance, missing);
+  if (regressions > 0) {
+    std::cerr << "cpnr_benchmark: " << regressions << " metric(s) regressed beyond the tolerance." << std::endl;
+    return 2;
+  }
+  if (missing > 0) {
+    std::cerr << "cpnr_benchmark: " << missing << " configuration(s) have no baseline entry; "
+              << "update the baseline on this machine (benchmark_baseline target)." << std::endl;
+    return 3;
+  }
+  return 0;
+}
@@ -0,0 +1,324 @@
+// cpnr_columnar_bench.cc
+// ROOT TTree 출력과 열 단위 mmap 출력(ColumnarFile.hh)의 읽기 속도를 같은 분석 패스로 비교합니다.
+//
+// 사용법: cpnr_columnar_bench [-r 반복 횟수] input.root [input.col]
+//
+// - .col 파일을 주지 않으면 input.root를 같은 이름의 .col로 변환한 뒤 비교합니다.
+//   (변환은 정수/실수 스칼라 브랜치만 옮기며, 가변 길이 열인 timeHist는 건너뜁니다.)
+// - 분석 패스는 오프라인 동시계수 분석의 핵심 루프를 흉내 냅니다:
+//   EventSummary에서 이벤트별 검출기 수와 가시 에너지 합, PMTHits에서 가중치 합과 시간 범위를 구합니다.
+// - 각 경로를 여러 번 반복해 가장 빠른 시간을 보고하고, 두 경로의 결과가 같은지 확인합니다.
+
+#include "ColumnarFile.hh"
+
+#include "TBranch.h"
+#include "TFile.h"
+#include "TLeaf.h"
+#include "TObjArray.h"
+#include "TTree.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct PassResult {
+  std::int64_t summaryRows = 0;
+  std::int64_t events = 0;
+  std::int64_t coincidences = 0;     // 두 개 이상의 검출기에 증착이 있는 이벤트
+  double visibleEnergy = 0.;
+  std::int64_t pmtRows = 0;
+  double pmtWeight = 0.;
+  double minTime = std::numeric_limits<double>::max();
+  double maxTime = std::numeric_limits<double>::lowest();
+  std::size_t bytesTouched = 0;      // 패스가 읽은 열 데이터의 크기 (압축 해제 후)
+  bool failed = false;               // 파일을 열 수 없거나 필요한 열이 없음
+};
+
+bool SameResult(const PassResult& a, const PassResult& b)
+{
+  auto close = [](double x, double y) { return std::fabs(x - y) <= 1.e-9 * std::max(1., std::fabs(x)); };
+  return a.summaryRows == b.summaryRows && a.events == b.events && a.coincidences == b.coincidences
+      && a.pmtRows == b.pmtRows && close(a.visibleEnergy, b.visibleEnergy) && close(a.pmtWeight, b.pmtWeight)
+      && (a.pmtRows == 0 || (a.minTime == b.minTime && a.maxTime == b.maxTime));
+}
+
+// 이벤트별 행 묶음을 세는 공통 로직 (행은 이벤트 단위로 연속해서 기록되어 있습니다)
+struct EventCounter {
+  std::int32_t currentEvent = -1;
+  int detectorsInEvent = 0;
+
+  void Add(std::int32_t eventID, PassResult& result)
+  {
+    if (eventID != currentEvent) {
+      Finish(result);
+      currentEvent = eventID;
+      ++result.events;
+    }
+    ++detectorsInEvent;
+  }
+  void Finish(PassResult& result)
+  {
+    if (detectorsInEvent >= 2) ++result.coincidences;
+    detectorsInEvent = 0;
+  }
+};
+
+PassResult RunRootPass(const std::string& fileName)
+{
+  PassResult result;
+  std::unique_ptr<TFile> file(TFile::Open(fileName.c_str(), "READ"));
+  if (!file || file->IsZombie()) return result;
+
+  if (auto tree = file->Get<TTree>("EventSummary")) {
+    Int_t eventID = 0;
+    Double_t visible = 0.;
+    tree->SetBranchStatus("*", false);
+    tree->SetBranchStatus("eventID", true);
+    tree->SetBranchStatus("visibleEnergy_MeV", true);
+    tree->SetBranchAddress("eventID", &eventID);
+    tree->SetBranchAddress("visibleEnergy_MeV", &visible);
+
+    EventCounter counter;
+    const Long64_t n = tree->GetEntries();
+    for (Long64_t i = 0; i < n; ++i) {
+      tree->GetEntry(i);
+      counter.Add(eventID, result);
+      result.visibleEnergy += visible;
+    }
+    counter.Finish(result);
+    result.summaryRows = n;
+    result.bytesTouched += n * (sizeof(Int_t) + sizeof(Double_t));
+  }
+
+  if (auto tree = file->Get<TTree>("PMTHits")) {
+    Double_t time = 0., weight = 0.;
+    tree->SetBranchStatus("*", false);
+    tree->SetBranchStatus("time_ns", true);
+    tree->SetBranchStatus("weight", true);
+    tree->SetBranchAddress("time_ns", &time);
+    tree->SetBranchAddress("weight", &weight);
+
+    const Long64_t n = tree->GetEntries();
+    for (Long64_t i = 0; i < n; ++i) {
+      tree->GetEntry(i);
+      result.pmtWeight += weight;
+      result.minTime = std::min(result.minTime, time);
+      result.maxTime = std::max(result.maxTime, time);
+    }
+    result.pmtRows = n;
+    result.bytesTouched += n * 2 * sizeof(Double_t);
+  }
+  return result;
+}
+
+PassResult RunColumnarPass(const std::string& fileName)
+{
+  PassResult result;
+  columnar::Reader reader;
+  if (!reader.Open(fileName)) {
+    std::cerr << "cpnr_columnar_bench: " << reader.GetError() << std::endl;
+    result.failed = true;
+    return result;
+  }
+  // 이전 형식의 파일(예: weight 열이 없는 파일)은 열 번호 -1로 읽지 않도록 먼저 확인합니다.
+  auto requireColumn = [&fileName, &result](const columnar::Table& table, const char* tableName, const char* column) {
+    const int index = table.FindColumn(column);
+    if (index < 0) {
+      std::cerr << "cpnr_columnar_bench: " << fileName << " has no column '" << column << "' in table "
+                << tableName << "." << std::endl;
+      result.failed = true;
+    }
+    return index;
+  };
+
+  if (const columnar::Table* table = reader.GetTable("EventSummary")) {
+    const int eventColumn = requireColumn(*table, "EventSummary", "eventID");
+    const int visibleColumn = requireColumn(*table, "EventSummary", "visibleEnergy_MeV");
+    if (result.failed) return result;
+    EventCounter counter;
+    for (std::size_t chunk = 0; chunk < table->GetNumberOfChunks(); ++chunk) {
+      auto eventIDs = table->GetColumn<std::int32_t>(chunk, eventColumn);
+      auto visible = table->GetColumn<double>(chunk, visibleColumn);
+      for (std::size_t i = 0; i < eventIDs.size(); ++i) {
+        counter.Add(eventIDs[i], result);
+        result.visibleEnergy += visible[i];
+      }
+    }
+    counter.Finish(result);
+    result.summaryRows = table->GetNumberOfRows();
+    result.bytesTouched += result.summaryRows * (sizeof(std::int32_t) + sizeof(double));
+  }
+
+  if (const columnar::Table* table = reader.GetTable("PMTHits")) {
+    const int timeColumn = requireColumn(*table, "PMTHits", "time_ns");
+    const int weightColumn = requireColumn(*table, "PMTHits", "weight");
+    if (result.failed) return result;
+    for (std::size_t chunk = 0; chunk < table->GetNumberOfChunks(); ++chunk) {
+      auto times = table->GetColumn<double>(chunk, timeColumn);
+      auto weights = table->GetColumn<double>(chunk, weightColumn);
+      for (std::size_t i = 0; i < times.size(); ++i) {
+        result.pmtWeight += weights[i];
+        result.minTime = std::min(result.minTime, times[i]);
+        result.maxTime = std::max(result.maxTime, times[i]);
+      }
+    }
+    result.pmtRows = table->GetNumberOfRows();
+    result.bytesTouched += result.pmtRows * 2 * sizeof(double);
+  }
+  return result;
+}
+
+// ROOT 출력의 스칼라 브랜치를 같은 이름의 열로 옮깁니다.
+bool ConvertRootToColumnar(const std::string& input, const std::string& output)
+{
+  std::unique_ptr<TFile> file(TFile::Open(input.c_str(), "READ"));
+  if (!file || file->IsZombie()) return false;
+
+  columnar::Writer writer;
+  if (!writer.Open(output)) return false;
+
+  // 브랜치 주소는 변환 동안 고정되어야 하므로 모든 테이블의 버퍼를 미리 만듭니다.
+  struct Value { Int_t i; Double_t d; };
+  struct TableInput {
+    TTree* tree;
+    std::size_t table;
+    std::vector<columnar::ColumnType> types;
+    std::vector<Value> values;
+  };
+  std::vector<TableInput> inputs;
+
+  for (const char* name : {"Hits", "EventSummary", "PMTHits", "PMTSummary"}) {
+    auto tree = file->Get<TTree>(name);
+    if (!tree) continue;
+
+    std::vector<columnar::ColumnSpec> specs;
+    std::vector<std::string> branchNames;
+    for (auto object : *tree->GetListOfBranches()) {
+      auto branch = static_cast<TBranch*>(object);
+      if (branch->GetListOfLeaves()->GetEntries() != 1) continue;
+      std::string type = static_cast<TLeaf*>(branch->GetListOfLeaves()->At(0))->GetTypeName();
+      if (type == "Int_t") specs.push_back({branch->GetName(), columnar::ColumnType::kInt32});
+      else if (type == "Double_t") specs.push_back({branch->GetName(), columnar::ColumnType::kFloat64});
+      else continue;
+      branchNames.push_back(branch->GetName());
+    }
+
+    TableInput tableInput;
+    tableInput.tree = tree;
+    tableInput.table = writer.AddTable(name, specs);
+    for (const auto& spec : specs) tableInput.types.push_back(spec.type);
+    tableInput.values.resize(specs.size());
+    inputs.push_back(std::move(tableInput));
+
+    TableInput& stored = inputs.back();
+    tree->SetBranchStatus("*", false);
+    for (std::size_t c = 0; c < branchNames.size(); ++c) {
+      tree->SetBranchStatus(branchNames[c].c_str(), true);
+      if (stored.types[c] == columnar::ColumnType::kInt32) tree->SetBranchAddress(branchNames[c].c_str(), &stored.values[c].i);
+      else tree->SetBranchAddress(branchNames[c].c_str(), &stored.values[c].d);
+    }
+  }
+
+  for (auto& tableInput : inputs) {
+    const Long64_t n = tableInput.tree->GetEntries();
+    for (Long64_t i = 0; i < n; ++i) {
+      tableInput.tree->GetEntry(i);
+      for (std::size_t c = 0; c < tableInput.values.size(); ++c) {
+        if (tableInput.types[c] == columnar::ColumnType::kInt32) writer.Append(tableInput.table, c, std::int32_t(tableInput.values[c].i));
+        else writer.Append(tableInput.table, c, double(tableInput.values[c].d));
+      }
+      writer.EndRow(tableInput.table);
+    }
+  }
+
+  if (auto tree = file->Get<TTree>("Dictionary")) {
+    Int_t code = 0;
+    char name[256] = {0};
+    tree->SetBranchAddress("code", &code);
+    tree->SetBranchAddress("name", name);
+    std::vector<std::string> names;
+    for (Long64_t i = 0; i < tree->GetEntries(); ++i) {
+      tree->GetEntry(i);
+      if (code >= static_cast<Int_t>(names.size())) names.resize(code + 1);
+      names[code] = name;
+    }
+    writer.SetDictionary(names);
+  }
+  return writer.Close();
+}
+
+template <typename Pass>
+double BestTime(Pass pass, int repeats, PassResult& result)
+{
+  double best = std::numeric_limits<double>::max();
+  for (int r = 0; r < repeats; ++r) {
+    auto start = std::chrono::steady_clock::now();
+    result = pass();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    best = std::min(best, seconds);
+  }
+  return best;
+}
+
+void PrintResult(const char* label, double seconds, const PassResult& result)
+{
+  const double rows = static_cast<double>(result.summaryRows + result.pmtRows);
+  std::printf("  %-9s %10.4f s  %10.3g rows/s  %8.1f MB/s\n", label, seconds,
+              rows / seconds, result.bytesTouched / seconds / 1.e6);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  int repeats = 3;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "-r" && i + 1 < argc) repeats = std::max(1, std::atoi(argv[++i]));
+    else files.push_back(arg);
+  }
+  if (files.empty() || files.size() > 2) {
+    std::cerr << "Usage: cpnr_columnar_bench [-r repeats] input.root [input.col]" << std::endl;
+    return 1;
+  }
+
+  const std::string rootFile = files[0];
+  std::string columnarFile = files.size() > 1 ? files[1] : rootFile.substr(0, rootFile.rfind('.')) + ".col";
+  if (files.size() == 1) {
+    std::cout << "--> Converting " << rootFile << " to " << columnarFile << std::endl;
+    if (!ConvertRootToColumnar(rootFile, columnarFile)) {
+      std::cerr << "cpnr_columnar_bench: conversion failed." << std::endl;
+      return 1;
+    }
+  }
+
+  PassResult rootResult, columnarResult;
+  double rootSeconds = BestTime([&]() { return RunRootPass(rootFile); }, repeats, rootResult);
+  double columnarSeconds = BestTime([&]() { return RunColumnarPass(columnarFile); }, repeats, columnarResult);
+  if (columnarResult.failed) return 1;
+
+  std::printf("Coincidence pass over EventSummary (%lld rows) and PMTHits (%lld rows), best of %d:\n",
+              static_cast<long long>(rootResult.summaryRows), static_cast<long long>(rootResult.pmtRows), repeats);
+  PrintResult("ROOT", rootSeconds, rootResult);
+  PrintResult("columnar", columnarSeconds, columnarResult);
+  std::printf("  speed-up  %10.1fx\n", rootSeconds / columnarSeconds);
+  std::printf("  events %lld, coincidences %lld\n",
+              static_cast<long long>(columnarResult.events), static_cast<long long>(columnarResult.coincidences));
+
+  if (!SameResult(rootResult, columnarResult)) {
+    std::cerr << "cpnr_columnar_bench: ROOT and columnar passes disagree." << std::endl;
+    return 2;
+  }
+  return 0;
+}
@@ -0,0 +1,575 @@
+// cpnr_merge.cc
+// 스레드별(output_t*.root) 또는 여러 Run의 ROOT 출력 파일을 하나로 병합하는 독립 실행 도구입니다.
+//
+// 사용법: cpnr_merge [-j 스레드 수] -o merged.root input1.root input2.root ...
+//         cpnr_merge [-j 스레드 수] -o merged.root run_shard*.counters
+//
+// - 입력 파일은 이름순으로 정렬한 뒤 연속된 묶음으로 나누어 병렬로 부분 병합하고,
+//   부분 파일들을 같은 순서로 최종 병합합니다. 묶음 구성과 순서가 입력 목록만으로 정해지므로
+//   같은 입력을 다시 병합하면 항목(entry) 순서가 항상 같습니다.
+// - TFileMerger의 빠른 복사(fast cloning)를 사용하고 첫 입력 파일의 압축 설정을 그대로 쓰므로,
+//   basket을 풀지 않고 그대로 이어 붙입니다.
+// - 출력 파일은 ROOT의 reproducible 옵션으로 열어 UUID와 날짜를 고정하므로, 다시 병합한 결과를
+//   비트 단위로 비교할 수 있습니다.
+// - 이름 코드(Dictionary)는 같은 물리 목록/지오메트리로 실행한 프로세스 사이에서 같도록 정해지지만
+//   (NameDictionary::RegisterKnownNames), 입력 파일들 사이에 같은 코드가 다른 이름을 가리키면
+//   아무 파일도 쓰기 전에 병합을 중단합니다.
+// - shard 실행(/myApp/shard/)의 .counters 파일을 주면, 모든 shard가 같은 런(시드, 이벤트 수, shard 수, 조건)에
+//   속하고 빠짐없이 한 번씩 있는지 확인한 뒤 카운터를 합쳐 merged.counters에 쓰고 W(θ)를 출력하며,
+//   각 .counters에 적힌 출력 파일과 그 스레드별 파일(<이름>_t<n>.root)을 모두 병합합니다.
+//   방향 강제 런의 이벤트 가중치 합(singlesWeight, pairWeights)도 함께 합치며, 가중치 줄이 없는
+//   이전 형식의 파일은 계수를 가중치 1의 합으로 봅니다.
+
+#include "TFile.h"
+#include "TFileMerger.h"
+#include "TROOT.h"
+#include "TTree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void PrintUsage()
+{
+  std::cerr << "Usage: cpnr_merge [-j nThreads] -o output.root input1.root [input2.root ...]\n"
+            << "       cpnr_merge [-j nThreads] -o output.root shard0.counters [shard1.counters ...]" << std::endl;
+}
+
+bool EndsWith(const std::string& text, const std::string& suffix)
+{
+  return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Run::WeightSum과 같은 가중치 합과 제곱합
+struct WeightSum {
+  double sum = 0.;
+  double sum2 = 0.;
+  void Add(const WeightSum& other) { sum += other.sum; sum2 += other.sum2; }
+  double Rate(long n) const { return n > 0 ? sum / n : 0.; }
+  double RateError(long n) const { return n > 0 ? std::sqrt(std::max(0., sum2 - sum * sum / n)) / n : 0.; }
+};
+
+struct PairWeights {
+  WeightSum weight;
+  WeightSum gatedWeight;
+  WeightSum overlapWeight;   // 두 PMT가 모두 트리거된 이벤트 (시간 창과 무관)
+};
+
+// ShardManager::WriteCounters / Run::WriteCounters 형식의 shard 카운터
+struct ShardCounters {
+  long runSeed = 0;
+  long totalEvents = 0;
+  int shardIndex = 0;
+  int shardCount = 1;
+  long firstEvent = 0;
+  std::string output;
+  std::string distance;               // 검출기 배치는 문자열 그대로 비교하고 기록합니다.
+  std::string unitAngles;
+  std::string settings;
+  long events = 0;
+  std::vector<long> photonKills;
+  std::vector<long> photonKillSteps;
+  long opticalSteps = 0;
+  long triggerAccepted = 0;
+  long triggerRejected = 0;
+  long stackingAccepted = 0;
+  long stackingRejected = 0;
+  std::vector<long> singles;
+  std::vector<long> gatedSingles;
+  std::map<std::pair<int, int>, std::pair<long, long>> pairs;  // (coincidences, gatedCoincidences)
+  std::vector<WeightSum> singlesWeight;
+  std::vector<WeightSum> gatedSinglesWeight;
+  std::map<std::pair<int, int>, PairWeights> pairWeights;
+  bool hasWeights = false;
+};
+
+std::vector<long> ReadValues(std::istringstream& line, bool withCount)
+{
+  std::vector<long> values;
+  size_t count = 0;
+  if (withCount) line >> count;
+  long value = 0;
+  while (line >> value) values.push_back(value);
+  if (withCount && values.size() != count) values.clear();
+  return values;
+}
+
+std::vector<WeightSum> ReadWeights(std::istringstream& line)
+{
+  std::vector<WeightSum> sums;
+  size_t count = 0;
+  line >> count;
+  WeightSum value;
+  while (line >> value.sum >> value.sum2) sums.push_back(value);
+  if (sums.size() != count) sums.clear();
+  return sums;
+}
+
+// 가중치 줄이 없는 이전 형식: 모든 이벤트 가중치를 1로 봅니다. (합 = 제곱합 = 계수)
+std::vector<WeightSum> UnitWeights(const std::vector<long>& counts)
+{
+  std::vector<WeightSum> sums(counts.size());
+  for (size_t i = 0; i < counts.size(); ++i) sums[i].sum = sums[i].sum2 = static_cast<double>(counts[i]);
+  return sums;
+}
+
+std::string Rest(std::istringstream& line)
+{
+  std::string rest;
+  std::getline(line >> std::ws, rest);
+  return rest;
+}
+
+bool ReadCounters(const std::string& fileName, ShardCounters& counters)
+{
+  std::ifstream in(fileName);
+  if (!in) return false;
+
+  std::string text;
+  while (std::getline(in, text)) {
+    if (text.empty() || text[0] == '#') continue;
+    std::istringstream line(text);
+    std::string key;
+    line >> key;
+    if (key == "runSeed") line >> counters.runSeed;
+    else if (key == "totalEvents") line >> counters.totalEvents;
+    else if (key == "shardIndex") line >> counters.shardIndex;
+    else if (key == "shardCount") line >> counters.shardCount;
+    else if (key == "firstEvent") line >> counters.firstEvent;
+    else if (key == "output") line >> counters.output;
+    else if (key == "distance_cm") counters.distance = Rest(line);
+    else if (key == "unitAngles_deg") counters.unitAngles = Rest(line);
+    else if (key == "settings") counters.settings = Rest(line);
+    else if (key == "events") line >> counters.events;
+    else if (key == "photonKills") counters.photonKills = ReadValues(line, false);
+    else if (key == "photonKillSteps") counters.photonKillSteps = ReadValues(line, false);
+    else if (key == "opticalSteps") line >> counters.opticalSteps;
+    else if (key == "trigger") line >> counters.triggerAccepted >> counters.triggerRejected;
+    else if (key == "stacking") line >> counters.stackingAccepted >> counters.stackingRejected;
+    else if (key == "singles") counters.singles = ReadValues(line, true);
+    else if (key == "gatedSingles") counters.gatedSingles = ReadValues(line, true);
+    else if (key == "pairs") {
+      size_t nPairs = 0;
+      line >> nPairs;
+      for (size_t i = 0; i < nPairs && std::getline(in, text); ++i) {
+        std::istringstream pairLine(text);
+        int a = 0, b = 0;
+        long coincidences = 0, gated = 0;
+        pairLine >> a >> b >> coincidences >> gated;
+        counters.pairs[{a, b}] = {coincidences, gated};
+      }
+    }
+    else if (key == "singlesWeight") {
+      counters.singlesWeight = ReadWeights(line);
+      counters.hasWeights = true;
+    }
+    else if (key == "gatedSinglesWeight") counters.gatedSinglesWeight = ReadWeights(line);
+    else if (key == "pairWeights") {
+      size_t nPairs = 0;
+      line >> nPairs;
+      for (size_t i = 0; i < nPairs && std::getline(in, text); ++i) {
+        std::istringstream pairLine(text);
+        int a = 0, b = 0;
+        PairWeights weights;
+        pairLine >> a >> b >> weights.weight.sum >> weights.weight.sum2 >> weights.gatedWeight.sum >> weights.gatedWeight.sum2;
+        // 겹침 가중치가 없는 이전 형식: 창 밖에서 함께 트리거된 이벤트가 없다고 봅니다.
+        if (!(pairLine >> weights.overlapWeight.sum >> weights.overlapWeight.sum2)) weights.overlapWeight = weights.weight;
+        counters.pairWeights[{a, b}] = weights;
+      }
+    }
+  }
+  if (!counters.hasWeights) {
+    counters.singlesWeight = UnitWeights(counters.singles);
+    counters.gatedSinglesWeight = UnitWeights(counters.gatedSingles);
+    for (const auto& entry : counters.pairs) {
+      PairWeights& weights = counters.pairWeights[entry.first];
+      weights.weight.sum = weights.weight.sum2 = static_cast<double>(entry.second.first);
+      weights.gatedWeight.sum = weights.gatedWeight.sum2 = static_cast<double>(entry.second.second);
+      weights.overlapWeight = weights.weight;
+    }
+  }
+  return !counters.output.empty() && !counters.settings.empty();
+}
+
+void AddTo(std::vector<long>& sum, const std::vector<long>& values)
+{
+  if (sum.size() < values.size()) sum.resize(values.size(), 0);
+  for (size_t i = 0; i < values.size(); ++i) sum[i] += values[i];
+}
+
+void AddTo(std::vector<WeightSum>& sum, const std::vector<WeightSum>& values)
+{
+  if (sum.size() < values.size()) sum.resize(values.size());
+  for (size_t i = 0; i < values.size(); ++i) sum[i].Add(values[i]);
+}
+
+// 모든 shard가 같은 런에 속하고 [0, shardCount)가 한 번씩 있는지 확인한 뒤 카운터를 합칩니다.
+bool MergeCounters(const std::vector<ShardCounters>& shards, ShardCounters& merged)
+{
+  const ShardCounters& first = shards.front();
+  std::set<int> seen;
+  for (const auto& shard : shards) {
+    if (shard.runSeed != first.runSeed || shard.totalEvents != first.totalEvents
+        || shard.shardCount != first.shardCount || shard.settings != first.settings
+        || shard.distance != first.distance || shard.unitAngles != first.unitAngles) {
+      std::cerr << "cpnr_merge: " << shard.output << " belongs to a different run "
+                << "(run seed, events, shard count, coincidence settings or geometry differ)." << std::endl;
+      return false;
+    }
+    if (!seen.insert(shard.shardIndex).second) {
+      std::cerr << "cpnr_merge: shard " << shard.shardIndex << " is listed twice." << std::endl;
+      return false;
+    }
+  }
+  if (static_cast<int>(seen.size()) != first.shardCount) {
+    std::cerr << "cpnr_merge: missing shards:";
+    for (int i = 0; i < first.shardCount; ++i) {
+      if (!seen.count(i)) std::cerr << " " << i;
+    }
+    std::cerr << std::endl;
+    return false;
+  }
+
+  merged = ShardCounters();
+  merged.runSeed = first.runSeed;
+  merged.totalEvents = first.totalEvents;
+  merged.distance = first.distance;
+  merged.unitAngles = first.unitAngles;
+  merged.settings = first.settings;
+  for (const auto& shard : shards) {
+    merged.events += shard.events;
+    AddTo(merged.photonKills, shard.photonKills);
+    AddTo(merged.photonKillSteps, shard.photonKillSteps);
+    merged.opticalSteps += shard.opticalSteps;
+    merged.triggerAccepted += shard.triggerAccepted;
+    merged.triggerRejected += shard.triggerRejected;
+    merged.stackingAccepted += shard.stackingAccepted;
+    merged.stackingRejected += shard.stackingRejected;
+    AddTo(merged.singles, shard.singles);
+    AddTo(merged.gatedSingles, shard.gatedSingles);
+    for (const auto& entry : shard.pairs) {
+      auto& sum = merged.pairs[entry.first];
+      sum.first += entry.second.first;
+      sum.second += entry.second.second;
+    }
+    AddTo(merged.singlesWeight, shard.singlesWeight);
+    AddTo(merged.gatedSinglesWeight, shard.gatedSinglesWeight);
+    for (const auto& entry : shard.pairWeights) {
+      auto& sum = merged.pairWeights[entry.first];
+      sum.weight.Add(entry.second.weight);
+      sum.gatedWeight.Add(entry.second.gatedWeight);
+      sum.overlapWeight.Add(entry.second.overlapWeight);
+    }
+  }
+  if (merged.events != merged.totalEvents) {
+    std::cerr << "cpnr_merge: shards processed " << merged.events << " events, but the run has "
+              << merged.totalEvents << " (a shard did not finish)." << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// 병합 결과를 한 shard(0/1)짜리 카운터 파일로 씁니다. 다시 cpnr_merge의 입력으로 쓸 수 있습니다.
+bool WriteCounters(const std::string& fileName, const ShardCounters& counters)
+{
+  std::ofstream out(fileName);
+  out << "# CPNR shard counters (merged)\n";
+  out << "runSeed " << counters.runSeed << "\n";
+  out << "totalEvents " << counters.totalEvents << "\n";
+  out << "shardIndex 0\nshardCount 1\nfirstEvent 0\n";
+  out << "output " << counters.output << "\n";
+  out << "distance_cm " << counters.distance << "\n";
+  out << "unitAngles_deg " << counters.unitAngles << "\n";
+  out << "settings " << counters.settings << "\n";
+  out << "events " << counters.events << "\n";
+  out << "photonKills";
+  for (auto value : counters.photonKills) out << " " << value;
+  out << "\nphotonKillSteps";
+  for (auto value : counters.photonKillSteps) out << " " << value;
+  out << "\nopticalSteps " << counters.opticalSteps << "\n";
+  out << "trigger " << counters.triggerAccepted << " " << counters.triggerRejected << "\n";
+  out << "stacking " << counters.stackingAccepted << " " << counters.stackingRejected << "\n";
+  out << "singles " << counters.singles.size();
+  for (auto value : counters.singles) out << " " << value;
+  out << "\ngatedSingles " << counters.gatedSingles.size();
+  for (auto value : counters.gatedSingles) out << " " << value;
+  out << "\npairs " << counters.pairs.size() << "\n";
+  for (const auto& entry : counters.pairs) {
+    out << entry.first.first << " " << entry.first.second << " "
+        << entry.second.first << " " << entry.second.second << "\n";
+  }
+  out.precision(17);
+  auto writeWeights = [&out](const char* key, const std::vector<WeightSum>& sums) {
+    out << key << " " << sums.size();
+    for (const auto& sum : sums) out << " " << sum.sum << " " << sum.sum2;
+    out << "\n";
+  };
+  writeWeights("singlesWeight", counters.singlesWeight);
+  writeWeights("gatedSinglesWeight", counters.gatedSinglesWeight);
+  out << "pairWeights " << counters.pairWeights.size() << "\n";
+  for (const auto& entry : counters.pairWeights) {
+    out << entry.first.first << " " << entry.first.second << " "
+        << entry.second.weight.sum << " " << entry.second.weight.sum2 << " "
+        << entry.second.gatedWeight.sum << " " << entry.second.gatedWeight.sum2 << " "
+        << entry.second.overlapWeight.sum << " " << entry.second.overlapWeight.sum2 << "\n";
+  }
+  return static_cast<bool>(out);
+}
+
+// Run::PrintAngularCorrelation과 같은 형식의 W(theta) 줄을 출력합니다.
+void PrintAngularCorrelation(const ShardCounters& counters)
+{
+  std::istringstream angleLine(counters.unitAngles);
+  size_t nUnits = 0;
+  angleLine >> nUnits;
+  std::vector<double> angles(nUnits, 0.);
+  for (auto& angle : angles) angleLine >> angle;
+
+  const double n = static_cast<double>(counters.events);
+  auto singlesOf = [&counters](int pmt) {
+    return (pmt >= 0 && pmt < static_cast<int>(counters.singles.size())) ? counters.singles[pmt] : 0L;
+  };
+  auto weightOf = [&counters](int pmt) {
+    return (pmt >= 0 && pmt < static_cast<int>(counters.singlesWeight.size())) ? counters.singlesWeight[pmt] : WeightSum();
+  };
+  // W = N·C/(S_a·S_b)의 상대 분산: C ⊂ S_a ∩ S_b의 공분산을 넣어 전파합니다. (Run.cc의 WRelativeVariance와 같은 식)
+  auto wRelativeVariance = [n](const WeightSum& c, const WeightSum& a, const WeightSum& b, const WeightSum& overlap) {
+    return std::max(0., c.sum2 / (c.sum * c.sum) + a.sum2 / (a.sum * a.sum) + b.sum2 / (b.sum * b.sum)
+                        - 2. * c.sum2 / (c.sum * a.sum) - 2. * c.sum2 / (c.sum * b.sum)
+                        + 2. * overlap.sum2 / (a.sum * b.sum) - 1. / n);
+  };
+  for (const auto& entry : counters.pairs) {
+    const int a = entry.first.first;
+    const int b = entry.first.second;
+    const long coincidences = entry.second.first;
+    if (coincidences == 0) continue;  // 창 밖에서만 함께 트리거된 쌍
+    double angle = 0.;
+    if (a < static_cast<int>(nUnits) && b < static_cast<int>(nUnits)) {
+      const double pi = std::acos(-1.);
+      angle = std::acos(std::cos((angles[a] - angles[b]) * pi / 180.)) * 180. / pi;
+    }
+    const PairWeights pairWeights = counters.pairWeights.count(entry.first) ? counters.pairWeights.at(entry.first) : PairWeights();
+    const WeightSum& pairWeight = pairWeights.weight;
+    const double rate = pairWeight.Rate(counters.events);
+    const double rateError = pairWeight.RateError(counters.events);
+    const long singlesA = singlesOf(a);
+    const long singlesB = singlesOf(b);
+    const WeightSum weightA = weightOf(a);
+    const WeightSum weightB = weightOf(b);
+    double w = 0., wError = 0.;
+    if (pairWeight.sum > 0. && weightA.sum > 0. && weightB.sum > 0.) {
+      w = pairWeight.sum * n / (weightA.sum * weightB.sum);
+      wError = w * std::sqrt(wRelativeVariance(pairWeight, weightA, weightB, pairWeights.overlapWeight));
+    }
+    std::cout << "W(theta) pair=" << a << "-" << b << " angle_deg=" << angle << " distance_cm=" << counters.distance
+              << " events=" << counters.events << " singlesA=" << singlesA << " singlesB=" << singlesB
+              << " coincidences=" << coincidences << " rate=" << rate << " rateErr=" << rateError
+              << " W=" << w << " WErr=" << wError << std::endl;
+  }
+}
+
+// shard 출력 파일 이름: <이름>.root와 스레드별 파일(<이름>_t<n>.root)을 모두 모읍니다.
+// 스레드별 모드에서도 Master가 <이름>.root(Dictionary와 빈 Ntuple)를 쓰므로, 이벤트는 _t<n> 파일에만 있습니다.
+std::vector<std::string> ShardOutputFiles(const std::string& output)
+{
+  std::vector<std::string> files;
+  if (std::ifstream(output).good()) files.push_back(output);
+  const std::string base = output.substr(0, output.size() - 5);
+  for (int thread = 0;; ++thread) {
+    std::string name = base + "_t" + std::to_string(thread) + ".root";
+    if (!std::ifstream(name).good()) break;
+    files.push_back(name);
+  }
+  return files;
+}
+
+// 출력 파일을 UUID/날짜/파일 이름이 고정된 재현 가능한 형식으로 엽니다.
+std::string ReproducibleUrl(const std::string& fileName)
+{
+  std::string baseName = fileName.substr(fileName.find_last_of('/') + 1);
+  return fileName + "?reproducible=" + baseName;
+}
+
+// 모든 입력의 Dictionary TTree를 읽어 (코드 -> 이름)이 서로 모순되지 않는지 확인합니다.
+bool CheckDictionaries(const std::vector<std::string>& inputs)
+{
+  std::map<int, std::string> names;
+  for (const auto& input : inputs) {
+    std::unique_ptr<TFile> file(TFile::Open(input.c_str(), "READ"));
+    if (!file || file->IsZombie()) {
+      std::cerr << "cpnr_merge: cannot open " << input << std::endl;
+      return false;
+    }
+
+    auto tree = file->Get<TTree>("Dictionary");
+    if (!tree) continue;
+
+    int code = 0;
+    char name[256] = {0};
+    tree->SetBranchAddress("code", &code);
+    tree->SetBranchAddress("name", name);
+    for (Long64_t i = 0; i < tree->GetEntries(); ++i) {
+      tree->GetEntry(i);
+      auto it = names.emplace(code, name).first;
+      if (it->second != name) {
+        std::cerr << "cpnr_merge: name code " << code << " is '" << it->second << "' in earlier inputs but '"
+                  << name << "' in " << input << ".\n"
+                  << "            The inputs were produced with different physics lists or geometries, or a name first seen\n"
+                  << "            during the run got a different code; such files cannot be concatenated." << std::endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool MergeFiles(const std::vector<std::string>& inputs, const std::string& output, int compression)
+{
+  TFileMerger merger(false, false);
+  merger.SetPrintLevel(0);
+  merger.SetFastMethod(true);
+  if (!merger.OutputFile(ReproducibleUrl(output).c_str(), "RECREATE", compression)) return false;
+  for (const auto& input : inputs) {
+    if (!merger.AddFile(input.c_str(), false)) return false;
+  }
+  return merger.Merge();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  std::string output;
+  unsigned int nThreads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<std::string> inputs;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "-o" && i + 1 < argc) output = argv[++i];
+    else if (arg == "-j" && i + 1 < argc) nThreads = std::max(1, std::atoi(argv[++i]));
+    else if (arg == "-h" || arg == "--help") { PrintUsage(); return 0; }
+    else inputs.push_back(arg);
+  }
+  if (output.empty() || inputs.empty()) {
+    PrintUsage();
+    return 1;
+  }
+
+  // shard 카운터 입력: 카운터를 합치고, 적힌 출력 파일들을 병합 입력으로 바꿉니다.
+  // 합친 카운터는 출력 파일의 이름 사전까지 확인한 뒤에 쓰므로, 병합이 거부되면 아무 파일도 남지 않습니다.
+  std::unique_ptr<ShardCounters> merged;
+  size_t nShards = 0;
+  const std::string countersFile = (EndsWith(output, ".root") ? output.substr(0, output.size() - 5) : output) + ".counters";
+  auto writeMergedCounters = [&]() {
+    if (!WriteCounters(countersFile, *merged)) {
+      std::cerr << "cpnr_merge: cannot write " << countersFile << std::endl;
+      return false;
+    }
+    std::cout << "--> Merged counters of " << nShards << " shards (" << merged->events << " events) into "
+              << countersFile << std::endl;
+    PrintAngularCorrelation(*merged);
+    return true;
+  };
+
+  if (std::all_of(inputs.begin(), inputs.end(), [](const std::string& input) { return EndsWith(input, ".counters"); })) {
+    std::vector<ShardCounters> shards(inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      if (!ReadCounters(inputs[i], shards[i])) {
+        std::cerr << "cpnr_merge: cannot read shard counters " << inputs[i] << std::endl;
+        return 1;
+      }
+    }
+    merged.reset(new ShardCounters());
+    if (!MergeCounters(shards, *merged)) return 1;
+    merged->output = output;
+    nShards = shards.size();
+
+    inputs.clear();
+    for (const auto& shard : shards) {
+      if (!EndsWith(shard.output, ".root")) {
+        if (!writeMergedCounters()) return 1;
+        std::cerr << "cpnr_merge: " << shard.output << " is not a ROOT file; only the counters were merged." << std::endl;
+        return 0;
+      }
+      for (const auto& file : ShardOutputFiles(shard.output)) inputs.push_back(file);
+    }
+    if (inputs.empty()) {
+      std::cerr << "cpnr_merge: no shard output files found." << std::endl;
+      return 1;
+    }
+  }
+
+  // 명령행 순서와 무관하게 같은 입력이면 같은 결과가 나오도록 이름순으로 정렬합니다.
+  std::sort(inputs.begin(), inputs.end());
+  inputs.erase(std::unique(inputs.begin(), inputs.end()), inputs.end());
+  if (std::find(inputs.begin(), inputs.end(), output) != inputs.end()) {
+    std::cerr << "cpnr_merge: output file is also listed as an input." << std::endl;
+    return 1;
+  }
+
+  ROOT::EnableThreadSafety();
+  if (!CheckDictionaries(inputs)) return 1;
+
+  // basket을 그대로 복사하려면 출력의 압축 설정이 입력과 같아야 합니다.
+  int compression = 0;
+  {
+    std::unique_ptr<TFile> first(TFile::Open(inputs.front().c_str(), "READ"));
+    if (!first || first->IsZombie()) {
+      std::cerr << "cpnr_merge: cannot open " << inputs.front() << std::endl;
+      return 1;
+    }
+    compression = first->GetCompressionSettings();
+  }
+  if (merged && !writeMergedCounters()) return 1;
+
+  // 묶음마다 입력이 최소 2개가 되도록 스레드 수를 제한합니다.
+  const size_t nGroups = std::min<size_t>(nThreads, inputs.size() / 2);
+  if (nGroups <= 1) {
+    if (!MergeFiles(inputs, output, compression)) {
+      std::cerr << "cpnr_merge: merge failed." << std::endl;
+      return 1;
+    }
+    std::cout << "--> Merged " << inputs.size() << " files into " << output << std::endl;
+    return 0;
+  }
+
+  // 1단계: 이름순 입력을 연속된 묶음으로 나누어 병렬 부분 병합
+  std::vector<std::string> parts(nGroups);
+  std::vector<char> ok(nGroups, 0);
+  std::vector<std::thread> workers;
+  for (size_t g = 0; g < nGroups; ++g) {
+    size_t begin = inputs.size() * g / nGroups;
+    size_t end = inputs.size() * (g + 1) / nGroups;
+    parts[g] = output + ".part" + std::to_string(g);
+    workers.emplace_back([&, g, begin, end]() {
+      std::vector<std::string> group(inputs.begin() + begin, inputs.begin() + end);
+      ok[g] = MergeFiles(group, parts[g], compression);
+    });
+  }
+  for (auto& worker : workers) worker.join();
+
+  // 2단계: 부분 파일을 묶음 순서대로 최종 병합
+  bool success = std::all_of(ok.begin(), ok.end(), [](char value) { return value != 0; })
+              && MergeFiles(parts, output, compression);
+  for (const auto& part : parts) std::remove(part.c_str());
+
+  if (!success) {
+    std::cerr << "cpnr_merge: merge failed." << std::endl;
+    return 1;
+  }
+  std::cout << "--> Merged " << inputs.size() << " files into " << output
+            << " using " << nGroups << " threads" << std::endl;
+  return 0;
+}
@@ -0,0 +1,327 @@
+// cpnr_microbench.cc
+// 스텝/이벤트 단위 핫 패스(LSSD::ProcessHits, PMTSD::ProcessHits, EventAction::EndOfEventAction)의 마이크로벤치마크입니다.
+//
+// 사용법: cpnr_microbench [-n SD 호출 수] [-e 이벤트 호출 수] [-r 반복 횟수]
+//
+// - RunManager 없이 최소 지오메트리(World, 유닛 2개 x {LS, PMT/광음극})를 만들고, G4Navigator로 얻은 touchable을 붙인
+//   합성 G4Step들을 미리 만들어 둡니다. 스텝의 위치/에너지/트랙 번호는 고정 시드로 뽑으므로 실행마다 같습니다.
+// - LSSD/PMTSD는 이벤트마다(각 200 스텝 / 2000 광자) Initialize()로 버퍼와 컬렉션을 새로 시작하므로,
+//   결과에는 이벤트 경계의 비용(버퍼 비우기, Hit 삭제)이 호출 수로 나뉘어 포함됩니다.
+// - EndOfEventAction은 LSSD 버퍼(300 스텝)와 PMTHitsCollection(2000 Hit)을 한 번 채운 이벤트로 반복 호출하고,
+//   동기 출력 경로(G4 Ntuple, microbench.root)에 기록합니다. PMT 요약은 컬렉션을 제자리 정렬하므로
+//   두 번째 호출부터는 이미 정렬된 입력입니다.
+// - ns/call은 반복 중 가장 빠른 값, allocations/call은 전역 operator new 호출 수를 호출 수로 나눈 값입니다.
+//   (G4Allocator를 쓰는 PMTHit은 풀에서 받으므로 새 페이지가 필요할 때만 세어집니다.)
+
+#include "EventAction.hh"
+#include "LSSD.hh"
+#include "PMTHit.hh"
+#include "PMTSD.hh"
+#include "RunAction.hh"
+
+#include "G4AnalysisManager.hh"
+#include "G4Box.hh"
+#include "G4DynamicParticle.hh"
+#include "G4Electron.hh"
+#include "G4Event.hh"
+#include "G4GeometryManager.hh"
+#include "G4HCofThisEvent.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Material.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4Navigator.hh"
+#include "G4NistManager.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4PVPlacement.hh"
+#include "G4SDManager.hh"
+#include "G4Step.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4TouchableHistory.hh"
+#include "G4Track.hh"
+#include "G4UImanager.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <string>
+#include <vector>
+
+// --- 할당 계수: 전역 operator new를 바꾸어 호출 수를 셉니다. ---
+namespace {
+std::atomic<long> gAllocations{0};
+}
+
+void* operator new(std::size_t size)
+{
+  gAllocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+constexpr int kStepsPerEvent = 200;       // LSSD 벤치마크의 이벤트당 LS 스텝 수
+constexpr int kPhotonsPerEvent = 2000;    // PMTSD 벤치마크의 이벤트당 광음극 도달 광자 수
+constexpr int kEventSteps = 300;          // EndOfEventAction 벤치마크 이벤트의 LS 스텝 수
+constexpr int kEventPMTHits = 2000;       // EndOfEventAction 벤치마크 이벤트의 PMT Hit 수
+constexpr int kSyntheticSteps = 1024;     // 돌아가며 쓰는 합성 스텝 수
+
+struct Measurement {
+  double nsPerCall = std::numeric_limits<double>::max();
+  double allocationsPerCall = 0.;
+};
+
+// body()는 calls번의 호출을 수행합니다. 반복 중 가장 빠른 시간과 마지막 반복의 할당 수를 보고합니다.
+template <typename Body>
+Measurement Measure(Body&& body, long calls, int repeats)
+{
+  body();  // 예열: 버퍼 용량, 이름 코드 캐시, G4Allocator 풀을 채웁니다.
+  Measurement result;
+  for (int r = 0; r < repeats; ++r) {
+    const long allocationsBefore = gAllocations.load(std::memory_order_relaxed);
+    const auto start = std::chrono::steady_clock::now();
+    body();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.nsPerCall = std::min(result.nsPerCall, 1.e9 * seconds / calls);
+    result.allocationsPerCall =
+        static_cast<double>(gAllocations.load(std::memory_order_relaxed) - allocationsBefore) / calls;
+  }
+  return result;
+}
+
+void PrintMeasurement(const char* name, const Measurement& m)
+{
+  std::printf("  %-40s %10.1f ns/call %10.3f allocations/call\n", name, m.nsPerCall, m.allocationsPerCall);
+}
+
+// 최소 지오메트리: 유닛(copy number = 유닛 번호) 안에 LS와 PMT(광음극)를 두어, 실제 지오메트리와 같은
+// touchable 깊이(LS: 1 = 유닛, 광음극: 2 = 유닛)를 만듭니다.
+struct Geometry {
+  G4VPhysicalVolume* world = nullptr;
+  G4LogicalVolume* ls = nullptr;
+  G4LogicalVolume* photocathode = nullptr;
+  G4Material* lsMaterial = nullptr;
+  G4Material* cathodeMaterial = nullptr;
+};
+
+Geometry BuildGeometry()
+{
+  Geometry geometry;
+  auto nist = G4NistManager::Instance();
+  G4Material* vacuum = nist->FindOrBuildMaterial("G4_Galactic");
+
+  geometry.lsMaterial = nist->FindOrBuildMaterial("G4_TOLUENE");
+  auto lsMPT = new G4MaterialPropertiesTable();
+  lsMPT->AddProperty("BIRKSCONSTANT", {1.0*eV, 100.0*MeV}, {0.07943*mm/MeV, 0.07943*mm/MeV}, true);
+  lsMPT->AddConstProperty("SCINTILLATIONYIELD", 10000./MeV);
+  lsMPT->AddConstProperty("SCINTILLATIONTIMECONSTANT1", 10.*ns);
+  geometry.lsMaterial->SetMaterialPropertiesTable(lsMPT);
+
+  geometry.cathodeMaterial = nist->FindOrBuildMaterial("G4_Al");
+  auto cathodeMPT = new G4MaterialPropertiesTable();
+  cathodeMPT->AddProperty("EFFICIENCY", {1.9*eV, 2.7*eV, 4.1*eV}, {0.02, 0.24, 0.01});
+  geometry.cathodeMaterial->SetMaterialPropertiesTable(cathodeMPT);
+
+  auto worldLV = new G4LogicalVolume(new G4Box("World", 1.*m, 1.*m, 1.*m), vacuum, "LogicWorld");
+  geometry.world = new G4PVPlacement(nullptr, G4ThreeVector(), worldLV, "PhysWorld", nullptr, false, 0);
+
+  auto unitLV = new G4LogicalVolume(new G4Box("DetectorUnit", 5.*cm, 5.*cm, 10.*cm), vacuum, "LogicDetectorUnit");
+  geometry.ls = new G4LogicalVolume(new G4Box("LS", 4.*cm, 4.*cm, 4.*cm), geometry.lsMaterial, "LogicLS");
+  auto pmtLV = new G4LogicalVolume(new G4Box("PMT", 4.*cm, 4.*cm, 2.*cm), vacuum, "LogicPMT");
+  geometry.photocathode = new G4LogicalVolume(new G4Box("Photocathode", 4.*cm, 4.*cm, 1.*mm),
+                                              geometry.cathodeMaterial, "LogicPhotocathode");
+  new G4PVPlacement(nullptr, G4ThreeVector(0., 0., -4.*cm), geometry.ls, "PhysLS", unitLV, false, 0);
+  new G4PVPlacement(nullptr, G4ThreeVector(0., 0., 6.*cm), pmtLV, "PhysPMT", unitLV, false, 0);
+  new G4PVPlacement(nullptr, G4ThreeVector(0., 0., -1.9*cm), geometry.photocathode, "PhysPhotocathode", pmtLV, false, 0);
+  for (int unit = 0; unit < 2; ++unit) {
+    new G4PVPlacement(nullptr, G4ThreeVector((unit == 0 ? -20. : 20.)*cm, 0., 0.), unitLV, "PhysDetectorUnit",
+                      worldLV, false, unit);
+  }
+  G4GeometryManager::GetInstance()->CloseGeometry(false);
+  return geometry;
+}
+
+// 합성 스텝: 트랙과 pre/post 스텝 점을 직접 채웁니다. (트랙과 스텝은 프로그램 끝까지 유지)
+G4Step* MakeStep(G4Navigator& navigator, const G4ParticleDefinition* particle, const G4ThreeVector& position,
+                 G4double kineticEnergy, G4double energyDeposit, G4double stepLength, G4double time,
+                 G4int trackID, G4int parentID, G4StepStatus status)
+{
+  navigator.LocateGlobalPointAndSetup(position, nullptr, false, true);
+  G4TouchableHandle touchable(navigator.CreateTouchableHistory());
+
+  auto track = new G4Track(new G4DynamicParticle(particle, G4ThreeVector(0., 0., 1.), kineticEnergy), time, position);
+  track->SetTrackID(trackID);
+  track->SetParentID(parentID);
+  track->SetWeight(1.);
+  track->SetTouchableHandle(touchable);
+
+  auto step = new G4Step();
+  step->SetTrack(track);
+  track->SetStep(step);
+  step->SetTotalEnergyDeposit(energyDeposit);
+  step->SetStepLength(stepLength);
+
+  G4StepPoint* pre = step->GetPreStepPoint();
+  pre->SetPosition(position);
+  pre->SetGlobalTime(time);
+  pre->SetKineticEnergy(kineticEnergy);
+  pre->SetTouchableHandle(touchable);
+  pre->SetMaterial(touchable->GetVolume()->GetLogicalVolume()->GetMaterial());
+  pre->SetStepStatus(status);
+
+  G4StepPoint* post = step->GetPostStepPoint();
+  post->SetPosition(position + G4ThreeVector(0., 0., stepLength));
+  post->SetGlobalTime(time + stepLength / c_light);
+  post->SetKineticEnergy(kineticEnergy - energyDeposit);
+  post->SetTouchableHandle(touchable);
+  return step;
+}
+
+G4ThreeVector RandomPointIn(G4int unit, G4double z, G4double halfXY)
+{
+  return G4ThreeVector((unit == 0 ? -20. : 20.)*cm + halfXY * (2. * G4UniformRand() - 1.),
+                       halfXY * (2. * G4UniformRand() - 1.), z);
+}
+
+// LS 안의 전자 스텝 (두 유닛에 번갈아, 트랙 번호는 이벤트 안에서 겹치도록 작은 범위에서 뽑음)
+std::vector<G4Step*> MakeLSSteps(G4Navigator& navigator, int count)
+{
+  std::vector<G4Step*> steps;
+  for (int i = 0; i < count; ++i) {
+    const G4int unit = i % 2;
+    const G4double kineticEnergy = (0.01 + 1.2 * G4UniformRand()) * MeV;
+    steps.push_back(MakeStep(navigator, G4Electron::Definition(), RandomPointIn(unit, -4.*cm, 3.5*cm),
+                             kineticEnergy, kineticEnergy * 0.1 * G4UniformRand(), 0.5*mm * G4UniformRand(),
+                             (1. + 5. * G4UniformRand()) * ns, 1 + static_cast<G4int>(40 * G4UniformRand()),
+                             i % 7 == 0 ? 0 : 1, fGeomBoundary));
+  }
+  return steps;
+}
+
+// 광음극 경계에 도달한 광학 광자 스텝
+std::vector<G4Step*> MakePhotonSteps(G4Navigator& navigator, int count)
+{
+  std::vector<G4Step*> steps;
+  for (int i = 0; i < count; ++i) {
+    const G4int unit = i % 2;
+    steps.push_back(MakeStep(navigator, G4OpticalPhoton::Definition(), RandomPointIn(unit, 4.1*cm, 3.5*cm),
+                             (2.0 + 1.5 * G4UniformRand()) * eV, 0., 0., (2. + 20. * G4UniformRand()) * ns,
+                             100 + i, 1, fGeomBoundary));
+  }
+  return steps;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  long sdCalls = 1000000;
+  long eventCalls = 1000;
+  int repeats = 5;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "-n" && i + 1 < argc) sdCalls = std::max(1L, std::atol(argv[++i]));
+    else if (arg == "-e" && i + 1 < argc) eventCalls = std::max(1L, std::atol(argv[++i]));
+    else if (arg == "-r" && i + 1 < argc) repeats = std::max(1, std::atoi(argv[++i]));
+    else {
+      std::fprintf(stderr, "Usage: cpnr_microbench [-n sdCalls] [-e eventCalls] [-r repeats]\n");
+      return 1;
+    }
+  }
+  // 이벤트 단위로 나누어 떨어지게 맞춥니다.
+  const long lsEvents = std::max(1L, sdCalls / kStepsPerEvent);
+  const long photonEvents = std::max(1L, sdCalls / kPhotonsPerEvent);
+
+  CLHEP::HepRandom::setTheSeed(12345);
+  Geometry geometry = BuildGeometry();
+  G4Navigator navigator;
+  navigator.SetWorldVolume(geometry.world);
+
+  auto sdManager = G4SDManager::GetSDMpointer();
+  auto lssd = new LSSD("LSSD");
+  auto pmtsd = new PMTSD("PMTSD");
+  sdManager->AddNewDetector(lssd);
+  sdManager->AddNewDetector(pmtsd);
+  const G4int capacity = sdManager->GetCollectionCapacity();
+
+  const std::vector<G4Step*> lsSteps = MakeLSSteps(navigator, kSyntheticSteps);
+  const std::vector<G4Step*> photonSteps = MakePhotonSteps(navigator, kSyntheticSteps);
+
+  std::printf("Microbenchmarks (best of %d, %ld LS steps, %ld photons, %ld events)\n",
+              repeats, lsEvents * kStepsPerEvent, photonEvents * kPhotonsPerEvent, eventCalls);
+
+  // --- LSSD::ProcessHits ---
+  Measurement lssdResult = Measure([&]() {
+    size_t next = 0;
+    for (long event = 0; event < lsEvents; ++event) {
+      lssd->Initialize(nullptr);
+      for (int i = 0; i < kStepsPerEvent; ++i) {
+        lssd->ProcessHits(lsSteps[next], nullptr);
+        next = (next + 1) % lsSteps.size();
+      }
+    }
+  }, lsEvents * kStepsPerEvent, repeats);
+  PrintMeasurement("LSSD::ProcessHits", lssdResult);
+
+  // --- PMTSD::ProcessHits (QE 판정으로 일부만 Hit이 됨) ---
+  Measurement pmtsdResult = Measure([&]() {
+    size_t next = 0;
+    for (long event = 0; event < photonEvents; ++event) {
+      auto hce = new G4HCofThisEvent(capacity);
+      pmtsd->Initialize(hce);
+      for (int i = 0; i < kPhotonsPerEvent; ++i) {
+        pmtsd->ProcessHits(photonSteps[next], nullptr);
+        next = (next + 1) % photonSteps.size();
+      }
+      delete hce;  // 컬렉션과 Hit을 함께 삭제합니다.
+    }
+  }, photonEvents * kPhotonsPerEvent, repeats);
+  PrintMeasurement("PMTSD::ProcessHits", pmtsdResult);
+
+  // --- EventAction::EndOfEventAction (동기 G4 Ntuple 경로) ---
+  auto runAction = new RunAction();
+  auto eventAction = new EventAction(runAction);
+  auto analysisManager = G4AnalysisManager::Instance();
+  analysisManager->SetVerboseLevel(0);
+  analysisManager->OpenFile("microbench.root");
+
+  auto event = new G4Event(0);
+  auto hce = new G4HCofThisEvent(capacity);
+  event->SetHCofThisEvent(hce);
+  lssd->Initialize(hce);
+  for (int i = 0; i < kEventSteps; ++i) lssd->ProcessHits(lsSteps[i % lsSteps.size()], nullptr);
+  pmtsd->Initialize(hce);
+  for (int i = 0; i < kEventPMTHits; ++i) {
+    pmtsd->RecordHit(i % 2, 2. + 30. * G4UniformRand(), 1.);
+  }
+
+  auto ui = G4UImanager::GetUIpointer();
+  struct OutputCase { const char* name; const char* writeSteps; const char* pmtOutput; };
+  const OutputCase cases[] = {
+    {"EndOfEventAction (steps + PMT hits)", "true", "hits"},
+    {"EndOfEventAction (summary only)", "false", "summary"},
+  };
+  for (const auto& outputCase : cases) {
+    ui->ApplyCommand(std::string("/myApp/output/writeSteps ") + outputCase.writeSteps);
+    ui->ApplyCommand(std::string("/myApp/output/pmtOutput ") + outputCase.pmtOutput);
+    Measurement eventResult = Measure([&]() {
+      for (long i = 0; i < eventCalls; ++i) eventAction->EndOfEventAction(event);
+    }, eventCalls, repeats);
+    PrintMeasurement(outputCase.name, eventResult);
+  }
+
+  analysisManager->Write();
+  analysisManager->CloseFile();
+
+  delete event;
+  delete eventAction;
+  delete runAction;
+  return 0;
+}